@@ -25,6 +25,15 @@ please contact mla_licensing@microchip.com
 
 #include "usb.h"
 #include "usb_device_midi.h"
+#include "usb_config.h"
+
+#include "app_device_audio_midi.h"
+#include "app_device_cdc_basic.h"
+#include "midi_port.h"
+#include "midi_router.h"
+#include "cycle_counter.h"
+#include "bridge_stats.h"
+#include "scheduler.h"
 
 /** VARIABLES ******************************************************/
 /* Some processors have a limited range of RAM addresses where the USB module
@@ -35,34 +44,55 @@ please contact mla_licensing@microchip.com
 #if defined(FIXED_ADDRESS_MEMORY)
     #if defined(COMPILER_MPLAB_C18)
         #pragma udata DEVICE_AUDIO_MIDI_RX_DATA_BUFFER=DEVCE_AUDIO_MIDI_RX_DATA_BUFFER_ADDRESS
-            static uint8_t ReceivedDataBuffer[64];
-        #pragma udata DEVICE_AUDIO_MIDI_EVENT_DATA_BUFFER=DEVCE_AUDIO_MIDI_EVENT_DATA_BUFFER_ADDRESS
-            static USB_AUDIO_MIDI_EVENT_PACKET midiData;
+            static uint8_t ReceivedDataBuffer[2][64];
+        #pragma udata DEVICE_AUDIO_MIDI_TX_DATA_BUFFER=DEVCE_AUDIO_MIDI_TX_DATA_BUFFER_ADDRESS
+            static uint8_t TransmitDataBuffer[2][64];
         #pragma udata
     #elif defined(__XC8)
-        static uint8_t ReceivedDataBuffer[64] @ DEVCE_AUDIO_MIDI_RX_DATA_BUFFER_ADDRESS;
-        static USB_AUDIO_MIDI_EVENT_PACKET midiData @ DEVCE_AUDIO_MIDI_EVENT_DATA_BUFFER_ADDRESS;
+        static uint8_t ReceivedDataBuffer[2][64] @ DEVCE_AUDIO_MIDI_RX_DATA_BUFFER_ADDRESS;
+        static uint8_t TransmitDataBuffer[2][64] @ DEVCE_AUDIO_MIDI_TX_DATA_BUFFER_ADDRESS;
     #endif
 #else
-    static uint8_t ReceivedDataBuffer[64];
-    static USB_AUDIO_MIDI_EVENT_PACKET midiData;
+    static uint8_t ReceivedDataBuffer[2][64];
+    static uint8_t TransmitDataBuffer[2][64];
 #endif
 
-static USB_HANDLE USBTxHandle;
-static USB_HANDLE USBRxHandle;
+#define MIDI_EVENTS_PER_PACKET  (sizeof(TransmitDataBuffer[0]) / sizeof(USB_AUDIO_MIDI_EVENT_PACKET))
+
+/* The two transmit buffers go alternately to the EVEN and ODD IN BDTs of the
+ * endpoint, so one can be filled while the other one is on the bus. */
+static USB_HANDLE USBTxHandle[2];
+static uint8_t txBuffer;
+/* Both receive buffers stay armed on the EVEN and ODD OUT BDTs, the host can
+ * send the next packet while the previous one is being queued.  The SIE
+ * fills them alternately, rxBuffer is the one it completes first. */
+static USB_HANDLE USBRxHandle[2];
+static uint8_t rxBuffer;
 
-extern uint8_t readBuffer[CDC_DATA_OUT_EP_SIZE];
-extern uint8_t writeBuffer[CDC_DATA_IN_EP_SIZE];
+/* Events received from the host on the MIDI OUT endpoint, bound for CDC */
+MIDI_PORT midiOutPort;
+/* Events bound for the host on the MIDI IN endpoint, received from CDC */
+MIDI_PORT midiInPort;
 
+static USB_AUDIO_MIDI_EVENT_PACKET midiData;
 static uint8_t pitch;
 static bool sentNoteOff;
-bool midiTX;
-bool midiRX;
 
 static USB_VOLATILE uint16_t msCounter;
 
+/* Frames left before the events waiting for the MIDI IN endpoint have to be
+ * sent, counted down from the SOF interrupt while flushPending is set. */
+static USB_VOLATILE uint8_t flushFrames;
+static bool flushPending;
+
 extern volatile uint16_t blinkTime;
 
+/** PRIVATE PROTOTYPES *********************************************/
+#if defined(BRIDGE_TRANSFER_EVENTS)
+static void APP_DeviceAudioMIDIOutComplete(void *context);
+static void APP_DeviceAudioMIDIInComplete(void *context);
+#endif
+
 /*********************************************************************
 * Function: void APP_DeviceAudioMIDIInitialize(void);
 *
@@ -77,23 +107,86 @@ extern volatile uint16_t blinkTime;
 ********************************************************************/
 void APP_DeviceAudioMIDIInitialize()
 {
-    USBTxHandle = NULL;
-    USBRxHandle = NULL;
+    USBTxHandle[0] = NULL;
+    USBTxHandle[1] = NULL;
+    txBuffer = 0;
+    USBRxHandle[0] = NULL;
+    USBRxHandle[1] = NULL;
+    rxBuffer = 0;
 
     pitch = 0x3C;
     sentNoteOff = true;
-    midiTX = false;
-    midiRX = false;
+
+    MIDI_PORT_Initialize(&midiOutPort);
+    MIDI_PORT_Initialize(&midiInPort);
+    MIDI_PORT_SetResidency(&midiOutPort, &residencyStats[RESIDENCY_TO_CDC]);
+    MIDI_PORT_SetResidency(&midiInPort, &residencyStats[RESIDENCY_TO_MIDI]);
 
     msCounter = 0;
 
+    flushFrames = 0;
+    flushPending = false;
+
     //enable the HID endpoint
     USBEnableEndpoint(AUDIO_MIDI_EP,USB_OUT_ENABLED|USB_IN_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
 
-    //Re-arm the OUT endpoint for the next packet
-    USBRxHandle = USBRxOnePacket(AUDIO_MIDI_EP,(uint8_t*)&ReceivedDataBuffer,64);
+    //Arm both OUT buffers for the first packets
+    USBRxHandle[0] = USBRxOnePacket(AUDIO_MIDI_EP,ReceivedDataBuffer[0],64);
+    USBRxHandle[1] = USBRxOnePacket(AUDIO_MIDI_EP,ReceivedDataBuffer[1],64);
+
+    #if defined(BRIDGE_TRANSFER_EVENTS)
+        USBDeviceSetTransferCallback(AUDIO_MIDI_EP, OUT_FROM_HOST, APP_DeviceAudioMIDIOutComplete, NULL);
+        USBDeviceSetTransferCallback(AUDIO_MIDI_EP, IN_TO_HOST, APP_DeviceAudioMIDIInComplete, NULL);
+    #endif
 }
 
+#if defined(BRIDGE_TRANSFER_EVENTS)
+/*********************************************************************
+* Function: static void APP_DeviceAudioMIDIOutComplete(void *context);
+*
+* Overview: Called by the stack when a packet has been received on the
+*   MIDI OUT endpoint.  Queues its events and hands them straight to the
+*   CDC IN endpoint.
+*
+* PreCondition: None
+*
+* Input: void *context - not used
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceAudioMIDIOutComplete(void *context)
+{
+    (void)context;
+
+    APP_DeviceAudioMIDIReceive();
+    APP_DeviceCDCBasicDemoSend();
+    CDCTxService();
+}
+
+/*********************************************************************
+* Function: static void APP_DeviceAudioMIDIInComplete(void *context);
+*
+* Overview: Called by the stack when a packet has been sent on the MIDI IN
+*   endpoint.  Loads the next packet, and takes in the CDC data that was
+*   waiting for room in midiInPort.
+*
+* PreCondition: None
+*
+* Input: void *context - not used
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceAudioMIDIInComplete(void *context)
+{
+    (void)context;
+
+    APP_DeviceAudioMIDISend();
+    APP_DeviceCDCBasicDemoReceive();
+}
+#endif
+
 /*********************************************************************
 * Function: void APP_DeviceAudioMIDIInitialize(void);
 *
@@ -112,6 +205,26 @@ void APP_DeviceAudioMIDISOFHandler()
     {
         msCounter--;
     }
+
+    if(flushFrames != 0)
+    {
+        flushFrames--;
+    }
+
+    #if defined(BRIDGE_SCHEDULER)
+        /* The button is sampled on frame boundaries: a note is due once the
+         * debounce time is over and the button no longer matches the last
+         * note sent.  Without BRIDGE_TRANSFER_EVENTS the events waiting for
+         * the MIDI IN endpoint are also due once their deadline expires. */
+        if( ((msCounter == 0) && (BUTTON_IsPressed(BUTTON_DEVICE_AUDIO_MIDI) == sentNoteOff))
+            #if !defined(BRIDGE_TRANSFER_EVENTS)
+            || ((flushPending == true) && (flushFrames == 0))
+            #endif
+          )
+        {
+            SCHEDULER_SetReady(SCHEDULER_TASK_MIDI);
+        }
+    #endif
 }
 
 
@@ -131,8 +244,6 @@ void APP_DeviceAudioMIDISOFHandler()
 ********************************************************************/
 void APP_DeviceAudioMIDITasks()
 {
-     uint8_t numBytesRead;
-    
     /* If the device is not configured yet, or the device is suspended, then
      * we don't need to run the demo since we can't send any data.
      */
@@ -142,48 +253,18 @@ void APP_DeviceAudioMIDITasks()
         return;
     }
 
-    if(!USBHandleBusy(USBRxHandle))
-    {
-        //We have received a MIDI packet from the host, process it and then
-        //  prepare to receive the next packet
-
-        if( midiData.DATA_2 > 0 ) {             // velocity
-            blinkTime = (0x4A - midiData.DATA_1) * 10;    // pitch * 10
-        } else {
-            blinkTime = 0;
-        }
-        
-        if( midiTX == false ) {
-            writeBuffer[0] = midiData.v[0];
-            writeBuffer[1] = midiData.v[1];
-            writeBuffer[2] = midiData.v[2];
-            writeBuffer[3] = midiData.v[3];
-
-            midiTX = true;
-        }
-        
-        //Get ready for next packet (this will overwrite the old data)
-        USBRxHandle = USBRxOnePacket(AUDIO_MIDI_EP,(uint8_t*)&ReceivedDataBuffer,64);
-    }  
-
-    if( midiRX == true )
-    {
-        /* and we aren't currently trying to transmit data... */
-        if(!USBHandleBusy(USBTxHandle))
-        {
-            midiData.Val = 0;   //must set all unused values to 0 so go ahead
-                                //  and set them all to 0
-            midiData.v[0] = readBuffer[0];
-            midiData.v[1] = readBuffer[1];
-            midiData.v[2] = readBuffer[2];
-            midiData.v[3] = readBuffer[3];
+    //With BRIDGE_TRANSFER_EVENTS the endpoints are serviced from their
+    //  transfer complete callbacks instead
+    #if !defined(BRIDGE_TRANSFER_EVENTS)
+        APP_DeviceAudioMIDIReceive();
+        APP_DeviceAudioMIDISend();
+    #endif
 
-            midiRX = false;
+    //The CDC OUT transfer complete callback also queues events on midiInPort
+    #if defined(BRIDGE_TRANSFER_EVENTS)
+        USBMaskInterrupts();
+    #endif
 
-            USBTxHandle = USBTxOnePacket(AUDIO_MIDI_EP,(uint8_t*)&midiData,4);
-        }
-    }
-    
     /* If the user button is pressed... */
     if(BUTTON_IsPressed(BUTTON_DEVICE_AUDIO_MIDI) == true)
     {
@@ -193,8 +274,8 @@ void APP_DeviceAudioMIDITasks()
             /* and we have sent the NOTE_OFF for the last note... */
             if(sentNoteOff == true)
             {
-                /* and we aren't currently trying to transmit data... */
-                if(!USBHandleBusy(USBTxHandle))
+                /* and there is room to queue the note... */
+                if(MIDI_PORT_Free(&midiInPort, 0) != 0)
                 {
                     //Then reset the 1000ms counter
                     msCounter = 100;
@@ -208,7 +289,8 @@ void APP_DeviceAudioMIDITasks()
                     midiData.DATA_1 = pitch;        //pitch
                     midiData.DATA_2 = 0x7F;         //velocity
 
-                    USBTxHandle = USBTxOnePacket(AUDIO_MIDI_EP,(uint8_t*)&midiData,4);
+                    MIDI_PORT_Put(&midiInPort, &midiData);
+                    bridgeStats.toMidi.eventsIn++;
                     /* we now need to send the NOTE_OFF for this note. */
                     sentNoteOff = false;
                 }
@@ -221,7 +303,7 @@ void APP_DeviceAudioMIDITasks()
         {
             if(sentNoteOff == false)
             {
-                if(!USBHandleBusy(USBTxHandle))
+                if(MIDI_PORT_Free(&midiInPort, 0) != 0)
                 {
                     //Debounce counter for 100ms
                     msCounter = 100;
@@ -240,10 +322,222 @@ void APP_DeviceAudioMIDITasks()
                         pitch = 0x3C;
                     }
 
-                    USBTxHandle = USBTxOnePacket(AUDIO_MIDI_EP,(uint8_t*)&midiData,4);         
+                    MIDI_PORT_Put(&midiInPort, &midiData);
+                    bridgeStats.toMidi.eventsIn++;
                     sentNoteOff = true;
                 }
             }
         }
     } 
+
+    #if defined(BRIDGE_TRANSFER_EVENTS)
+        USBUnmaskInterrupts();
+    #endif
+}
+
+/*********************************************************************
+* Function: void APP_DeviceAudioMIDIReceive(void);
+*
+* Overview: Moves the events of the last packet received on the MIDI OUT
+*   endpoint to the queues towards the CDC side, and re-arms the endpoint
+*   once they are all queued.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceAudioMIDIReceive(void)
+{
+    uint8_t numBytesRead;
+    uint16_t depth;
+    uint8_t i;
+    P_USB_AUDIO_MIDI_EVENT_PACKET event;
+    bool routed;
+
+    /* Only take a received packet once the queues towards the CDC side have
+     * room for all of its events.  Until then its buffer stays busy, and once
+     * the other one is full too the host is NAKed, so no events are lost
+     * while the serial side catches up.  Packets are taken in the order the
+     * SIE filled the buffers. */
+    while(!USBHandleBusy(USBRxHandle[rxBuffer]))
+    {
+        numBytesRead = (uint8_t)USBHandleGetLength(USBRxHandle[rxBuffer]) & ~0x03;
+
+        if(MIDI_PORT_HasRoom(&midiOutPort, ReceivedDataBuffer[rxBuffer], numBytesRead) == false)
+        {
+            break;
+        }
+
+        //We have received a MIDI packet from the host, process it and then
+        //  give the buffer back for the next packet
+        bridgeStats.toCdc.bytesIn += numBytesRead;
+
+        /* A bulk transfer may carry up to 16 event packets (a chord, a
+         * burst of CCs...), forward all of them. */
+        for(i = 0; i < numBytesRead; i += sizeof(USB_AUDIO_MIDI_EVENT_PACKET))
+        {
+            event = (P_USB_AUDIO_MIDI_EVENT_PACKET)&ReceivedDataBuffer[rxBuffer][i];
+
+            //Skip the zero padding some hosts append after the last event
+            if(event->Val == 0)
+            {
+                continue;
+            }
+
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_MIDI_OUT_ROUTE);
+            routed = MIDI_ROUTER_Route(MIDI_ROUTER_TO_CDC, event);
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_MIDI_OUT_ROUTE);
+
+            if(routed == false)
+            {
+                continue;
+            }
+
+            if(event->CodeIndexNumber == MIDI_CIN_NOTE_ON)
+            {
+                if( event->DATA_2 > 0 ) {             // velocity
+                    blinkTime = (0x4A - event->DATA_1) * 10;    // pitch * 10
+                } else {
+                    blinkTime = 0;
+                }
+            }
+
+            if(MIDI_PORT_Put(&midiOutPort, event) == true)
+            {
+                bridgeStats.toCdc.eventsIn++;
+            }
+            else
+            {
+                bridgeStats.toCdc.drops++;
+            }
+        }
+        depth = MIDI_PORT_Count(&midiOutPort);
+        BRIDGE_STATS_Depth(bridgeStats.toCdc, depth);
+
+        //The CDC task sends them, with BRIDGE_TRANSFER_EVENTS the callbacks do
+        #if !defined(BRIDGE_TRANSFER_EVENTS)
+            SCHEDULER_SetReady(SCHEDULER_TASK_CDC);
+        #endif
+
+        //Get ready for next packet (this will overwrite the old data)
+        USBRxHandle[rxBuffer] = USBRxOnePacket(AUDIO_MIDI_EP,ReceivedDataBuffer[rxBuffer],64);
+        rxBuffer ^= 1;
+    }
+}
+
+/*********************************************************************
+* Function: void APP_DeviceAudioMIDISend(void);
+*
+* Overview: Sends the events queued from the CDC side on the MIDI IN
+*   endpoint, once a packet is full or its deadline has expired.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceAudioMIDISend(void)
+{
+    uint8_t numBytesRead;
+
+    /* Events received from the CDC side are coalesced into one packet until
+     * it is full or until the deadline started by the first of them expires,
+     * trading at most BRIDGE_MIDI_IN_FLUSH_FRAMES of latency for up to 16
+     * times fewer transactions under dense traffic.
+     */
+    if((flushPending == false) && !MIDI_PORT_IsEmpty(&midiInPort))
+    {
+        flushFrames = BRIDGE_MIDI_IN_FLUSH_FRAMES;
+        flushPending = true;
+    }
+
+    /* Even past the deadline, while a SysEx dump is streamed and the previous
+     * packet is still on the bus there is no hurry, so the events are left to
+     * pile up until a whole packet can be sent.  A dump then takes as few
+     * transactions as possible.
+     */
+    if((flushPending == true) && !USBHandleBusy(USBTxHandle[txBuffer]))
+    {
+        if( (MIDI_PORT_Count(&midiInPort) >= MIDI_EVENTS_PER_PACKET) ||
+            ( (flushFrames == 0) &&
+              ( !USBHandleBusy(USBTxHandle[txBuffer ^ 1]) ||
+                (MIDI_PORT_IsSysExOpen(&midiInPort) == false) ) )
+            #if defined(BRIDGE_MIDI_IN_REALTIME_BYPASS)
+            || (MIDI_PORT_HasRealtime(&midiInPort) == true)
+            #endif
+          )
+        {
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_MIDI_IN_COPY);
+
+            numBytesRead = MIDI_PORT_Read(&midiInPort, TransmitDataBuffer[txBuffer], MIDI_EVENTS_PER_PACKET);
+
+            USBTxHandle[txBuffer] = USBTxOnePacket(AUDIO_MIDI_EP,TransmitDataBuffer[txBuffer],numBytesRead);
+            txBuffer ^= 1;
+
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_MIDI_IN_COPY);
+
+            bridgeStats.toMidi.bytesOut += numBytesRead;
+            bridgeStats.toMidi.eventsOut += numBytesRead / sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+
+            //The CDC data waiting for room in midiInPort can be taken in
+            #if !defined(BRIDGE_TRANSFER_EVENTS)
+                SCHEDULER_SetReady(SCHEDULER_TASK_CDC);
+            #endif
+
+            //Events left over from a full packet keep the current deadline
+            if(MIDI_PORT_IsEmpty(&midiInPort))
+            {
+                flushPending = false;
+            }
+        }
+    }
+    else if(flushPending == true)
+    {
+        bridgeStats.toMidi.busySpins++;
+    }
+}
+
+/*********************************************************************
+* Function: USB_HANDLE APP_DeviceAudioMIDIForward(uint8_t *packet,
+*                                                 uint8_t length);
+*
+* Overview: Sends a packet of USB-MIDI events to the host straight from
+*   the buffer it sits in, without copying it.
+*
+* PreCondition: The buffer is in USB RAM and is left untouched until the
+*   returned handle is no longer busy.  No event waits in midiInPort,
+*   otherwise the packet would overtake it.
+*
+* Input: uint8_t *packet - the events to send
+*        uint8_t length - size of the packet in bytes, a multiple of 4
+*
+* Output: handle of the IN transfer, NULL if no IN buffer of the endpoint
+*   is free at the moment
+*
+********************************************************************/
+USB_HANDLE APP_DeviceAudioMIDIForward(uint8_t *packet, uint8_t length)
+{
+    USB_HANDLE handle;
+
+    if(USBHandleBusy(USBTxHandle[txBuffer]))
+    {
+        return NULL;
+    }
+
+    /* The BDT is simply pointed at the caller's buffer.  It takes the place
+     * of the transmit buffer in the ping-pong sequence, so the packets still
+     * reach the host in order. */
+    handle = USBTxOnePacket(AUDIO_MIDI_EP,packet,length);
+    USBTxHandle[txBuffer] = handle;
+    txBuffer ^= 1;
+
+    bridgeStats.toMidi.bytesOut += length;
+    bridgeStats.toMidi.eventsOut += length / sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+
+    return handle;
 }
@@ -17,6 +17,17 @@ To request to license the code under the MLA license (www.microchip.com/mla_lice
 please contact mla_licensing@microchip.com
 *******************************************************************************/
 
+#ifndef APP_DEVICE_AUDIO_MIDI_H
+#define APP_DEVICE_AUDIO_MIDI_H
+
+#include "usb.h"
+#include "midi_port.h"
+
+/* Events received from the host on the MIDI OUT endpoint, bound for CDC */
+extern MIDI_PORT midiOutPort;
+/* Events bound for the host on the MIDI IN endpoint, received from CDC */
+extern MIDI_PORT midiInPort;
+
 /*********************************************************************
 * Function: void APP_DeviceAudioMIDIInitialize(void);
 *
@@ -47,6 +58,40 @@ void APP_DeviceAudioMIDIInitialize();
 ********************************************************************/
 void APP_DeviceAudioMIDITasks();
 
+/*********************************************************************
+* Function: void APP_DeviceAudioMIDIReceive(void);
+*
+* Overview: Moves the events of the last packet received on the MIDI OUT
+*   endpoint to the queues towards the CDC side, and re-arms the endpoint
+*   once they are all queued.  Called by APP_DeviceAudioMIDITasks(), or
+*   from the transfer complete callbacks with BRIDGE_TRANSFER_EVENTS.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceAudioMIDIReceive(void);
+
+/*********************************************************************
+* Function: void APP_DeviceAudioMIDISend(void);
+*
+* Overview: Sends the events queued from the CDC side on the MIDI IN
+*   endpoint, once a packet is full or its deadline has expired.  Called
+*   by APP_DeviceAudioMIDITasks(), or from the transfer complete callbacks
+*   and the SOF event with BRIDGE_TRANSFER_EVENTS.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceAudioMIDISend(void);
+
 /*********************************************************************
 * Function: void APP_DeviceAudioMIDISOFHandler(void);
 *
@@ -62,3 +107,25 @@ void APP_DeviceAudioMIDITasks();
 *
 ********************************************************************/
 void APP_DeviceAudioMIDISOFHandler();
+
+/*********************************************************************
+* Function: USB_HANDLE APP_DeviceAudioMIDIForward(uint8_t *packet,
+*                                                 uint8_t length);
+*
+* Overview: Sends a packet of USB-MIDI events to the host straight from
+*   the buffer it sits in, without copying it.
+*
+* PreCondition: The buffer is in USB RAM and is left untouched until the
+*   returned handle is no longer busy.  No event waits in midiInPort,
+*   otherwise the packet would overtake it.
+*
+* Input: uint8_t *packet - the events to send
+*        uint8_t length - size of the packet in bytes, a multiple of 4
+*
+* Output: handle of the IN transfer, NULL if no IN buffer of the endpoint
+*   is free at the moment
+*
+********************************************************************/
+USB_HANDLE APP_DeviceAudioMIDIForward(uint8_t *packet, uint8_t length);
+
+#endif
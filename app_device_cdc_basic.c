@@ -28,17 +28,84 @@ please contact mla_licensing@microchip.com
 
 #include "app_led_usb_status.h"
 #include "app_device_cdc_basic.h"
+#include "app_device_audio_midi.h"
+#include "midi_port.h"
+#include "midi_parser.h"
+#include "midi_encoder.h"
+#include "midi_router.h"
+#include "cycle_counter.h"
+#include "bridge_stats.h"
+#include "scheduler.h"
 #include "usb_config.h"
 
+#if defined(BRIDGE_ZERO_COPY) && defined(BRIDGE_CDC_RAW_MIDI)
+    #error "BRIDGE_ZERO_COPY needs the CDC port to carry USB-MIDI event packets."
+#endif
+
+#if defined(BRIDGE_CDC_IN_DIRECT) && defined(CDC_TX_RING_SIZE)
+    #error "BRIDGE_CDC_IN_DIRECT and CDC_TX_RING_SIZE are alternatives, define only one of them."
+#endif
+
 /** VARIABLES ******************************************************/
 
+/* Number of queued events that make up a whole CDC packet */
+#if defined(BRIDGE_CDC_RAW_MIDI)
+    #define WRITE_EVENTS_PER_PACKET     (CDC_DATA_IN_EP_SIZE / MIDI_ENCODER_MAX_LENGTH)
+#else
+    #define WRITE_EVENTS_PER_PACKET     (CDC_DATA_IN_EP_SIZE / sizeof(USB_AUDIO_MIDI_EVENT_PACKET))
+#endif
+
 static bool buttonPressed;
 static char buttonMessage[] = "Button pressed.\r\n";
-volatile uint8_t readBuffer[CDC_DATA_OUT_EP_SIZE];
-volatile uint8_t writeBuffer[CDC_DATA_IN_EP_SIZE];
+#if !defined(BRIDGE_CDC_OUT_PEEK)
+    static uint8_t readBuffer[CDC_DATA_OUT_EP_SIZE];
+#endif
+static uint8_t *readData;       //chunk being parsed, readBuffer or the CDC OUT buffer
+static uint8_t readLength;
+static uint8_t readIndex;
+#if defined(BRIDGE_CDC_IN_DIRECT)
+    /* Sent by the CDC IN endpoint as it is, so it has to be in USB RAM */
+    #if defined(FIXED_ADDRESS_MEMORY)
+        #if defined(COMPILER_MPLAB_C18)
+            #pragma udata DEVICE_CDC_TX_DATA_BUFFER=DEVCE_CDC_TX_DATA_BUFFER_ADDRESS
+                static uint8_t writeBuffer[2 * CDC_DATA_IN_EP_SIZE];
+            #pragma udata
+        #elif defined(__XC8)
+            static uint8_t writeBuffer[2 * CDC_DATA_IN_EP_SIZE] @ DEVCE_CDC_TX_DATA_BUFFER_ADDRESS;
+        #endif
+    #else
+        static uint8_t writeBuffer[2 * CDC_DATA_IN_EP_SIZE];
+    #endif
+#else
+    static uint8_t writeBuffer[CDC_DATA_IN_EP_SIZE];
+#endif
+
+static USB_AUDIO_MIDI_EVENT_PACKET readEvent;
+#if defined(BRIDGE_CDC_RAW_MIDI)
+    static MIDI_PARSER midiParser;
+    static MIDI_ENCODER midiEncoder;
+    static USB_AUDIO_MIDI_EVENT_PACKET writeEvent;
+#else
+    static uint8_t readEventLength;
+#endif
+
+#if defined(BRIDGE_ZERO_COPY)
+    /* CDC OUT packet lent to the MIDI IN endpoint */
+    static USB_HANDLE forwardHandle;
+    static uint8_t forwardLength;
+#endif
 
-extern bool midiTX;
-extern bool midiRX;
+/** PRIVATE PROTOTYPES *********************************************/
+static uint8_t APP_DeviceCDCBasicDemoEncode(void);
+#if defined(BRIDGE_TRANSFER_EVENTS)
+static void APP_DeviceCDCBasicDemoOutComplete(void *context);
+static void APP_DeviceCDCBasicDemoInComplete(void *context);
+#elif defined(BRIDGE_SCHEDULER)
+static void APP_DeviceCDCBasicDemoInReady(void *context);
+#endif
+#if defined(BRIDGE_ZERO_COPY)
+static bool APP_DeviceCDCBasicDemoIsForwardable(const uint8_t *packet, uint8_t length);
+#endif
 
 /*********************************************************************
 * Function: void APP_DeviceCDCBasicDemoInitialize(void);
@@ -60,7 +127,103 @@ void APP_DeviceCDCBasicDemoInitialize()
     line_coding.dwDTERate = 9600;
 
     buttonPressed = false;
+
+    readLength = 0;
+    readIndex = 0;
+    #if defined(BRIDGE_CDC_OUT_PEEK)
+        readData = NULL;
+    #else
+        readData = readBuffer;
+    #endif
+
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        MIDI_PARSER_Initialize(&midiParser, 0);
+        MIDI_ENCODER_Initialize(&midiEncoder);
+    #else
+        readEventLength = 0;
+    #endif
+
+    #if defined(BRIDGE_ZERO_COPY)
+        forwardHandle = NULL;
+        forwardLength = 0;
+    #endif
+
+    #if defined(BRIDGE_TRANSFER_EVENTS)
+        CDCSetRxCallback(APP_DeviceCDCBasicDemoOutComplete, NULL);
+        CDCSetTxCallback(APP_DeviceCDCBasicDemoInComplete, NULL);
+    #elif defined(BRIDGE_SCHEDULER)
+        CDCSetTxCallback(APP_DeviceCDCBasicDemoInReady, NULL);
+    #endif
+}
+
+#if !defined(BRIDGE_TRANSFER_EVENTS) && defined(BRIDGE_SCHEDULER)
+/*********************************************************************
+* Function: static void APP_DeviceCDCBasicDemoInReady(void *context);
+*
+* Overview: Called by the CDC driver once a packet has been sent on the
+*   CDC IN endpoint, marks the task ready to load the next one.
+*
+* PreCondition: None
+*
+* Input: void *context - not used
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceCDCBasicDemoInReady(void *context)
+{
+    (void)context;
+
+    SCHEDULER_SetReady(SCHEDULER_TASK_CDC);
+}
+#endif
+
+#if defined(BRIDGE_TRANSFER_EVENTS)
+/*********************************************************************
+* Function: static void APP_DeviceCDCBasicDemoOutComplete(void *context);
+*
+* Overview: Called by the CDC driver when a packet has been received on the
+*   CDC OUT endpoint.  Queues its events and hands them straight to the
+*   MIDI IN endpoint.
+*
+* PreCondition: None
+*
+* Input: void *context - not used
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceCDCBasicDemoOutComplete(void *context)
+{
+    (void)context;
+
+    APP_DeviceCDCBasicDemoReceive();
+    APP_DeviceAudioMIDISend();
+}
+
+/*********************************************************************
+* Function: static void APP_DeviceCDCBasicDemoInComplete(void *context);
+*
+* Overview: Called by the CDC driver once CDCTxService() has run for a
+*   packet sent on the CDC IN endpoint.  Starts the next transfer, and takes
+*   in the MIDI data that was waiting for room in midiOutPort.
+*
+* PreCondition: None
+*
+* Input: void *context - not used
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceCDCBasicDemoInComplete(void *context)
+{
+    (void)context;
+
+    APP_DeviceCDCBasicDemoSend();
+    CDCTxService();
+    APP_DeviceAudioMIDIReceive();
 }
+#endif
 
 /*********************************************************************
 * Function: void APP_DeviceCDCBasicDemoTasks(void);
@@ -78,8 +241,6 @@ void APP_DeviceCDCBasicDemoInitialize()
 ********************************************************************/
 void APP_DeviceCDCBasicDemoTasks()
 {
-    uint8_t numBytesRead = 0;
-    
     /* If the USB device isn't configured yet, we can't really do anything
      * else since we don't have a host to talk to.  So jump back to the
      * top of the while loop. */
@@ -97,36 +258,342 @@ void APP_DeviceCDCBasicDemoTasks()
         return;
     }
 
+    //With BRIDGE_TRANSFER_EVENTS the endpoints are serviced from their
+    //  transfer complete callbacks instead
+    #if !defined(BRIDGE_TRANSFER_EVENTS)
+        APP_DeviceCDCBasicDemoSend();
+        APP_DeviceCDCBasicDemoReceive();
+
+        CDCTxService();
+    #endif
+}
+
+/*********************************************************************
+* Function: void APP_DeviceCDCBasicDemoSend(void);
+*
+* Overview: Hands the events queued from the MIDI side to the CDC IN
+*   endpoint.  CDCTxService() has to be called afterwards to load them.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceCDCBasicDemoSend(void)
+{
+    uint8_t numBytesWritten = 0;
+
+    #if defined(CDC_TX_RING_SIZE)
+    /* The events are written to the CDC transmit ring as long as a whole
+     * packet of them fits, while the previous ones are still on the bus.
+     * The ring merges them in full packets, so a SysEx dump needs no
+     * holding back.
+     */
+    while( !MIDI_PORT_IsEmpty(&midiOutPort) && (CDCWriteFree() >= sizeof(writeBuffer)) )
+    {
+        numBytesWritten = APP_DeviceCDCBasicDemoEncode();
+        CDCWrite(writeBuffer, numBytesWritten);
+        bridgeStats.toCdc.bytesOut += numBytesWritten;
+    }
+
+    if( numBytesWritten != 0 )
+    {
+        //The MIDI data waiting for room in midiOutPort can be taken in
+        #if !defined(BRIDGE_TRANSFER_EVENTS)
+            SCHEDULER_SetReady(SCHEDULER_TASK_MIDI);
+        #endif
+    }
 
-    /* Check to see if there is a transmission in progress, if there isn't, then
-     * we can see about performing an echo response to data received.
+    if( !MIDI_PORT_IsEmpty(&midiOutPort) )
+    {
+        bridgeStats.toCdc.busySpins++;
+    }
+    #else
+    /* Check to see if there is a free transmit buffer, if there is, then
+     * send every event received from the MIDI side so far in one transfer.
+     * As on the MIDI side, a SysEx dump is held back while the previous
+     * packet is on the bus until a whole packet can be filled, unless a
+     * realtime message has to go out in front of it.
      */
-    if( midiTX == true )
+    if( (USBUSARTIsTxTrfReady() == true) && !MIDI_PORT_IsEmpty(&midiOutPort) &&
+        ( (USBUSARTIsTxOnBus() == false) ||
+          (MIDI_PORT_Count(&midiOutPort) >= WRITE_EVENTS_PER_PACKET) ||
+          (MIDI_PORT_IsSysExOpen(&midiOutPort) == false) ||
+          (MIDI_PORT_HasRealtime(&midiOutPort) == true) ) )
     {
-        if( USBUSARTIsTxTrfReady() == true ) {
-            putUSBUSART(writeBuffer, 4);
-            midiTX = false;
+        numBytesWritten = APP_DeviceCDCBasicDemoEncode();
+
+        if( numBytesWritten != 0 )
+        {
+            #if defined(BRIDGE_CDC_IN_DIRECT)
+                CDCSendDirect(writeBuffer, numBytesWritten);
+            #else
+                putUSBUSART(writeBuffer, numBytesWritten);
+            #endif
+            bridgeStats.toCdc.bytesOut += numBytesWritten;
+
+            //The MIDI data waiting for room in midiOutPort can be taken in
+            #if !defined(BRIDGE_TRANSFER_EVENTS)
+                SCHEDULER_SetReady(SCHEDULER_TASK_MIDI);
+            #endif
         }
     }
-           
-    if( USBUSARTIsTxTrfReady() == true ) {
-        numBytesRead = getsUSBUSART(readBuffer, sizeof(readBuffer));
+    else if( (USBUSARTIsTxTrfReady() == false) && !MIDI_PORT_IsEmpty(&midiOutPort) )
+    {
+        bridgeStats.toCdc.busySpins++;
+    }
+    #endif
+}
+
+/*********************************************************************
+* Function: static uint8_t APP_DeviceCDCBasicDemoEncode(void);
+*
+* Overview: Takes out of midiOutPort the events that fit in writeBuffer,
+*   in the format of the CDC port.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint8_t - number of bytes written to writeBuffer
+*
+********************************************************************/
+static uint8_t APP_DeviceCDCBasicDemoEncode(void)
+{
+    uint8_t numBytesWritten = 0;
+
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        /* Events of every cable are merged in the byte stream.  Keep
+         * encoding while a complete message is sure to fit. */
+        while( (numBytesWritten <= (sizeof(writeBuffer) - MIDI_ENCODER_MAX_LENGTH)) &&
+               (MIDI_PORT_Get(&midiOutPort, &writeEvent) == true) )
+        {
+            numBytesWritten += MIDI_ENCODER_Encode(&midiEncoder, &writeEvent, &writeBuffer[numBytesWritten]);
+            bridgeStats.toCdc.eventsOut++;
+        }
+    #else
+        numBytesWritten = MIDI_PORT_Read(&midiOutPort, writeBuffer,
+                            sizeof(writeBuffer) / sizeof(USB_AUDIO_MIDI_EVENT_PACKET));
+        bridgeStats.toCdc.eventsOut += numBytesWritten / sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+    #endif
+
+    return numBytesWritten;
+}
+
+/*********************************************************************
+* Function: void APP_DeviceCDCBasicDemoReceive(void);
+*
+* Overview: Moves the data received on the CDC OUT endpoint to the
+*   queues towards the MIDI side, fetching the next packet once the
+*   previous one has been completely queued.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceCDCBasicDemoReceive(void)
+{
+    uint8_t readStart;
+    uint16_t depth;
+    bool fetch = true;
+    #if defined(BRIDGE_ZERO_COPY)
+        uint8_t *forwardPacket;
+    #endif
 
-        if( numBytesRead >= 4 )
+    #if defined(BRIDGE_ZERO_COPY)
+        /* The CDC OUT buffer only goes back to the CDC endpoint once the
+         * host has read it from the MIDI IN endpoint. */
+        if( forwardHandle != NULL )
         {
-            midiRX = true;
-            
-            // Echo
-            /*
-            writeBuffer[0] = readBuffer[0];
-            writeBuffer[1] = readBuffer[1];
-            writeBuffer[2] = readBuffer[2];
-            writeBuffer[3] = readBuffer[3];
-            
-            putUSBUSART(writeBuffer, 4);
-            */
+            if( USBHandleBusy(forwardHandle) )
+            {
+                fetch = false;
+            }
+            else
+            {
+                CDCConsume(forwardLength);
+                forwardHandle = NULL;
+            }
         }
+
+        /* A packet made of whole events of valid cables is sent as it is when
+         * nothing has to go out before it and no routing rule has to be
+         * applied.  Otherwise it takes the copy path below, which keeps the
+         * events in order behind the queued ones and drops the events of
+         * cables the bridge does not have. */
+        if( fetch && (readIndex == readLength) && (readEventLength == 0) &&
+            MIDI_PORT_IsEmpty(&midiInPort) && MIDI_ROUTER_IsPassThrough(MIDI_ROUTER_TO_MIDI) )
+        {
+            forwardLength = CDCPeek(&forwardPacket);
+            if( APP_DeviceCDCBasicDemoIsForwardable(forwardPacket, forwardLength) )
+            {
+                //Until the MIDI IN endpoint has a free buffer, wait for it
+                //  rather than copying the packet
+                CYCLE_COUNTER_Enter(CYCLE_COUNTER_CDC_OUT_FORWARD);
+                forwardHandle = APP_DeviceAudioMIDIForward(forwardPacket, forwardLength);
+                CYCLE_COUNTER_Exit(CYCLE_COUNTER_CDC_OUT_FORWARD);
+                fetch = false;
+
+                if( forwardHandle != NULL )
+                {
+                    bridgeStats.toMidi.bytesIn += forwardLength;
+                    bridgeStats.toMidi.eventsIn += forwardLength / sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+                }
+                else
+                {
+                    bridgeStats.toMidi.busySpins++;
+                }
+            }
+        }
+    #endif
+
+    /* Fetch the next chunk from the host once the previous one has been
+     * completely handed over to the MIDI side.  Until then the host is NAKed,
+     * so nothing is dropped when the queue towards the MIDI side is full.
+     */
+    if( fetch && (readIndex == readLength) )
+    {
+        CYCLE_COUNTER_Enter(CYCLE_COUNTER_CDC_OUT_COPY);
+
+        #if defined(BRIDGE_CDC_OUT_PEEK)
+            //The chunk is parsed where the SIE wrote it, and each byte is
+            //  released as soon as it is queued
+            readLength = CDCPeek(&readData);
+        #else
+            readLength = getsUSBUSART(readBuffer, sizeof(readBuffer));
+        #endif
+        readIndex = 0;
+
+        bridgeStats.toMidi.bytesIn += readLength;
     }
-    
-    CDCTxService();
-}
\ No newline at end of file
+    else
+    {
+        fetch = false;
+    }
+
+    /* Every byte completes at most one event, so only consume a byte while
+     * the queue of the event it may complete has room for it: the queue of
+     * its cable, or the realtime lane for a realtime message.  Messages split
+     * across chunks are completed with the bytes of the next chunk.
+     */
+    readStart = readIndex;
+    while( readIndex < readLength )
+    {
+        #if defined(BRIDGE_CDC_RAW_MIDI)
+            //The raw MIDI stream goes to cable 0
+            if( ((readData[readIndex] >= 0xF8) && (MIDI_PORT_FreeRealtime(&midiInPort) == 0)) ||
+                ((readData[readIndex] < 0xF8) && (MIDI_PORT_Free(&midiInPort, 0) == 0)) )
+            {
+                break;
+            }
+
+            if( (MIDI_PARSER_Parse(&midiParser, readData[readIndex++], &readEvent) == true) &&
+                (MIDI_ROUTER_Route(MIDI_ROUTER_TO_MIDI, &readEvent) == true) )
+            {
+                if( MIDI_PORT_Put(&midiInPort, &readEvent) == true )
+                {
+                    bridgeStats.toMidi.eventsIn++;
+                }
+                else
+                {
+                    bridgeStats.toMidi.drops++;
+                }
+            }
+        #else
+            //The first bytes of an event packet are held in readEvent, only
+            //  the last one needs room in the queue the event goes to
+            if( (readEventLength == (sizeof(USB_AUDIO_MIDI_EVENT_PACKET) - 1)) &&
+                (MIDI_PORT_HasRoom(&midiInPort, readEvent.v, sizeof(USB_AUDIO_MIDI_EVENT_PACKET)) == false) )
+            {
+                break;
+            }
+
+            readEvent.v[readEventLength++] = readData[readIndex++];
+            if( readEventLength == sizeof(USB_AUDIO_MIDI_EVENT_PACKET) )
+            {
+                //Skip the zero padding some hosts append after the last event
+                if( (readEvent.Val != 0) &&
+                    (MIDI_ROUTER_Route(MIDI_ROUTER_TO_MIDI, &readEvent) == true) )
+                {
+                    if( MIDI_PORT_Put(&midiInPort, &readEvent) == true )
+                    {
+                        bridgeStats.toMidi.eventsIn++;
+                    }
+                    else
+                    {
+                        bridgeStats.toMidi.drops++;
+                    }
+                }
+                readEventLength = 0;
+            }
+        #endif
+    }
+
+    if( readIndex != readStart )
+    {
+        #if defined(BRIDGE_CDC_OUT_PEEK)
+            //The buffer goes back to the endpoint with its last byte
+            CDCConsume(readIndex - readStart);
+        #endif
+
+        depth = MIDI_PORT_Count(&midiInPort);
+        BRIDGE_STATS_Depth(bridgeStats.toMidi, depth);
+
+        //The MIDI task sends them, with BRIDGE_TRANSFER_EVENTS the callbacks do
+        #if !defined(BRIDGE_TRANSFER_EVENTS)
+            SCHEDULER_SetReady(SCHEDULER_TASK_MIDI);
+        #endif
+    }
+
+    if( fetch && (readLength != 0) )
+    {
+        CYCLE_COUNTER_Exit(CYCLE_COUNTER_CDC_OUT_COPY);
+    }
+}
+
+#if defined(BRIDGE_ZERO_COPY)
+/*********************************************************************
+* Function: static bool APP_DeviceCDCBasicDemoIsForwardable(
+*               const uint8_t *packet, uint8_t length);
+*
+* Overview: Checks if a CDC OUT packet can be lent to the MIDI IN
+*   endpoint as it is: it holds whole event packets, and all of them are
+*   for cables of the bridge.
+*
+* PreCondition: None
+*
+* Input: packet - the CDC OUT packet
+*        length - its length, 0 if there is none
+*
+* Output: bool - true if the packet can be forwarded
+*
+********************************************************************/
+static bool APP_DeviceCDCBasicDemoIsForwardable(const uint8_t *packet, uint8_t length)
+{
+    if( (length == 0) || ((length & 0x03) != 0) )
+    {
+        return false;
+    }
+
+    #if BRIDGE_NUM_CABLES < 16
+    {
+        uint8_t i;
+
+        for( i = 0; i < length; i += sizeof(USB_AUDIO_MIDI_EVENT_PACKET) )
+        {
+            if( (packet[i] >> 4) >= BRIDGE_NUM_CABLES )
+            {
+                return false;
+            }
+        }
+    }
+    #endif
+
+    return true;
+}
+#endif
@@ -55,6 +55,41 @@ void APP_DeviceCDCBasicDemoInitialize();
 ********************************************************************/
 void APP_DeviceCDCBasicDemoTasks();
 
+/*********************************************************************
+* Function: void APP_DeviceCDCBasicDemoSend(void);
+*
+* Overview: Hands the events queued from the MIDI side to the CDC IN
+*   endpoint.  CDCTxService() has to be called afterwards to load them.
+*   Called by APP_DeviceCDCBasicDemoTasks(), or from the transfer
+*   complete callbacks with BRIDGE_TRANSFER_EVENTS.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceCDCBasicDemoSend(void);
+
+/*********************************************************************
+* Function: void APP_DeviceCDCBasicDemoReceive(void);
+*
+* Overview: Moves the data received on the CDC OUT endpoint to the
+*   queues towards the MIDI side, fetching the next packet once the
+*   previous one has been completely queued.  Called by
+*   APP_DeviceCDCBasicDemoTasks(), or from the transfer complete
+*   callbacks with BRIDGE_TRANSFER_EVENTS.
+*
+* PreCondition: The device is configured
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceCDCBasicDemoReceive(void);
+
 
 #endif
 
@@ -0,0 +1,372 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "usb.h"
+
+#include "app_device_vendor.h"
+#include "bridge_stats.h"
+#include "copy_bench.h"
+#include "cycle_counter.h"
+#include "midi_router.h"
+#include "residency.h"
+#include "scheduler.h"
+
+/** CONSTANTS ******************************************************/
+/* Statistics to clear on the next APP_DeviceVendorTasks() */
+#define VENDOR_CLEAR_BRIDGE_STATS   0x01
+#define VENDOR_CLEAR_CYCLE_COUNTER  0x02
+#define VENDOR_CLEAR_SCHEDULER      0x04
+#define VENDOR_CLEAR_RESIDENCY      0x08
+
+/** VARIABLES ******************************************************/
+extern volatile CTRL_TRF_SETUP SetupPkt;    //Setup packet of the current request
+
+static MIDI_ROUTER_RULE vendorRule;
+
+/* The statistics are updated by the main loop and by the USB interrupt.
+ * A read request copies them here with the interrupt masked, in the main
+ * loop, and the data stage is sent from the copy. */
+static union
+{
+    BRIDGE_STATS bridgeStats;
+    #if defined(BRIDGE_RESIDENCY)
+    RESIDENCY_STATS residencyStats[RESIDENCY_DIRECTIONS];
+    #endif
+    #if defined(BRIDGE_CYCLE_COUNT)
+    CYCLE_COUNTER_STATS cycleCounterStats[CYCLE_COUNTER_SECTIONS];
+    COPY_BENCH_STATS copyBenchStats[COPY_BENCH_PATHS];
+    #endif
+    #if defined(BRIDGE_SCHEDULER)
+    SCHEDULER_STATS schedulerStats[SCHEDULER_TASKS];
+    #endif
+} vendorSnapshot;
+
+static volatile uint8_t vendorRead;     //read request waiting for its data stage, 0 if none
+static volatile uint8_t vendorClear;    //VENDOR_CLEAR_xxx bits
+#if defined(BRIDGE_CYCLE_COUNT)
+static volatile bool vendorCopyBench;   //VENDOR_REQUEST_COPY_BENCH_RUN received
+#endif
+
+/** PRIVATE PROTOTYPES *********************************************/
+static void APP_DeviceVendorAddRule(void);
+static void APP_DeviceVendorDeferRead(void);
+static void APP_DeviceVendorDeferClear(uint8_t clear);
+
+/*********************************************************************
+* Function: void APP_DeviceVendorCheckRequest(void);
+*
+* Overview: Handles the vendor specific control requests used to
+*   configure the bridge. Must be called from the EVENT_EP0_REQUEST
+*   event handler.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceVendorCheckRequest(void)
+{
+    //Only requests addressed to the device are handled here, anything else
+    //  is left to the class drivers
+    if(SetupPkt.RequestType != USB_SETUP_TYPE_VENDOR_BITFIELD) return;
+    if(SetupPkt.Recipient != USB_SETUP_RECIPIENT_DEVICE_BITFIELD) return;
+
+    switch(SetupPkt.bRequest)
+    {
+        case VENDOR_REQUEST_ROUTER_CLEAR:
+            if(SetupPkt.wLength == 0)
+            {
+                MIDI_ROUTER_Initialize();
+                //Complete the status stage
+                inPipes[0].info.bits.busy = 1;
+            }
+            break;
+
+        case VENDOR_REQUEST_ROUTER_ADD_RULE:
+            if( (SetupPkt.DataDir == USB_SETUP_HOST_TO_DEVICE_BITFIELD) &&
+                (SetupPkt.wLength == sizeof(vendorRule)) )
+            {
+                USBEP0Receive((uint8_t*)&vendorRule, sizeof(vendorRule), APP_DeviceVendorAddRule);
+            }
+            break;
+
+        case VENDOR_REQUEST_BRIDGE_STATS_READ:
+            if(SetupPkt.DataDir == USB_SETUP_DEVICE_TO_HOST_BITFIELD)
+            {
+                APP_DeviceVendorDeferRead();
+            }
+            break;
+
+        case VENDOR_REQUEST_BRIDGE_STATS_CLEAR:
+            if(SetupPkt.wLength == 0)
+            {
+                APP_DeviceVendorDeferClear(VENDOR_CLEAR_BRIDGE_STATS);
+            }
+            break;
+
+        #if defined(BRIDGE_RESIDENCY)
+        case VENDOR_REQUEST_RESIDENCY_READ:
+            if(SetupPkt.DataDir == USB_SETUP_DEVICE_TO_HOST_BITFIELD)
+            {
+                APP_DeviceVendorDeferRead();
+            }
+            break;
+
+        case VENDOR_REQUEST_RESIDENCY_CLEAR:
+            if(SetupPkt.wLength == 0)
+            {
+                APP_DeviceVendorDeferClear(VENDOR_CLEAR_RESIDENCY);
+            }
+            break;
+        #endif
+
+        #if defined(BRIDGE_CYCLE_COUNT)
+        case VENDOR_REQUEST_CYCLE_COUNTER_READ:
+            //Sent in CYCLE_COUNTER_SECTION order, 8 bytes per section
+            if(SetupPkt.DataDir == USB_SETUP_DEVICE_TO_HOST_BITFIELD)
+            {
+                APP_DeviceVendorDeferRead();
+            }
+            break;
+
+        case VENDOR_REQUEST_CYCLE_COUNTER_CLEAR:
+            if(SetupPkt.wLength == 0)
+            {
+                APP_DeviceVendorDeferClear(VENDOR_CLEAR_CYCLE_COUNTER);
+            }
+            break;
+
+        case VENDOR_REQUEST_COPY_BENCH_RUN:
+            //The copies take about 3.5ms, too long for the interrupt, so
+            //  they are left to the main loop
+            if(SetupPkt.wLength == 0)
+            {
+                vendorCopyBench = true;
+                SCHEDULER_SetReady(SCHEDULER_TASK_VENDOR);
+
+                //Complete the status stage
+                inPipes[0].info.bits.busy = 1;
+            }
+            break;
+
+        case VENDOR_REQUEST_COPY_BENCH_READ:
+            //Sent in COPY_BENCH_PATH order, 10 bytes per path
+            if(SetupPkt.DataDir == USB_SETUP_DEVICE_TO_HOST_BITFIELD)
+            {
+                APP_DeviceVendorDeferRead();
+            }
+            break;
+        #endif
+
+        #if defined(BRIDGE_SCHEDULER)
+        case VENDOR_REQUEST_SCHEDULER_READ:
+            //Sent in SCHEDULER_TASK order, 6 bytes per task
+            if(SetupPkt.DataDir == USB_SETUP_DEVICE_TO_HOST_BITFIELD)
+            {
+                APP_DeviceVendorDeferRead();
+            }
+            break;
+
+        case VENDOR_REQUEST_SCHEDULER_CLEAR:
+            if(SetupPkt.wLength == 0)
+            {
+                APP_DeviceVendorDeferClear(VENDOR_CLEAR_SCHEDULER);
+            }
+            break;
+        #endif
+
+        default:
+            //Left unhandled, the request is stalled by the stack
+            break;
+    }
+}
+
+/*********************************************************************
+* Function: void APP_DeviceVendorTasks(void);
+*
+* Overview: Clears the statistics and sends the data stage of the read
+*   requests left by APP_DeviceVendorCheckRequest().  Must be called from
+*   the main loop.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceVendorTasks(void)
+{
+    uint16_t length = 0;
+
+    #if defined(BRIDGE_CYCLE_COUNT)
+    //COPY_BENCH_Run() only masks the interrupt during each measure, the
+    //  USB traffic is serviced in between.  A read request received before
+    //  the end of the run is answered below with the new results.
+    if(vendorCopyBench == true)
+    {
+        vendorCopyBench = false;
+        COPY_BENCH_Run();
+    }
+    #endif
+
+    //Neither the main loop tasks nor the interrupt can update the
+    //  statistics while they are cleared or copied
+    USBMaskInterrupts();
+
+    if((vendorClear & VENDOR_CLEAR_BRIDGE_STATS) != 0)
+    {
+        BRIDGE_STATS_Clear();
+    }
+    #if defined(BRIDGE_RESIDENCY)
+    if((vendorClear & VENDOR_CLEAR_RESIDENCY) != 0)
+    {
+        RESIDENCY_Clear();
+    }
+    #endif
+    #if defined(BRIDGE_CYCLE_COUNT)
+    if((vendorClear & VENDOR_CLEAR_CYCLE_COUNTER) != 0)
+    {
+        CYCLE_COUNTER_Clear();
+    }
+    #endif
+    #if defined(BRIDGE_SCHEDULER)
+    if((vendorClear & VENDOR_CLEAR_SCHEDULER) != 0)
+    {
+        SCHEDULER_Clear();
+    }
+    #endif
+    vendorClear = 0;
+
+    //A new setup packet cancels the deferred data stage of the previous one
+    if( (vendorRead != 0) && (USBINDataStageDeferred() == true) )
+    {
+        switch(vendorRead)
+        {
+            case VENDOR_REQUEST_BRIDGE_STATS_READ:
+                length = sizeof(bridgeStats);
+                memcpy(&vendorSnapshot.bridgeStats, &bridgeStats, length);
+                break;
+
+            #if defined(BRIDGE_RESIDENCY)
+            case VENDOR_REQUEST_RESIDENCY_READ:
+                length = sizeof(residencyStats);
+                memcpy(vendorSnapshot.residencyStats, residencyStats, length);
+                break;
+            #endif
+
+            #if defined(BRIDGE_CYCLE_COUNT)
+            case VENDOR_REQUEST_CYCLE_COUNTER_READ:
+                length = sizeof(cycleCounterStats);
+                memcpy(vendorSnapshot.cycleCounterStats, cycleCounterStats, length);
+                break;
+
+            case VENDOR_REQUEST_COPY_BENCH_READ:
+                length = sizeof(copyBenchStats);
+                memcpy(vendorSnapshot.copyBenchStats, copyBenchStats, length);
+                break;
+            #endif
+
+            #if defined(BRIDGE_SCHEDULER)
+            case VENDOR_REQUEST_SCHEDULER_READ:
+                length = sizeof(schedulerStats);
+                memcpy(vendorSnapshot.schedulerStats, schedulerStats, length);
+                break;
+            #endif
+
+            default:
+                break;
+        }
+
+        USBEP0SendRAMPtr((uint8_t*)&vendorSnapshot, length, USB_EP0_INCLUDE_ZERO);
+        USBCtrlEPAllowDataStage();
+    }
+    vendorRead = 0;
+
+    USBUnmaskInterrupts();
+}
+
+/*********************************************************************
+* Function: static void APP_DeviceVendorDeferRead(void);
+*
+* Overview: Holds the data stage of the current read request back until
+*   APP_DeviceVendorTasks() has taken a snapshot of the statistics.
+*
+* PreCondition: Called from APP_DeviceVendorCheckRequest()
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceVendorDeferRead(void)
+{
+    vendorRead = SetupPkt.bRequest;
+    USBDeferINDataStage();
+    SCHEDULER_SetReady(SCHEDULER_TASK_VENDOR);
+}
+
+/*********************************************************************
+* Function: static void APP_DeviceVendorDeferClear(uint8_t clear);
+*
+* Overview: Leaves the statistics to APP_DeviceVendorTasks() to clear and
+*   completes the status stage of the current clear request.  The clear
+*   is done before the data stage of the next read request is sent.
+*
+* PreCondition: Called from APP_DeviceVendorCheckRequest()
+*
+* Input: uint8_t clear - VENDOR_CLEAR_xxx bits
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceVendorDeferClear(uint8_t clear)
+{
+    vendorClear |= clear;
+    SCHEDULER_SetReady(SCHEDULER_TASK_VENDOR);
+
+    //Complete the status stage
+    inPipes[0].info.bits.busy = 1;
+}
+
+/*********************************************************************
+* Function: static void APP_DeviceVendorAddRule(void);
+*
+* Overview: Called by the stack once the data stage of the add rule
+*   request has been received.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceVendorAddRule(void)
+{
+    //An invalid rule is ignored, the table is left unchanged
+    MIDI_ROUTER_AddRule(&vendorRule);
+}
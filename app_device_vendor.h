@@ -0,0 +1,79 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef APP_DEVICE_VENDOR_H
+#define APP_DEVICE_VENDOR_H
+
+/** CONSTANTS ******************************************************/
+/* Vendor requests addressed to the device (bmRequestType 0x40) */
+#define VENDOR_REQUEST_ROUTER_CLEAR     0x01    //no data stage, removes every routing rule
+#define VENDOR_REQUEST_ROUTER_ADD_RULE  0x02    //8 byte MIDI_ROUTER_RULE data stage
+
+/* Vendor requests available when BRIDGE_RESIDENCY is defined */
+#define VENDOR_REQUEST_RESIDENCY_READ   0x03    //bmRequestType 0xC0, sends residencyStats[]
+#define VENDOR_REQUEST_RESIDENCY_CLEAR  0x04    //no data stage, clears residencyStats[]
+
+/* Vendor requests available when BRIDGE_CYCLE_COUNT is defined */
+#define VENDOR_REQUEST_CYCLE_COUNTER_READ   0x05    //bmRequestType 0xC0, sends cycleCounterStats[]
+#define VENDOR_REQUEST_CYCLE_COUNTER_CLEAR  0x06    //no data stage, clears cycleCounterStats[]
+#define VENDOR_REQUEST_COPY_BENCH_RUN       0x0B    //no data stage, runs COPY_BENCH_Run() from the main loop
+#define VENDOR_REQUEST_COPY_BENCH_READ      0x0C    //bmRequestType 0xC0, sends copyBenchStats[] of the last run
+
+/* Bridge statistics, see bridge_stats.h */
+#define VENDOR_REQUEST_BRIDGE_STATS_READ    0x07    //bmRequestType 0xC0, sends bridgeStats
+#define VENDOR_REQUEST_BRIDGE_STATS_CLEAR   0x08    //no data stage, clears bridgeStats
+
+/* Vendor requests available when BRIDGE_SCHEDULER is defined */
+#define VENDOR_REQUEST_SCHEDULER_READ       0x09    //bmRequestType 0xC0, sends schedulerStats[]
+#define VENDOR_REQUEST_SCHEDULER_CLEAR      0x0A    //no data stage, clears schedulerStats[]
+
+/*********************************************************************
+* Function: void APP_DeviceVendorCheckRequest(void);
+*
+* Overview: Handles the vendor specific control requests used to
+*   configure the bridge. Must be called from the EVENT_EP0_REQUEST
+*   event handler.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceVendorCheckRequest(void);
+
+/*********************************************************************
+* Function: void APP_DeviceVendorTasks(void);
+*
+* Overview: Clears the statistics, runs the copy benchmark and sends the
+*   data stage of the read requests left by
+*   APP_DeviceVendorCheckRequest().  Must be called from
+*   the main loop.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceVendorTasks(void);
+
+#endif //APP_DEVICE_VENDOR_H
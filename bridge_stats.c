@@ -0,0 +1,44 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "bridge_stats.h"
+
+/** VARIABLES ******************************************************/
+BRIDGE_STATS bridgeStats;
+
+/*********************************************************************
+* Function: void BRIDGE_STATS_Clear(void);
+*
+* Overview: Clears every counter
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void BRIDGE_STATS_Clear(void)
+{
+    memset(&bridgeStats, 0, sizeof(bridgeStats));
+}
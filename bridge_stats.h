@@ -0,0 +1,90 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef BRIDGE_STATS_H
+#define BRIDGE_STATS_H
+
+#include <stdint.h>
+
+/*** Bridge Statistics Definitions **********************************/
+/* Counters of the traffic going through the bridge, kept in production
+ * builds to tell dropped events from a stalled or starved bridge.  They are
+ * only incremented, in the main loop or from the USB interrupt for the
+ * traffic and from the USB interrupt for the bus events, and survive
+ * re-enumerations.  Counters wrap around.  They are read and cleared by
+ * APP_DeviceVendorTasks() with the USB interrupt masked. */
+
+/* Counters of one direction */
+typedef struct
+{
+    uint32_t bytesIn;       //bytes taken from the OUT endpoint
+    uint32_t bytesOut;      //bytes handed to the IN endpoint
+    uint32_t eventsIn;      //events queued, or forwarded without copy
+    uint32_t eventsOut;     //events taken out of the queues to be sent
+    uint32_t busySpins;     //task passes with events waiting on a busy IN endpoint
+    uint16_t drops;         //events dropped because their queue was full
+    uint16_t maxDepth;      //most events queued at once, over every cable
+} BRIDGE_STATS_DIRECTION;
+
+/* Sent as it is in memory (little endian) by the
+ * VENDOR_REQUEST_BRIDGE_STATS_READ request */
+typedef struct
+{
+    BRIDGE_STATS_DIRECTION toCdc;   //MIDI OUT endpoint to CDC IN endpoint
+    BRIDGE_STATS_DIRECTION toMidi;  //CDC OUT endpoint to MIDI IN endpoint
+    uint16_t suspends;              //EVENT_SUSPEND events
+    uint16_t resumes;               //EVENT_RESUME events
+    uint16_t busErrors;             //EVENT_BUS_ERROR events
+    uint8_t busErrorFlags;          //every UEIR flag seen with them
+    uint8_t reserved;
+} BRIDGE_STATS;
+
+extern BRIDGE_STATS bridgeStats;
+
+/*********************************************************************
+* Function: void BRIDGE_STATS_Depth(BRIDGE_STATS_DIRECTION direction,
+*                                   uint16_t depth);
+*
+* Overview: Keeps the largest number of events queued in a direction
+*
+* PreCondition: None
+*
+* Input: direction - bridgeStats.toCdc or bridgeStats.toMidi
+*        uint16_t depth - number of events queued now
+*
+* Output: None
+*
+********************************************************************/
+#define BRIDGE_STATS_Depth(direction, depth)    do { if((depth) > (direction).maxDepth) (direction).maxDepth = (depth); } while(0)
+
+/*********************************************************************
+* Function: void BRIDGE_STATS_Clear(void);
+*
+* Overview: Clears every counter
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void BRIDGE_STATS_Clear(void);
+
+#endif //BRIDGE_STATS_H
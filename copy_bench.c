@@ -0,0 +1,189 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb.h"
+
+#include "copy_bench.h"
+#include "cycle_counter.h"
+
+#if defined(BRIDGE_CYCLE_COUNT)
+
+/** VARIABLES ******************************************************/
+COPY_BENCH_STATS copyBenchStats[COPY_BENCH_PATHS];
+
+static uint8_t copyBenchDst[COPY_BENCH_SIZE];
+static uint8_t copyBenchRam[COPY_BENCH_SIZE];
+static const uint8_t copyBenchRom[COPY_BENCH_SIZE] = { 0x55 };
+
+/** PRIVATE PROTOTYPES *********************************************/
+static uint16_t COPY_BENCH_Measure(COPY_BENCH_PATH path);
+static void COPY_BENCH_LoopRam(uint8_t *dst, uint8_t *src, uint8_t length);
+static void COPY_BENCH_LoopRom(uint8_t *dst, const uint8_t *src, uint8_t length);
+
+/*********************************************************************
+* Function: void COPY_BENCH_Run(void);
+*
+* Overview: Times every copy path and stores the results in
+*   copyBenchStats[]
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void COPY_BENCH_Run(void)
+{
+    COPY_BENCH_STATS *stats;
+    uint8_t path;
+    uint8_t i;
+
+    for(path = 0; path < COPY_BENCH_PATHS; path++)
+    {
+        stats = &copyBenchStats[path];
+
+        stats->cycles = 0;
+        for(i = 0; i < COPY_BENCH_MEASURES; i++)
+        {
+            stats->cycles += COPY_BENCH_Measure((COPY_BENCH_PATH)path);
+        }
+
+        stats->bytes = (uint32_t)COPY_BENCH_MEASURES * COPY_BENCH_PASSES * COPY_BENCH_SIZE;
+        stats->cyclesPerByte = (uint16_t)((stats->cycles * 100u) / stats->bytes);
+    }
+}
+
+/*********************************************************************
+* Function: static uint16_t COPY_BENCH_Measure(COPY_BENCH_PATH path);
+*
+* Overview: Times COPY_BENCH_PASSES copies of one path with the USB
+*   interrupt masked.  The path is picked before the timed loops, so they
+*   only differ by the copy.
+*
+* PreCondition: None
+*
+* Input: COPY_BENCH_PATH path - the path to time
+*
+* Output: uint16_t - the cycles taken
+*
+********************************************************************/
+static uint16_t COPY_BENCH_Measure(COPY_BENCH_PATH path)
+{
+    uint16_t start;
+    uint16_t cycles;
+    uint16_t pass;
+
+    //A USB interrupt takes more cycles than the copies being timed
+    USBMaskInterrupts();
+
+    start = CYCLE_COUNTER_Now();
+
+    switch(path)
+    {
+        case COPY_BENCH_RAM_LOOP:
+            for(pass = 0; pass < COPY_BENCH_PASSES; pass++)
+            {
+                COPY_BENCH_LoopRam(copyBenchDst, copyBenchRam, COPY_BENCH_SIZE);
+            }
+            break;
+
+        case COPY_BENCH_RAM:
+            for(pass = 0; pass < COPY_BENCH_PASSES; pass++)
+            {
+                usb_memcpy(copyBenchDst, copyBenchRam, COPY_BENCH_SIZE);
+            }
+            break;
+
+        case COPY_BENCH_ROM_LOOP:
+            for(pass = 0; pass < COPY_BENCH_PASSES; pass++)
+            {
+                COPY_BENCH_LoopRom(copyBenchDst, copyBenchRom, COPY_BENCH_SIZE);
+            }
+            break;
+
+        default:
+            for(pass = 0; pass < COPY_BENCH_PASSES; pass++)
+            {
+                usb_memcpy_rom(copyBenchDst, copyBenchRom, COPY_BENCH_SIZE);
+            }
+            break;
+    }
+
+    cycles = CYCLE_COUNTER_Now() - start;
+
+    USBUnmaskInterrupts();
+
+    return cycles;
+}
+
+/*********************************************************************
+* Function: static void COPY_BENCH_LoopRam(uint8_t *dst, uint8_t *src,
+*                                         uint8_t length);
+*
+* Overview: Byte loop the device stack used to copy from RAM
+*
+* PreCondition: None
+*
+* Input: uint8_t *dst - where to copy the data
+*        uint8_t *src - data to copy
+*        uint8_t length - number of bytes to copy
+*
+* Output: None
+*
+********************************************************************/
+static void COPY_BENCH_LoopRam(uint8_t *dst, uint8_t *src, uint8_t length)
+{
+    while(length)
+    {
+        *dst++ = *src++;
+        length--;
+    }
+}
+
+/*********************************************************************
+* Function: static void COPY_BENCH_LoopRom(uint8_t *dst,
+*                                         const uint8_t *src,
+*                                         uint8_t length);
+*
+* Overview: Byte loop the device stack used to copy from program memory
+*
+* PreCondition: None
+*
+* Input: uint8_t *dst - where to copy the data
+*        const uint8_t *src - data to copy
+*        uint8_t length - number of bytes to copy
+*
+* Output: None
+*
+********************************************************************/
+static void COPY_BENCH_LoopRom(uint8_t *dst, const uint8_t *src, uint8_t length)
+{
+    while(length)
+    {
+        *dst++ = *src++;
+        length--;
+    }
+}
+
+#endif //BRIDGE_CYCLE_COUNT
@@ -0,0 +1,88 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef COPY_BENCH_H
+#define COPY_BENCH_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb_config.h"
+
+/*** Copy Benchmark Definitions *************************************/
+
+/* Copy paths measured, each one moves COPY_BENCH_SIZE bytes into a RAM
+ * buffer the way the device stack fills an endpoint buffer.  The loops
+ * are the byte loops the stack used before usb_memcpy(). */
+typedef enum
+{
+    COPY_BENCH_RAM_LOOP,        //byte loop from RAM
+    COPY_BENCH_RAM,             //usb_memcpy(), the library memcpy(), from RAM
+    COPY_BENCH_ROM_LOOP,        //byte loop from program memory
+    COPY_BENCH_ROM,             //usb_memcpy_rom(), the library memcpy(), from program memory
+    COPY_BENCH_PATHS
+} COPY_BENCH_PATH;
+
+#define COPY_BENCH_SIZE             64      //bytes per copy, a full speed bulk packet
+
+/* Copies timed at once, the simulation build repeats them to get above
+ * the resolution of its clock.  The USB interrupt is masked while they
+ * run, one of them would take longer than the copy. */
+#if defined(USB_SIMULATION)
+    #define COPY_BENCH_PASSES       4096
+#else
+    #define COPY_BENCH_PASSES       1
+#endif
+
+#define COPY_BENCH_MEASURES         8       //measures added up for each path
+
+/* Result of one path, sent as they are in memory (little endian) by the
+ * VENDOR_REQUEST_COPY_BENCH_READ request.  Cycles are Timer1 ticks, one per
+ * instruction cycle as for cycle_counter.h. */
+typedef struct
+{
+    uint32_t cycles;            //total of the measures
+    uint32_t bytes;             //bytes copied during the measures
+    uint16_t cyclesPerByte;     //cycles / bytes, in hundredths of a cycle
+} COPY_BENCH_STATS;
+
+#if defined(BRIDGE_CYCLE_COUNT)
+
+extern COPY_BENCH_STATS copyBenchStats[COPY_BENCH_PATHS];
+
+/*********************************************************************
+* Function: void COPY_BENCH_Run(void);
+*
+* Overview: Times every copy path and stores the results in
+*   copyBenchStats[]
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called.  Takes about
+*   COPY_BENCH_PATHS * COPY_BENCH_MEASURES * COPY_BENCH_SIZE * 20
+*   instruction cycles, 3.5ms at 48MHz.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void COPY_BENCH_Run(void);
+
+#endif //BRIDGE_CYCLE_COUNT
+
+#endif //COPY_BENCH_H
@@ -0,0 +1,144 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <xc.h>
+#include <stdint.h>
+
+#include "cycle_counter.h"
+
+#if defined(CYCLE_COUNTER_TIMER)
+
+#if defined(USB_SIMULATION)
+    #include <time.h>
+#endif
+
+/** VARIABLES ******************************************************/
+#if defined(BRIDGE_CYCLE_COUNT)
+CYCLE_COUNTER_STATS cycleCounterStats[CYCLE_COUNTER_SECTIONS];
+uint16_t cycleCounterEnter[CYCLE_COUNTER_SECTIONS];
+#endif
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Initialize(void);
+*
+* Overview: Starts Timer1 as a free running instruction cycle counter and
+*   clears the statistics.  Must be called before the other modules
+*   reading Timer1 are initialized.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void CYCLE_COUNTER_Initialize(void)
+{
+    #if defined(BRIDGE_CYCLE_COUNT)
+        CYCLE_COUNTER_Clear();
+    #endif
+
+    //16-bit reads, 1:1 prescaler, instruction clock, timer on
+    T1CON = 0x81;
+}
+
+#if defined(BRIDGE_CYCLE_COUNT)
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Clear(void);
+*
+* Overview: Clears the statistics of every section
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void CYCLE_COUNTER_Clear(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < CYCLE_COUNTER_SECTIONS; i++)
+    {
+        cycleCounterStats[i].cycles = 0;
+        cycleCounterStats[i].count = 0;
+        cycleCounterStats[i].max = 0;
+    }
+}
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Record(CYCLE_COUNTER_SECTION section,
+*                                    uint16_t start);
+*
+* Overview: Adds the cycles elapsed since a section began to its
+*   statistics
+*
+* PreCondition: None
+*
+* Input: CYCLE_COUNTER_SECTION section - the section that just ended
+*        uint16_t start - CYCLE_COUNTER_Now() at the beginning of the
+*           section
+*
+* Output: None
+*
+********************************************************************/
+void CYCLE_COUNTER_Record(CYCLE_COUNTER_SECTION section, uint16_t start)
+{
+    uint16_t cycles = CYCLE_COUNTER_Now() - start;
+    CYCLE_COUNTER_STATS *stats = &cycleCounterStats[section];
+
+    stats->cycles += cycles;
+    stats->count++;
+
+    if(cycles > stats->max)
+    {
+        stats->max = cycles;
+    }
+}
+
+#endif //BRIDGE_CYCLE_COUNT
+
+#if defined(USB_SIMULATION)
+/*********************************************************************
+* Function: uint16_t CYCLE_COUNTER_Now(void);
+*
+* Overview: Reads the free running cycle counter
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: uint16_t - the instruction cycle count, modulo 65536
+*
+********************************************************************/
+uint16_t CYCLE_COUNTER_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    //12 instruction cycles per microsecond at 48MHz
+    return (uint16_t)((((uint64_t)now.tv_sec * 1000000000u) + now.tv_nsec) * 12u / 1000u);
+}
+#endif
+
+#endif //CYCLE_COUNTER_TIMER
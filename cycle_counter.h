@@ -0,0 +1,183 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb_config.h"
+
+/*** Cycle Counter Definitions **************************************/
+
+/* Timer1 runs from the instruction clock with a 1:1 prescaler, so one tick
+ * is one instruction cycle (83.3ns at 48MHz).  A measured section must not
+ * take longer than 65535 cycles.  In the simulation build the ticks come
+ * from clock_gettime() scaled to the same 83.3ns, so the tables of both
+ * builds can be compared. */
+
+/* Code sections measured when BRIDGE_CYCLE_COUNT is defined */
+typedef enum
+{
+    CYCLE_COUNTER_CDC_OUT_COPY,     //CDC OUT packet copied and queued
+    CYCLE_COUNTER_MIDI_IN_COPY,     //queued events copied to a MIDI IN packet
+    CYCLE_COUNTER_CDC_OUT_FORWARD,  //CDC OUT packet handed to the MIDI IN endpoint
+    CYCLE_COUNTER_MIDI_OUT_ROUTE,   //MIDI OUT event routed
+    CYCLE_COUNTER_USB_DEVICE_TASKS, //USBDeviceTasks(), from the interrupt or the main loop
+    CYCLE_COUNTER_USB_TRANSACTIONS, //USTAT FIFO drain loop of USBDeviceTasks()
+    CYCLE_COUNTER_USB_CTRL_EP,      //USBCtrlEPService()
+    CYCLE_COUNTER_CDC_TX_COPY,      //CDCTxService() copy to the CDC IN buffer
+    CYCLE_COUNTER_MIDI_TASKS,       //APP_DeviceAudioMIDITasks()
+    CYCLE_COUNTER_CDC_TASKS,        //APP_DeviceCDCBasicDemoTasks()
+    CYCLE_COUNTER_VENDOR_TASKS,     //APP_DeviceVendorTasks()
+    CYCLE_COUNTER_SECTIONS
+} CYCLE_COUNTER_SECTION;
+
+typedef struct
+{
+    uint32_t cycles;    //total of all the measures
+    uint16_t count;     //number of measures
+    uint16_t max;       //longest measure
+} CYCLE_COUNTER_STATS;
+
+/* Timer1 is shared by every module timing the bridge, it is only set up
+ * here */
+#if defined(BRIDGE_CYCLE_COUNT) || defined(BRIDGE_RESIDENCY) || defined(BRIDGE_SCHEDULER)
+    #define CYCLE_COUNTER_TIMER
+#endif
+
+#if defined(CYCLE_COUNTER_TIMER)
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Initialize(void);
+*
+* Overview: Starts Timer1 as a free running instruction cycle counter and
+*   clears the statistics.  Must be called before the other modules
+*   reading Timer1 are initialized.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void CYCLE_COUNTER_Initialize(void);
+
+#if defined(USB_SIMULATION)
+/*********************************************************************
+* Function: uint16_t CYCLE_COUNTER_Now(void);
+*
+* Overview: Reads the free running cycle counter
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: uint16_t - the instruction cycle count, modulo 65536
+*
+********************************************************************/
+uint16_t CYCLE_COUNTER_Now(void);
+#else
+#define CYCLE_COUNTER_Now()             TMR1
+#endif
+
+#else
+
+#define CYCLE_COUNTER_Initialize()
+
+#endif //CYCLE_COUNTER_TIMER
+
+#if defined(BRIDGE_CYCLE_COUNT)
+
+extern CYCLE_COUNTER_STATS cycleCounterStats[CYCLE_COUNTER_SECTIONS];
+extern uint16_t cycleCounterEnter[CYCLE_COUNTER_SECTIONS];
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Clear(void);
+*
+* Overview: Clears the statistics of every section
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void CYCLE_COUNTER_Clear(void);
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Record(CYCLE_COUNTER_SECTION section,
+*                                    uint16_t start);
+*
+* Overview: Adds the cycles elapsed since a section began to its
+*   statistics
+*
+* PreCondition: None
+*
+* Input: CYCLE_COUNTER_SECTION section - the section that just ended
+*        uint16_t start - CYCLE_COUNTER_Now() at the beginning of the
+*           section
+*
+* Output: None
+*
+********************************************************************/
+void CYCLE_COUNTER_Record(CYCLE_COUNTER_SECTION section, uint16_t start);
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Enter(CYCLE_COUNTER_SECTION section);
+*
+* Overview: Marks the beginning of a measured region.  Each region keeps
+*   its own start time, so regions can be nested and used from the
+*   interrupt, but a region must not be entered again before it exits.
+*   Time spent in the interrupt is counted in the regions it interrupts.
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: CYCLE_COUNTER_SECTION section - the region that begins
+*
+* Output: None
+*
+********************************************************************/
+#define CYCLE_COUNTER_Enter(section)    (cycleCounterEnter[section] = CYCLE_COUNTER_Now())
+
+/*********************************************************************
+* Function: void CYCLE_COUNTER_Exit(CYCLE_COUNTER_SECTION section);
+*
+* Overview: Marks the end of a measured region
+*
+* PreCondition: CYCLE_COUNTER_Enter() was called with the same section
+*
+* Input: CYCLE_COUNTER_SECTION section - the region that just ended
+*
+* Output: None
+*
+********************************************************************/
+#define CYCLE_COUNTER_Exit(section)     CYCLE_COUNTER_Record(section, cycleCounterEnter[section])
+
+#else
+
+#define CYCLE_COUNTER_Enter(section)
+#define CYCLE_COUNTER_Exit(section)
+
+#endif //BRIDGE_CYCLE_COUNT
+
+#endif //CYCLE_COUNTER_H
@@ -20,14 +20,21 @@ please contact mla_licensing@microchip.com
 #ifndef FIXED_MEMORY_ADDRESS_H
 #define FIXED_MEMORY_ADDRESS_H
 
+//The simulation backend has no USB RAM, the buffers are placed by the linker
+#if !defined(USB_SIMULATION)
+
 #define FIXED_ADDRESS_MEMORY
 
-#define DEVCE_AUDIO_MIDI_RX_DATA_BUFFER_ADDRESS      0x5C0
-#define DEVCE_AUDIO_MIDI_TX_DATA_BUFFER_ADDRESS      0x600
-#define DEVCE_AUDIO_MIDI_EVENT_DATA_BUFFER_ADDRESS   0x640
+#define DEVCE_AUDIO_MIDI_RX_DATA_BUFFER_ADDRESS      0x6C0     //two 64 byte ping-pong buffers
+#define DEVCE_AUDIO_MIDI_TX_DATA_BUFFER_ADDRESS      0x600     //two 64 byte ping-pong buffers
+#define DEVCE_CDC_TX_DATA_BUFFER_ADDRESS             0x740     //two 64 byte packets, BRIDGE_CDC_IN_DIRECT
 
 #define IN_DATA_BUFFER_ADDRESS_TAG      @0x500
+#define IN_DATA_ODD_BUFFER_ADDRESS_TAG  @0x680
 #define OUT_DATA_BUFFER_ADDRESS_TAG     @0x540
+#define OUT_DATA_ODD_BUFFER_ADDRESS_TAG @0x5C0
 #define CONTROL_BUFFER_ADDRESS_TAG      @0x580
 
+#endif //USB_SIMULATION
+
 #endif //FIXED_MEMORY_ADDRESS
@@ -22,7 +22,11 @@ please contact mla_licensing@microchip.com
 
 #include "app_device_audio_midi.h"
 #include "app_device_cdc_basic.h"
+#include "app_device_vendor.h"
 #include "app_led_usb_status.h"
+#include "cycle_counter.h"
+#include "midi_router.h"
+#include "scheduler.h"
 
 #include "usb_device.h"
 #include "usb_device_midi.h"
@@ -64,6 +68,9 @@ MAIN_RETURN main(void)
         __delay_ms(10);
     }
 
+    //The routing rules are kept when the host re-enumerates the device
+    MIDI_ROUTER_Initialize();
+
     USBDeviceInit();
     USBDeviceAttach();
     
@@ -84,12 +91,29 @@ MAIN_RETURN main(void)
             // "or faster" applies])  In most cases, the USBDeviceTasks()
             // function does not take very long to execute (ex: <100
             // instruction cycles) before it returns.
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_USB_DEVICE_TASKS);
             USBDeviceTasks();
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_USB_DEVICE_TASKS);
         #endif
 
         //Application specific tasks
-        APP_DeviceAudioMIDITasks();
-        APP_DeviceCDCBasicDemoTasks();
+        #if defined(BRIDGE_SCHEDULER)
+            //Only the tasks the USB events gave work to run, the CPU
+            //  idles until the next interrupt otherwise
+            SCHEDULER_Tasks();
+        #else
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_MIDI_TASKS);
+            APP_DeviceAudioMIDITasks();
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_MIDI_TASKS);
+
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_CDC_TASKS);
+            APP_DeviceCDCBasicDemoTasks();
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_CDC_TASKS);
+
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_VENDOR_TASKS);
+            APP_DeviceVendorTasks();
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_VENDOR_TASKS);
+        #endif
 
     }//end while
 }//end main
@@ -0,0 +1,109 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+
+#include "midi_encoder.h"
+
+/** CONSTANTS ******************************************************/
+
+/* Number of MIDI bytes carried by each Code Index Number, table 4-1 of
+ * midi10.pdf.  The reserved CINs 0x0 and 0x1 are not forwarded. */
+static const uint8_t midiCINLength[16] =
+{
+    0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1
+};
+
+/*********************************************************************
+* Function: void MIDI_ENCODER_Initialize(MIDI_ENCODER *encoder);
+*
+* Overview: Resets the encoder so the next channel message is sent with
+*   its status byte
+*
+* PreCondition: None
+*
+* Input: MIDI_ENCODER *encoder - the encoder to initialize
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_ENCODER_Initialize(MIDI_ENCODER *encoder)
+{
+    encoder->runningStatus = 0;
+}
+
+/*********************************************************************
+* Function: uint8_t MIDI_ENCODER_Encode(MIDI_ENCODER *encoder,
+*                       const USB_AUDIO_MIDI_EVENT_PACKET *event,
+*                       uint8_t *buffer);
+*
+* Overview: Converts one event packet to raw MIDI bytes
+*
+* PreCondition: The encoder was initialized with MIDI_ENCODER_Initialize()
+*
+* Input: MIDI_ENCODER *encoder - the encoder
+*        event - the event packet to convert
+*        buffer - destination, at least MIDI_ENCODER_MAX_LENGTH bytes long
+*
+* Output: number of bytes written to buffer (0 for reserved CINs)
+*
+********************************************************************/
+uint8_t MIDI_ENCODER_Encode(MIDI_ENCODER *encoder, const USB_AUDIO_MIDI_EVENT_PACKET *event, uint8_t *buffer)
+{
+    uint8_t cin = event->CodeIndexNumber;
+    uint8_t length = midiCINLength[cin];
+    uint8_t i = 0;
+
+    if(cin >= MIDI_CIN_NOTE_OFF && cin < MIDI_CIN_SINGLE_BYTE)
+    {
+        //Channel message, the status byte can be omitted if it is the same
+        //  as the one of the previous channel message
+        if(event->DATA_0 != encoder->runningStatus)
+        {
+            encoder->runningStatus = event->DATA_0;
+            buffer[i++] = event->DATA_0;
+        }
+    }
+    else
+    {
+        //SysEx and system common messages cancel running status, realtime
+        //  messages can be interleaved without affecting it
+        if((length != 0) && (event->DATA_0 < 0xF8))
+        {
+            encoder->runningStatus = 0;
+        }
+
+        if(length != 0)
+        {
+            buffer[i++] = event->DATA_0;
+        }
+    }
+
+    if(length > 1)
+    {
+        buffer[i++] = event->DATA_1;
+    }
+    if(length > 2)
+    {
+        buffer[i++] = event->DATA_2;
+    }
+
+    return i;
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef MIDI_ENCODER_H
+#define MIDI_ENCODER_H
+
+#include <stdint.h>
+
+#include "usb_device_midi.h"
+
+/*** Encoder Definitions ********************************************/
+
+/* Longest raw MIDI sequence generated for a single event packet */
+#define MIDI_ENCODER_MAX_LENGTH     3
+
+/* USB-MIDI event packet to raw MIDI byte stream converter.
+ *
+ * The padding bytes of the event packets are stripped and the status byte of
+ * consecutive channel messages with the same status is omitted (running
+ * status), so dense controller traffic takes 2 bytes per event instead of 4. */
+typedef struct
+{
+    uint8_t runningStatus;  //last channel status sent, 0 if none
+} MIDI_ENCODER;
+
+/*********************************************************************
+* Function: void MIDI_ENCODER_Initialize(MIDI_ENCODER *encoder);
+*
+* Overview: Resets the encoder so the next channel message is sent with
+*   its status byte
+*
+* PreCondition: None
+*
+* Input: MIDI_ENCODER *encoder - the encoder to initialize
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_ENCODER_Initialize(MIDI_ENCODER *encoder);
+
+/*********************************************************************
+* Function: uint8_t MIDI_ENCODER_Encode(MIDI_ENCODER *encoder,
+*                       const USB_AUDIO_MIDI_EVENT_PACKET *event,
+*                       uint8_t *buffer);
+*
+* Overview: Converts one event packet to raw MIDI bytes
+*
+* PreCondition: The encoder was initialized with MIDI_ENCODER_Initialize()
+*
+* Input: MIDI_ENCODER *encoder - the encoder
+*        event - the event packet to convert
+*        buffer - destination, at least MIDI_ENCODER_MAX_LENGTH bytes long
+*
+* Output: number of bytes written to buffer (0 for reserved CINs)
+*
+********************************************************************/
+uint8_t MIDI_ENCODER_Encode(MIDI_ENCODER *encoder, const USB_AUDIO_MIDI_EVENT_PACKET *event, uint8_t *buffer);
+
+#endif //MIDI_ENCODER_H
@@ -0,0 +1,230 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "midi_parser.h"
+
+/** DEFINITIONS ****************************************************/
+#define MIDI_STATUS_SYSEX_START     0xF0
+#define MIDI_STATUS_MTC             0xF1
+#define MIDI_STATUS_SONG_POSITION   0xF2
+#define MIDI_STATUS_SONG_SELECT     0xF3
+#define MIDI_STATUS_TUNE_REQUEST    0xF6
+#define MIDI_STATUS_SYSEX_END       0xF7
+#define MIDI_STATUS_REALTIME        0xF8
+
+/** PRIVATE PROTOTYPES *********************************************/
+static void MIDI_PARSER_Emit(MIDI_PARSER *parser, uint8_t cin, USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+/*********************************************************************
+* Function: void MIDI_PARSER_Initialize(MIDI_PARSER *parser, uint8_t cable);
+*
+* Overview: Resets the parser, dropping any partially received message
+*
+* PreCondition: None
+*
+* Input: MIDI_PARSER *parser - the parser to initialize
+*        uint8_t cable - cable number to use for the generated events
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_PARSER_Initialize(MIDI_PARSER *parser, uint8_t cable)
+{
+    parser->status = 0;
+    parser->length = 0;
+    parser->expected = 0;
+    parser->cable = cable;
+}
+
+/*********************************************************************
+* Function: bool MIDI_PARSER_Parse(MIDI_PARSER *parser, uint8_t data,
+*                                  USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Feeds one byte of the raw MIDI stream to the parser.  Every
+*   byte completes at most one event.
+*
+* PreCondition: The parser was initialized with MIDI_PARSER_Initialize()
+*
+* Input: MIDI_PARSER *parser - the parser
+*        uint8_t data - next byte of the stream
+*        event - where to store the event if one is completed
+*
+* Output: true if a complete event was written to event
+*
+********************************************************************/
+bool MIDI_PARSER_Parse(MIDI_PARSER *parser, uint8_t data, USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    /* Realtime messages may show up between any two bytes, even in the middle
+     * of another message.  Send them on their own without touching the state
+     * of the message being received. */
+    if(data >= MIDI_STATUS_REALTIME)
+    {
+        event->Val = 0;
+        event->CableNumber = parser->cable;
+        event->CodeIndexNumber = MIDI_CIN_SINGLE_BYTE;
+        event->DATA_0 = data;
+        return true;
+    }
+
+    if(parser->status == MIDI_STATUS_SYSEX_START)
+    {
+        if(data == MIDI_STATUS_SYSEX_END)
+        {
+            /* The last packet holds one to three bytes, the EOX included */
+            parser->buffer[parser->length++] = data;
+            MIDI_PARSER_Emit(parser, MIDI_CIN_SYSEX_ENDS_1 + parser->length - 1, event);
+            parser->status = 0;
+            return true;
+        }
+
+        if(data < 0x80)
+        {
+            parser->buffer[parser->length++] = data;
+            if(parser->length == 3)
+            {
+                MIDI_PARSER_Emit(parser, MIDI_CIN_SYSEX_CONTINUE, event);
+                return true;
+            }
+            return false;
+        }
+
+        /* Any other status byte ends the SysEx without an EOX.  Drop what is
+         * left of it and handle the new status below. */
+        parser->status = 0;
+        parser->length = 0;
+    }
+
+    if(data >= 0x80)
+    {
+        parser->buffer[0] = data;
+        parser->length = 1;
+
+        if(data < MIDI_STATUS_SYSEX_START)
+        {
+            //Channel message, program change and channel pressure have a
+            //  single data byte
+            parser->status = data;
+            parser->expected = ((data & 0xE0) == 0xC0) ? 2 : 3;
+            return false;
+        }
+
+        //System common messages cancel running status
+        parser->status = 0;
+
+        switch(data)
+        {
+            case MIDI_STATUS_SYSEX_START:
+                parser->status = data;
+                break;
+
+            case MIDI_STATUS_MTC:
+            case MIDI_STATUS_SONG_SELECT:
+                parser->status = data;
+                parser->expected = 2;
+                break;
+
+            case MIDI_STATUS_SONG_POSITION:
+                parser->status = data;
+                parser->expected = 3;
+                break;
+
+            case MIDI_STATUS_TUNE_REQUEST:
+                MIDI_PARSER_Emit(parser, MIDI_CIN_1_BYTE_MESSAGE, event);
+                return true;
+
+            default:
+                //Undefined (0xF4, 0xF5) or stray EOX
+                parser->length = 0;
+                break;
+        }
+        return false;
+    }
+
+    //Data byte without a status to apply it to
+    if(parser->status == 0)
+    {
+        return false;
+    }
+
+    //Running status, reuse the last status byte
+    if(parser->length == 0)
+    {
+        parser->buffer[0] = parser->status;
+        parser->length = 1;
+    }
+
+    parser->buffer[parser->length++] = data;
+
+    if(parser->length < parser->expected)
+    {
+        return false;
+    }
+
+    if(parser->status < MIDI_STATUS_SYSEX_START)
+    {
+        MIDI_PARSER_Emit(parser, parser->status >> 4, event);
+    }
+    else
+    {
+        MIDI_PARSER_Emit(parser, (parser->expected == 2) ? MIDI_CIN_2_BYTE_MESSAGE : MIDI_CIN_3_BYTE_MESSAGE, event);
+
+        //There is no running status for system common messages
+        parser->status = 0;
+    }
+    return true;
+}
+
+/*********************************************************************
+* Function: static void MIDI_PARSER_Emit(MIDI_PARSER *parser, uint8_t cin,
+*                                        USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Builds an event packet from the bytes collected so far and
+*   empties the message buffer.  Unused bytes of the packet are set to 0.
+*
+* PreCondition: None
+*
+* Input: MIDI_PARSER *parser - the parser
+*        uint8_t cin - code index number of the event
+*        event - where to store the event
+*
+* Output: None
+*
+********************************************************************/
+static void MIDI_PARSER_Emit(MIDI_PARSER *parser, uint8_t cin, USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    event->Val = 0;
+    event->CableNumber = parser->cable;
+    event->CodeIndexNumber = cin;
+    event->DATA_0 = parser->buffer[0];
+
+    if(parser->length > 1)
+    {
+        event->DATA_1 = parser->buffer[1];
+    }
+    if(parser->length > 2)
+    {
+        event->DATA_2 = parser->buffer[2];
+    }
+
+    parser->length = 0;
+}
@@ -0,0 +1,78 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef MIDI_PARSER_H
+#define MIDI_PARSER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usb_device_midi.h"
+
+/*** Parser Definitions *********************************************/
+
+/* Incremental raw MIDI byte stream to USB-MIDI event packet converter.
+ *
+ * The parser keeps its state between calls, so a message may be split in
+ * any way across the chunks read from the host.  It supports running status,
+ * realtime messages (0xF8-0xFF) interleaved anywhere, including inside other
+ * messages and SysEx, and SysEx of any length. */
+typedef struct
+{
+    uint8_t status;     //running status, 0xF0 inside a SysEx, 0 if none
+    uint8_t length;     //bytes of the current message collected in buffer[]
+    uint8_t expected;   //length of a complete message, status byte included
+    uint8_t cable;      //cable number of the generated event packets
+    uint8_t buffer[3];
+} MIDI_PARSER;
+
+/*********************************************************************
+* Function: void MIDI_PARSER_Initialize(MIDI_PARSER *parser, uint8_t cable);
+*
+* Overview: Resets the parser, dropping any partially received message
+*
+* PreCondition: None
+*
+* Input: MIDI_PARSER *parser - the parser to initialize
+*        uint8_t cable - cable number to use for the generated events
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_PARSER_Initialize(MIDI_PARSER *parser, uint8_t cable);
+
+/*********************************************************************
+* Function: bool MIDI_PARSER_Parse(MIDI_PARSER *parser, uint8_t data,
+*                                  USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Feeds one byte of the raw MIDI stream to the parser.  Every
+*   byte completes at most one event.
+*
+* PreCondition: The parser was initialized with MIDI_PARSER_Initialize()
+*
+* Input: MIDI_PARSER *parser - the parser
+*        uint8_t data - next byte of the stream
+*        event - where to store the event if one is completed
+*
+* Output: true if a complete event was written to event
+*
+********************************************************************/
+bool MIDI_PARSER_Parse(MIDI_PARSER *parser, uint8_t data, USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+#endif //MIDI_PARSER_H
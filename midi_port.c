@@ -0,0 +1,414 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "midi_port.h"
+
+/** MACROS *********************************************************/
+#define MIDI_PORT_IsRealtime(event)     (((event)->CodeIndexNumber == MIDI_CIN_SINGLE_BYTE) && ((event)->DATA_0 >= 0xF8))
+
+#define MIDI_PORT_NextCable(port)       ((port)->next = (((port)->next + 1) == BRIDGE_NUM_CABLES) ? 0 : ((port)->next + 1))
+
+/*********************************************************************
+* Function: void MIDI_PORT_Initialize(MIDI_PORT *port);
+*
+* Overview: Empties the queues of every cable
+*
+* PreCondition: Neither the producer nor the consumer may be using the
+*   port while it is initialized.
+*
+* Input: MIDI_PORT *port - the port to initialize
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_PORT_Initialize(MIDI_PORT *port)
+{
+    uint8_t i;
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        MIDI_QUEUE_Initialize(&port->cables[i]);
+    }
+    MIDI_QUEUE_Initialize(&port->realtime);
+
+    port->next = 0;
+    port->sysExOpen = false;
+}
+
+/*********************************************************************
+* Function: uint16_t MIDI_PORT_Count(MIDI_PORT *port);
+*
+* Overview: Returns the number of events waiting on every cable and in
+*   the realtime lane, which can be more than 255 with several cables.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: number of queued events
+*
+********************************************************************/
+uint16_t MIDI_PORT_Count(MIDI_PORT *port)
+{
+    uint8_t i;
+    uint16_t count = MIDI_QUEUE_Count(&port->realtime);
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        count += MIDI_QUEUE_Count(&port->cables[i]);
+    }
+
+    return count;
+}
+
+/*********************************************************************
+* Function: bool MIDI_PORT_IsEmpty(MIDI_PORT *port);
+*
+* Overview: Checks if no event waits on any cable
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: true if the queues of every cable are empty
+*
+********************************************************************/
+bool MIDI_PORT_IsEmpty(MIDI_PORT *port)
+{
+    uint8_t i;
+
+    if(!MIDI_QUEUE_IsEmpty(&port->realtime))
+    {
+        return false;
+    }
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        if(!MIDI_QUEUE_IsEmpty(&port->cables[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*********************************************************************
+* Function: uint8_t MIDI_PORT_Free(MIDI_PORT *port, uint8_t cable);
+*
+* Overview: Returns the number of events that can still be queued on a
+*   cable
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*        uint8_t cable - the cable number
+*
+* Output: number of free slots.  Events of a cable above
+*   BRIDGE_NUM_CABLES are discarded, so there is always room for them.
+*
+********************************************************************/
+uint8_t MIDI_PORT_Free(MIDI_PORT *port, uint8_t cable)
+{
+    if(cable >= BRIDGE_NUM_CABLES)
+    {
+        return MIDI_QUEUE_SIZE;
+    }
+
+    return MIDI_QUEUE_Free(&port->cables[cable]);
+}
+
+/*********************************************************************
+* Function: bool MIDI_PORT_HasRoom(MIDI_PORT *port, const uint8_t *packet,
+*                                  uint8_t length);
+*
+* Overview: Checks if every event of a USB-MIDI packet can be queued.
+*   Zero padding events are not counted.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*        packet - the event packets
+*        length - size of the packet in bytes, a multiple of 4
+*
+* Output: true if the queue of each cable, and the realtime lane, have
+*   room for their events
+*
+********************************************************************/
+bool MIDI_PORT_HasRoom(MIDI_PORT *port, const uint8_t *packet, uint8_t length)
+{
+    uint8_t needed[BRIDGE_NUM_CABLES];
+    uint8_t neededRealtime = 0;
+    uint8_t cable;
+    uint8_t i;
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        needed[i] = 0;
+    }
+
+    for(i = 0; i < length; i += sizeof(USB_AUDIO_MIDI_EVENT_PACKET))
+    {
+        //The first byte of an event packet holds the cable number in its
+        //  upper nibble, and is only 0 for the zero padding
+        if(packet[i] == 0)
+        {
+            continue;
+        }
+
+        cable = packet[i] >> 4;
+        if(MIDI_PORT_IsRealtime((const USB_AUDIO_MIDI_EVENT_PACKET*)&packet[i]))
+        {
+            neededRealtime++;
+        }
+        else if(cable < BRIDGE_NUM_CABLES)
+        {
+            needed[cable]++;
+        }
+    }
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        if(MIDI_QUEUE_Free(&port->cables[i]) < needed[i])
+        {
+            return false;
+        }
+    }
+
+    return (MIDI_QUEUE_Free(&port->realtime) >= neededRealtime);
+}
+
+/*********************************************************************
+* Function: bool MIDI_PORT_Put(MIDI_PORT *port,
+*                              const USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Appends an event to the queue of its cable, or to the
+*   realtime lane for a realtime message.  Must only be called by the
+*   producer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to write to
+*        event - the event to append
+*
+* Output: true if the event was queued, false if it was dropped
+*
+********************************************************************/
+bool MIDI_PORT_Put(MIDI_PORT *port, const USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    //The 4-bit cable number can not be out of range with 16 cables
+    #if BRIDGE_NUM_CABLES < 16
+        if(event->CableNumber >= BRIDGE_NUM_CABLES)
+        {
+            return false;
+        }
+    #endif
+
+    if(MIDI_PORT_IsRealtime(event))
+    {
+        return MIDI_QUEUE_Put(&port->realtime, event);
+    }
+
+    return MIDI_QUEUE_Put(&port->cables[event->CableNumber], event);
+}
+
+/*********************************************************************
+* Function: bool MIDI_PORT_Get(MIDI_PORT *port,
+*                              USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Removes the next event in round-robin order, for a consumer
+*   merging every cable into one MIDI byte stream.  Once a SysEx message
+*   has started, the events of its cable are returned until it ends, since
+*   other messages can not be interleaved with it in a byte stream.
+*   Realtime messages come first, they may be interleaved with anything.
+*   Must only be called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to read from
+*        event - where to store the event
+*
+* Output: true if an event was read, false if there is none to read
+*
+********************************************************************/
+bool MIDI_PORT_Get(MIDI_PORT *port, USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    uint8_t i;
+
+    //Realtime messages may show up in the middle of a SysEx message without
+    //  ending it
+    if(MIDI_QUEUE_Get(&port->realtime, event) == true)
+    {
+        return true;
+    }
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        if(MIDI_QUEUE_Get(&port->cables[port->next], event) == true)
+        {
+            port->sysExOpen = (event->CodeIndexNumber == MIDI_CIN_SYSEX_CONTINUE);
+
+            if(port->sysExOpen == false)
+            {
+                MIDI_PORT_NextCable(port);
+            }
+            return true;
+        }
+
+        //Wait for the rest of the SysEx message of this cable
+        if(port->sysExOpen == true)
+        {
+            return false;
+        }
+
+        MIDI_PORT_NextCable(port);
+    }
+
+    return false;
+}
+
+/*********************************************************************
+* Function: uint8_t MIDI_PORT_Read(MIDI_PORT *port, uint8_t *buffer,
+*                                  uint8_t maxEvents);
+*
+* Overview: Moves up to maxEvents events into a packet buffer: the
+*   realtime messages first, then one event of each cable in turn.  Must
+*   only be called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to read from
+*        buffer - destination, at least 4*maxEvents bytes long
+*        maxEvents - maximum number of events to read
+*
+* Output: number of bytes written to buffer
+*
+********************************************************************/
+uint8_t MIDI_PORT_Read(MIDI_PORT *port, uint8_t *buffer, uint8_t maxEvents)
+{
+    uint8_t length;
+    #if (BRIDGE_NUM_CABLES > 1)
+        uint8_t idle = 0;
+    #endif
+
+    length = MIDI_QUEUE_Read(&port->realtime, buffer, maxEvents);
+    maxEvents -= length / sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+
+    #if (BRIDGE_NUM_CABLES == 1)
+        length += MIDI_QUEUE_Read(&port->cables[0], &buffer[length], maxEvents);
+    #else
+        //Stop once every cable has been found empty in a row
+        while((maxEvents != 0) && (idle < BRIDGE_NUM_CABLES))
+        {
+            if(MIDI_QUEUE_Read(&port->cables[port->next], &buffer[length], 1) != 0)
+            {
+                length += sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+                maxEvents--;
+                idle = 0;
+            }
+            else
+            {
+                idle++;
+            }
+
+            MIDI_PORT_NextCable(port);
+        }
+    #endif
+
+    return length;
+}
+
+/*********************************************************************
+* Function: bool MIDI_PORT_IsSysExOpen(MIDI_PORT *port);
+*
+* Overview: Checks if a SysEx message is still being queued on any cable.
+*   Must only be called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: true if more events of a SysEx message are expected
+*
+********************************************************************/
+bool MIDI_PORT_IsSysExOpen(MIDI_PORT *port)
+{
+    uint8_t i;
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        if(MIDI_QUEUE_IsSysExOpen(&port->cables[i]) == true)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*********************************************************************
+* Function: bool MIDI_PORT_HasRealtime(MIDI_PORT *port);
+*
+* Overview: Checks if a realtime message waits on any cable.  Must only be
+*   called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: true if at least one queued event is a realtime message
+*
+********************************************************************/
+bool MIDI_PORT_HasRealtime(MIDI_PORT *port)
+{
+    return !MIDI_QUEUE_IsEmpty(&port->realtime);
+}
+
+#if defined(BRIDGE_RESIDENCY)
+/*********************************************************************
+* Function: void MIDI_PORT_SetResidency(MIDI_PORT *port,
+*                                       RESIDENCY_STATS *stats);
+*
+* Overview: Selects where the time spent in the queues of the port by
+*   each event is recorded when BRIDGE_RESIDENCY is defined
+*
+* PreCondition: Called after MIDI_PORT_Initialize(), which stops the
+*   recording
+*
+* Input: MIDI_PORT *port - the port to measure
+*        stats - statistics of the direction of the port
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_PORT_SetResidency(MIDI_PORT *port, RESIDENCY_STATS *stats)
+{
+    uint8_t i;
+
+    for(i = 0; i < BRIDGE_NUM_CABLES; i++)
+    {
+        port->cables[i].residency = stats;
+    }
+    port->realtime.residency = stats;
+}
+#endif //BRIDGE_RESIDENCY
@@ -0,0 +1,259 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef MIDI_PORT_H
+#define MIDI_PORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usb_config.h"
+#include "usb_device_midi.h"
+#include "midi_queue.h"
+
+/*** Port Definitions ***********************************************/
+#if (BRIDGE_NUM_CABLES < 1) || (BRIDGE_NUM_CABLES > 16)
+    #error "BRIDGE_NUM_CABLES must be between 1 and 16."
+#endif
+
+/* One direction of the bridge: a MIDI_QUEUE per virtual cable, so a busy
+ * cable (a SysEx dump for instance) does not hold back the events of the
+ * other ones.  The queues are drained round-robin, one event per cable at a
+ * time.  Events of cables above BRIDGE_NUM_CABLES are discarded.
+ *
+ * Realtime messages (timing clock, start, stop...) of every cable go to a
+ * separate lane that is always drained first, so they never wait behind a
+ * SysEx dump or a burst of controllers queued before them.
+ *
+ * As for MIDI_QUEUE, the producer and the consumer sides may run in
+ * different contexts.  The round-robin state belongs to the consumer. */
+typedef struct
+{
+    MIDI_QUEUE cables[BRIDGE_NUM_CABLES];
+    MIDI_QUEUE realtime;    //realtime messages of every cable
+    uint8_t next;           //next cable to read from
+    bool sysExOpen;         //MIDI_PORT_Get() is in the middle of a SysEx
+} MIDI_PORT;
+
+/*********************************************************************
+* Function: void MIDI_PORT_Initialize(MIDI_PORT *port);
+*
+* Overview: Empties the queues of every cable
+*
+* PreCondition: Neither the producer nor the consumer may be using the
+*   port while it is initialized.
+*
+* Input: MIDI_PORT *port - the port to initialize
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_PORT_Initialize(MIDI_PORT *port);
+
+/*********************************************************************
+* Function: uint16_t MIDI_PORT_Count(MIDI_PORT *port);
+*
+* Overview: Returns the number of events waiting on every cable and in
+*   the realtime lane, which can be more than 255 with several cables.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: number of queued events
+*
+********************************************************************/
+uint16_t MIDI_PORT_Count(MIDI_PORT *port);
+
+/*********************************************************************
+* Function: bool MIDI_PORT_IsEmpty(MIDI_PORT *port);
+*
+* Overview: Checks if no event waits on any cable
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: true if the queues of every cable are empty
+*
+********************************************************************/
+bool MIDI_PORT_IsEmpty(MIDI_PORT *port);
+
+/*********************************************************************
+* Function: uint8_t MIDI_PORT_Free(MIDI_PORT *port, uint8_t cable);
+*
+* Overview: Returns the number of events that can still be queued on a
+*   cable
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*        uint8_t cable - the cable number
+*
+* Output: number of free slots.  Events of a cable above
+*   BRIDGE_NUM_CABLES are discarded, so there is always room for them.
+*
+********************************************************************/
+uint8_t MIDI_PORT_Free(MIDI_PORT *port, uint8_t cable);
+
+/*********************************************************************
+* Function: uint8_t MIDI_PORT_FreeRealtime(MIDI_PORT *port);
+*
+* Overview: Returns the number of realtime messages that can still be
+*   queued
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: number of free slots in the realtime lane
+*
+********************************************************************/
+#define MIDI_PORT_FreeRealtime(port)    MIDI_QUEUE_Free(&(port)->realtime)
+
+/*********************************************************************
+* Function: bool MIDI_PORT_HasRoom(MIDI_PORT *port, const uint8_t *packet,
+*                                  uint8_t length);
+*
+* Overview: Checks if every event of a USB-MIDI packet can be queued.
+*   Zero padding events are not counted.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*        packet - the event packets
+*        length - size of the packet in bytes, a multiple of 4
+*
+* Output: true if the queue of each cable, and the realtime lane, have
+*   room for their events
+*
+********************************************************************/
+bool MIDI_PORT_HasRoom(MIDI_PORT *port, const uint8_t *packet, uint8_t length);
+
+/*********************************************************************
+* Function: bool MIDI_PORT_Put(MIDI_PORT *port,
+*                              const USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Appends an event to the queue of its cable, or to the
+*   realtime lane for a realtime message.  Must only be called by the
+*   producer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to write to
+*        event - the event to append
+*
+* Output: true if the event was queued, false if it was dropped
+*
+********************************************************************/
+bool MIDI_PORT_Put(MIDI_PORT *port, const USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+/*********************************************************************
+* Function: bool MIDI_PORT_Get(MIDI_PORT *port,
+*                              USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Removes the next event in round-robin order, for a consumer
+*   merging every cable into one MIDI byte stream.  Once a SysEx message
+*   has started, the events of its cable are returned until it ends, since
+*   other messages can not be interleaved with it in a byte stream.
+*   Realtime messages come first, they may be interleaved with anything.
+*   Must only be called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to read from
+*        event - where to store the event
+*
+* Output: true if an event was read, false if there is none to read
+*
+********************************************************************/
+bool MIDI_PORT_Get(MIDI_PORT *port, USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+/*********************************************************************
+* Function: uint8_t MIDI_PORT_Read(MIDI_PORT *port, uint8_t *buffer,
+*                                  uint8_t maxEvents);
+*
+* Overview: Moves up to maxEvents events into a packet buffer: the
+*   realtime messages first, then one event of each cable in turn.  Must
+*   only be called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to read from
+*        buffer - destination, at least 4*maxEvents bytes long
+*        maxEvents - maximum number of events to read
+*
+* Output: number of bytes written to buffer
+*
+********************************************************************/
+uint8_t MIDI_PORT_Read(MIDI_PORT *port, uint8_t *buffer, uint8_t maxEvents);
+
+/*********************************************************************
+* Function: bool MIDI_PORT_IsSysExOpen(MIDI_PORT *port);
+*
+* Overview: Checks if a SysEx message is still being queued on any cable.
+*   Must only be called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: true if more events of a SysEx message are expected
+*
+********************************************************************/
+bool MIDI_PORT_IsSysExOpen(MIDI_PORT *port);
+
+/*********************************************************************
+* Function: bool MIDI_PORT_HasRealtime(MIDI_PORT *port);
+*
+* Overview: Checks if a realtime message waits on any cable.  Must only be
+*   called by the consumer side of the port.
+*
+* PreCondition: None
+*
+* Input: MIDI_PORT *port - the port to check
+*
+* Output: true if at least one queued event is a realtime message
+*
+********************************************************************/
+bool MIDI_PORT_HasRealtime(MIDI_PORT *port);
+
+/*********************************************************************
+* Function: void MIDI_PORT_SetResidency(MIDI_PORT *port,
+*                                       RESIDENCY_STATS *stats);
+*
+* Overview: Selects where the time spent in the queues of the port by
+*   each event is recorded when BRIDGE_RESIDENCY is defined
+*
+* PreCondition: Called after MIDI_PORT_Initialize(), which stops the
+*   recording
+*
+* Input: MIDI_PORT *port - the port to measure
+*        stats - statistics of the direction of the port
+*
+* Output: None
+*
+********************************************************************/
+#if defined(BRIDGE_RESIDENCY)
+void MIDI_PORT_SetResidency(MIDI_PORT *port, RESIDENCY_STATS *stats);
+#else
+#define MIDI_PORT_SetResidency(port, stats)
+#endif
+
+#endif //MIDI_PORT_H
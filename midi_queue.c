@@ -0,0 +1,196 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "midi_queue.h"
+
+/*********************************************************************
+* Function: void MIDI_QUEUE_Initialize(MIDI_QUEUE *queue);
+*
+* Overview: Empties the queue and clears its overflow counter
+*
+* PreCondition: Neither the producer nor the consumer may be using the
+*   queue while it is initialized.
+*
+* Input: MIDI_QUEUE *queue - the queue to initialize
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_QUEUE_Initialize(MIDI_QUEUE *queue)
+{
+    queue->head = 0;
+    queue->tail = 0;
+    queue->overflows = 0;
+
+    #if defined(BRIDGE_RESIDENCY)
+        queue->residency = NULL;
+    #endif
+}
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_Put(MIDI_QUEUE *queue,
+*                               const USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Appends an event to the queue.  Must only be called by the
+*   producer side of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to write to
+*        event - the event to append
+*
+* Output: true if the event was queued, false if the queue was full and
+*   the event was dropped (the overflow counter is incremented).
+*
+********************************************************************/
+bool MIDI_QUEUE_Put(MIDI_QUEUE *queue, const USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    uint8_t head = queue->head;
+
+    if((uint8_t)(head - queue->tail) >= MIDI_QUEUE_SIZE)
+    {
+        queue->overflows++;
+        return false;
+    }
+
+    queue->events[head & MIDI_QUEUE_MASK].Val = event->Val;
+    #if defined(BRIDGE_RESIDENCY)
+        RESIDENCY_Stamp(&queue->stamps[head & MIDI_QUEUE_MASK]);
+    #endif
+
+    //Publish the event only after it has been completely written
+    queue->head = head + 1;
+    return true;
+}
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_Get(MIDI_QUEUE *queue,
+*                               USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Removes the oldest event from the queue.  Must only be called
+*   by the consumer side of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to read from
+*        event - where to store the event
+*
+* Output: true if an event was read, false if the queue was empty
+*
+********************************************************************/
+bool MIDI_QUEUE_Get(MIDI_QUEUE *queue, USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    uint8_t tail = queue->tail;
+
+    if(tail == queue->head)
+    {
+        return false;
+    }
+
+    event->Val = queue->events[tail & MIDI_QUEUE_MASK].Val;
+    #if defined(BRIDGE_RESIDENCY)
+        RESIDENCY_Record(queue->residency, &queue->stamps[tail & MIDI_QUEUE_MASK]);
+    #endif
+
+    //Release the slot only after the event has been copied out
+    queue->tail = tail + 1;
+    return true;
+}
+
+/*********************************************************************
+* Function: uint8_t MIDI_QUEUE_Read(MIDI_QUEUE *queue, uint8_t *buffer,
+*                                   uint8_t maxEvents);
+*
+* Overview: Moves up to maxEvents events from the queue into a packet
+*   buffer, 4 bytes per event.  Must only be called by the consumer side
+*   of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to read from
+*        buffer - destination, at least 4*maxEvents bytes long
+*        maxEvents - maximum number of events to read
+*
+* Output: number of bytes written to buffer
+*
+********************************************************************/
+uint8_t MIDI_QUEUE_Read(MIDI_QUEUE *queue, uint8_t *buffer, uint8_t maxEvents)
+{
+    uint8_t tail = queue->tail;
+    uint8_t count = (uint8_t)(queue->head - tail);
+    uint8_t length = 0;
+    volatile uint8_t *event;
+
+    if(count > maxEvents)
+    {
+        count = maxEvents;
+    }
+
+    while(count != 0)
+    {
+        event = queue->events[tail & MIDI_QUEUE_MASK].v;
+
+        buffer[length++] = event[0];
+        buffer[length++] = event[1];
+        buffer[length++] = event[2];
+        buffer[length++] = event[3];
+        #if defined(BRIDGE_RESIDENCY)
+            RESIDENCY_Record(queue->residency, &queue->stamps[tail & MIDI_QUEUE_MASK]);
+        #endif
+
+        tail++;
+        count--;
+    }
+
+    queue->tail = tail;
+    return length;
+}
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_IsSysExOpen(MIDI_QUEUE *queue);
+*
+* Overview: Checks if the newest event in the queue starts or continues a
+*   SysEx message whose end has not been queued yet.  Must only be called
+*   by the consumer side of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to check
+*
+* Output: true if more events of the same SysEx message are expected
+*
+********************************************************************/
+bool MIDI_QUEUE_IsSysExOpen(MIDI_QUEUE *queue)
+{
+    uint8_t head = queue->head;
+
+    if(head == queue->tail)
+    {
+        return false;
+    }
+
+    //SysEx start and continue share the same CIN, the last packet of the
+    //  message uses one of the MIDI_CIN_SYSEX_ENDS_x CINs instead
+    return (queue->events[(uint8_t)(head - 1) & MIDI_QUEUE_MASK].CodeIndexNumber == MIDI_CIN_SYSEX_CONTINUE);
+}
@@ -0,0 +1,183 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef MIDI_QUEUE_H
+#define MIDI_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usb_config.h"
+#include "usb_device_midi.h"
+#include "residency.h"
+
+/*** Queue Definitions **********************************************/
+#if (MIDI_QUEUE_SIZE > 128) || ((MIDI_QUEUE_SIZE & (MIDI_QUEUE_SIZE - 1)) != 0)
+    #error "MIDI_QUEUE_SIZE must be a power of two no larger than 128."
+#endif
+
+#define MIDI_QUEUE_MASK     (MIDI_QUEUE_SIZE - 1)
+
+/* Single producer / single consumer ring of USB-MIDI event packets.
+ *
+ * head and tail are free running 8-bit counters.  head is only written by the
+ * producer and tail only by the consumer, and both are single byte stores on
+ * the PIC18, so one side may run in the USB interrupt while the other runs in
+ * the main loop without masking interrupts. */
+typedef struct
+{
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t overflows;    //events dropped because the queue was full
+    volatile USB_AUDIO_MIDI_EVENT_PACKET events[MIDI_QUEUE_SIZE];
+    #if defined(BRIDGE_RESIDENCY)
+        RESIDENCY_STAMP stamps[MIDI_QUEUE_SIZE];    //time each event was queued at
+        RESIDENCY_STATS *residency;     //where the time spent queued is recorded
+    #endif
+} MIDI_QUEUE;
+
+/*********************************************************************
+* Function: uint8_t MIDI_QUEUE_Count(MIDI_QUEUE *queue);
+*
+* Overview: Returns the number of events waiting in the queue
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to check
+*
+* Output: number of queued events
+*
+********************************************************************/
+#define MIDI_QUEUE_Count(queue)     ((uint8_t)((queue)->head - (queue)->tail))
+
+/*********************************************************************
+* Function: uint8_t MIDI_QUEUE_Free(MIDI_QUEUE *queue);
+*
+* Overview: Returns the number of events that can still be queued
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to check
+*
+* Output: number of free slots
+*
+********************************************************************/
+#define MIDI_QUEUE_Free(queue)      ((uint8_t)(MIDI_QUEUE_SIZE - MIDI_QUEUE_Count(queue)))
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_IsEmpty(MIDI_QUEUE *queue);
+*
+* Overview: Checks if there is no event waiting in the queue
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to check
+*
+* Output: true if the queue is empty
+*
+********************************************************************/
+#define MIDI_QUEUE_IsEmpty(queue)   ((queue)->head == (queue)->tail)
+
+/*********************************************************************
+* Function: void MIDI_QUEUE_Initialize(MIDI_QUEUE *queue);
+*
+* Overview: Empties the queue and clears its overflow counter
+*
+* PreCondition: Neither the producer nor the consumer may be using the
+*   queue while it is initialized.
+*
+* Input: MIDI_QUEUE *queue - the queue to initialize
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_QUEUE_Initialize(MIDI_QUEUE *queue);
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_Put(MIDI_QUEUE *queue,
+*                               const USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Appends an event to the queue.  Must only be called by the
+*   producer side of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to write to
+*        event - the event to append
+*
+* Output: true if the event was queued, false if the queue was full and
+*   the event was dropped (the overflow counter is incremented).
+*
+********************************************************************/
+bool MIDI_QUEUE_Put(MIDI_QUEUE *queue, const USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_Get(MIDI_QUEUE *queue,
+*                               USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Removes the oldest event from the queue.  Must only be called
+*   by the consumer side of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to read from
+*        event - where to store the event
+*
+* Output: true if an event was read, false if the queue was empty
+*
+********************************************************************/
+bool MIDI_QUEUE_Get(MIDI_QUEUE *queue, USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+/*********************************************************************
+* Function: uint8_t MIDI_QUEUE_Read(MIDI_QUEUE *queue, uint8_t *buffer,
+*                                   uint8_t maxEvents);
+*
+* Overview: Moves up to maxEvents events from the queue into a packet
+*   buffer, 4 bytes per event.  Must only be called by the consumer side
+*   of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to read from
+*        buffer - destination, at least 4*maxEvents bytes long
+*        maxEvents - maximum number of events to read
+*
+* Output: number of bytes written to buffer
+*
+********************************************************************/
+uint8_t MIDI_QUEUE_Read(MIDI_QUEUE *queue, uint8_t *buffer, uint8_t maxEvents);
+
+/*********************************************************************
+* Function: bool MIDI_QUEUE_IsSysExOpen(MIDI_QUEUE *queue);
+*
+* Overview: Checks if the newest event in the queue starts or continues a
+*   SysEx message whose end has not been queued yet.  Must only be called
+*   by the consumer side of the queue.
+*
+* PreCondition: None
+*
+* Input: MIDI_QUEUE *queue - the queue to check
+*
+* Output: true if more events of the same SysEx message are expected
+*
+********************************************************************/
+bool MIDI_QUEUE_IsSysExOpen(MIDI_QUEUE *queue);
+
+
+#endif //MIDI_QUEUE_H
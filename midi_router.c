@@ -0,0 +1,246 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "midi_router.h"
+
+/** CONSTANTS ******************************************************/
+#define MIDI_STATUS_CONTROL_CHANGE  0xB0
+#define MIDI_STATUS_SYSTEM          0xF0
+#define MIDI_STATUS_END_OF_EXCLUSIVE 0xF7
+
+/* Routing table entries */
+#define MIDI_ROUTE_DROP             0x80    //discard the event
+#define MIDI_ROUTE_ZONES            0x40    //the key map gives the channel of the notes
+#define MIDI_ROUTE_KEEP             0x10    //key map: use the channel of the route
+#define MIDI_ROUTE_CHANNEL_MASK     0x0F    //target channel of channel messages
+
+/* Channel messages keep their own channel, system messages go through */
+#define MIDI_ROUTER_DefaultRoute(status)    (((status) < MIDI_STATUS_SYSTEM) ? ((status) & MIDI_ROUTE_CHANNEL_MASK) : 0)
+
+/** VARIABLES ******************************************************/
+/* One entry per status byte (0x80 to 0xFF) and direction, so routing an
+ * event is a single look-up whatever the number of rules. */
+static uint8_t routes[MIDI_ROUTER_DIRECTIONS][0x80];
+/* Target channel of each key for the notes of a zone, per direction */
+static uint8_t keyMap[MIDI_ROUTER_DIRECTIONS][0x80];
+static bool passThrough[MIDI_ROUTER_DIRECTIONS];
+
+/*********************************************************************
+* Function: void MIDI_ROUTER_Initialize(void);
+*
+* Overview: Removes every rule, all of the messages go through unchanged
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_ROUTER_Initialize(void)
+{
+    uint8_t direction;
+    uint8_t i;
+
+    for(direction = 0; direction < MIDI_ROUTER_DIRECTIONS; direction++)
+    {
+        for(i = 0; i < 0x80; i++)
+        {
+            routes[direction][i] = MIDI_ROUTER_DefaultRoute(0x80 | i);
+        }
+
+        for(i = 0; i < 0x80; i++)
+        {
+            keyMap[direction][i] = MIDI_ROUTE_KEEP;
+        }
+
+        passThrough[direction] = true;
+    }
+}
+
+/*********************************************************************
+* Function: bool MIDI_ROUTER_AddRule(const MIDI_ROUTER_RULE *rule);
+*
+* Overview: Compiles a rule into the routing tables.  Rules added later
+*   take precedence over the previous ones.
+*
+* PreCondition: None
+*
+* Input: rule - the rule to add
+*
+* Output: true if the rule was added, false if it is not valid
+*
+********************************************************************/
+bool MIDI_ROUTER_AddRule(const MIDI_ROUTER_RULE *rule)
+{
+    uint8_t direction;
+    uint8_t status;
+    uint8_t key;
+    uint8_t *route;
+
+    if( (rule->directions == 0) || ((rule->directions & ~(MIDI_RULE_TO_CDC | MIDI_RULE_TO_MIDI)) != 0) ||
+        (rule->action > MIDI_RULE_PASS) || (rule->statusFirst < 0x80) ||
+        (rule->statusLast < rule->statusFirst) || (rule->channel > 0x0F) )
+    {
+        return false;
+    }
+
+    if( (rule->action == MIDI_RULE_ZONE) &&
+        ((rule->keyLast > 0x7F) || (rule->keyLast < rule->keyFirst)) )
+    {
+        return false;
+    }
+
+    for(direction = 0; direction < MIDI_ROUTER_DIRECTIONS; direction++)
+    {
+        if((rule->directions & (1 << direction)) == 0)
+        {
+            continue;
+        }
+
+        passThrough[direction] = false;
+
+        //status is incremented at the end of the loop so that 0xFF does not
+        //  wrap around
+        status = rule->statusFirst;
+        while(true)
+        {
+            route = &routes[direction][status & 0x7F];
+
+            switch(rule->action)
+            {
+                case MIDI_RULE_DROP:
+                    *route = MIDI_ROUTE_DROP;
+                    break;
+
+                case MIDI_RULE_CHANNEL:
+                    if(status < MIDI_STATUS_SYSTEM)
+                    {
+                        *route = rule->channel;
+                    }
+                    break;
+
+                case MIDI_RULE_ZONE:
+                    //Zones only apply to the messages carrying a key number
+                    if(status < MIDI_STATUS_CONTROL_CHANGE)
+                    {
+                        *route = (*route & MIDI_ROUTE_CHANNEL_MASK) | MIDI_ROUTE_ZONES;
+                    }
+                    break;
+
+                default:
+                    *route = MIDI_ROUTER_DefaultRoute(status);
+                    break;
+            }
+
+            if(status == rule->statusLast)
+            {
+                break;
+            }
+            status++;
+        }
+
+        if(rule->action == MIDI_RULE_ZONE)
+        {
+            for(key = rule->keyFirst; key <= rule->keyLast; key++)
+            {
+                keyMap[direction][key] = rule->channel;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*********************************************************************
+* Function: bool MIDI_ROUTER_IsPassThrough(uint8_t direction);
+*
+* Overview: Checks if no rule was added for a direction, so its events can
+*   go through without being routed
+*
+* PreCondition: None
+*
+* Input: uint8_t direction - MIDI_ROUTER_TO_CDC or MIDI_ROUTER_TO_MIDI
+*
+* Output: true if the events of this direction are left unchanged
+*
+********************************************************************/
+bool MIDI_ROUTER_IsPassThrough(uint8_t direction)
+{
+    return passThrough[direction];
+}
+
+/*********************************************************************
+* Function: bool MIDI_ROUTER_Route(uint8_t direction,
+*                                  USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Applies the routing table of a direction to an event, moving
+*   it to another channel if needed
+*
+* PreCondition: None
+*
+* Input: uint8_t direction - MIDI_ROUTER_TO_CDC or MIDI_ROUTER_TO_MIDI
+*        event - the event to route, modified in place
+*
+* Output: true if the event goes on, false if it has to be dropped
+*
+********************************************************************/
+bool MIDI_ROUTER_Route(uint8_t direction, USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    uint8_t status = event->DATA_0;
+    uint8_t route;
+    uint8_t channel;
+
+    //The packets continuing or ending a SysEx message may start with a data
+    //  byte, or with the End of Exclusive alone (CIN 0x5)
+    if( (status < 0x80) ||
+        ((event->CodeIndexNumber == MIDI_CIN_SYSEX_ENDS_1) && (status == MIDI_STATUS_END_OF_EXCLUSIVE)) )
+    {
+        status = MIDI_STATUS_SYSTEM;
+    }
+
+    route = routes[direction][status & 0x7F];
+
+    if((route & MIDI_ROUTE_DROP) != 0)
+    {
+        return false;
+    }
+
+    if(status < MIDI_STATUS_SYSTEM)
+    {
+        channel = route;
+
+        if((route & MIDI_ROUTE_ZONES) != 0)
+        {
+            channel = keyMap[direction][event->DATA_1 & 0x7F];
+            if((channel & MIDI_ROUTE_KEEP) != 0)
+            {
+                channel = route;
+            }
+        }
+
+        event->DATA_0 = (status & 0xF0) | (channel & MIDI_ROUTE_CHANNEL_MASK);
+    }
+
+    return true;
+}
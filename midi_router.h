@@ -0,0 +1,128 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef MIDI_ROUTER_H
+#define MIDI_ROUTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usb_device_midi.h"
+
+/*** Router Definitions *********************************************/
+
+/* Directions of the bridge, each one has its own routing table */
+#define MIDI_ROUTER_TO_CDC          0   //MIDI OUT endpoint to CDC port
+#define MIDI_ROUTER_TO_MIDI         1   //CDC port to MIDI IN endpoint
+#define MIDI_ROUTER_DIRECTIONS      2
+
+/* Rule actions */
+#define MIDI_RULE_DROP              0   //discard the matching messages
+#define MIDI_RULE_CHANNEL           1   //move the matching channel messages to channel
+#define MIDI_RULE_ZONE              2   //move the matching notes with a key in
+                                        //  [keyFirst, keyLast] to channel
+#define MIDI_RULE_PASS              3   //undo the previous rules for the matching messages
+
+/* Rule bit-map of directions */
+#define MIDI_RULE_TO_CDC            (1 << MIDI_ROUTER_TO_CDC)
+#define MIDI_RULE_TO_MIDI           (1 << MIDI_ROUTER_TO_MIDI)
+
+/* A routing rule, as sent by the host (8 bytes).  The rule applies to the
+ * messages whose status byte is in [statusFirst, statusLast], for instance
+ * 0xFE-0xFE for active sensing, or 0x90-0x9F for the note on messages of
+ * every channel.  SysEx data bytes, and the End of Exclusive (0xF7) sent
+ * alone in its packet, are matched as status 0xF0.
+ *
+ * Rules are not stored: each one is compiled into the routing tables as it
+ * arrives, on top of the previous ones, so the cost of routing an event does
+ * not depend on the number of rules. */
+typedef struct
+{
+    uint8_t directions;     //MIDI_RULE_TO_CDC and/or MIDI_RULE_TO_MIDI
+    uint8_t action;         //MIDI_RULE_xxx
+    uint8_t statusFirst;
+    uint8_t statusLast;
+    uint8_t channel;        //target channel (0-15) of MIDI_RULE_CHANNEL and MIDI_RULE_ZONE
+    uint8_t keyFirst;       //key range of MIDI_RULE_ZONE
+    uint8_t keyLast;
+    uint8_t reserved;
+} MIDI_ROUTER_RULE;
+
+/*********************************************************************
+* Function: void MIDI_ROUTER_Initialize(void);
+*
+* Overview: Removes every rule, all of the messages go through unchanged
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void MIDI_ROUTER_Initialize(void);
+
+/*********************************************************************
+* Function: bool MIDI_ROUTER_AddRule(const MIDI_ROUTER_RULE *rule);
+*
+* Overview: Compiles a rule into the routing tables.  Rules added later
+*   take precedence over the previous ones.
+*
+* PreCondition: None
+*
+* Input: rule - the rule to add
+*
+* Output: true if the rule was added, false if it is not valid
+*
+********************************************************************/
+bool MIDI_ROUTER_AddRule(const MIDI_ROUTER_RULE *rule);
+
+/*********************************************************************
+* Function: bool MIDI_ROUTER_IsPassThrough(uint8_t direction);
+*
+* Overview: Checks if no rule was added for a direction, so its events can
+*   go through without being routed
+*
+* PreCondition: None
+*
+* Input: uint8_t direction - MIDI_ROUTER_TO_CDC or MIDI_ROUTER_TO_MIDI
+*
+* Output: true if the events of this direction are left unchanged
+*
+********************************************************************/
+bool MIDI_ROUTER_IsPassThrough(uint8_t direction);
+
+/*********************************************************************
+* Function: bool MIDI_ROUTER_Route(uint8_t direction,
+*                                  USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Applies the routing table of a direction to an event, moving
+*   it to another channel if needed
+*
+* PreCondition: None
+*
+* Input: uint8_t direction - MIDI_ROUTER_TO_CDC or MIDI_ROUTER_TO_MIDI
+*        event - the event to route, modified in place
+*
+* Output: true if the event goes on, false if it has to be dropped
+*
+********************************************************************/
+bool MIDI_ROUTER_Route(uint8_t direction, USB_AUDIO_MIDI_EVENT_PACKET *event);
+
+#endif //MIDI_ROUTER_H
@@ -0,0 +1,208 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <xc.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "residency.h"
+#include "cycle_counter.h"
+
+#if defined(BRIDGE_RESIDENCY)
+
+/** VARIABLES ******************************************************/
+RESIDENCY_STATS residencyStats[RESIDENCY_DIRECTIONS];
+
+static volatile uint8_t residencyFrame;         //frames started, modulo 256
+static volatile uint16_t residencyFrameStart;   //Timer1 at the last SOF
+
+/*********************************************************************
+* Function: void RESIDENCY_Initialize(void);
+*
+* Overview: Clears the statistics
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Initialize(void)
+{
+    RESIDENCY_Clear();
+
+    residencyFrame = 0;
+    residencyFrameStart = CYCLE_COUNTER_Now();
+}
+
+/*********************************************************************
+* Function: void RESIDENCY_StartOfFrame(void);
+*
+* Overview: Advances the frame counter. Must be called from the
+*   EVENT_SOF event handler.
+*
+* PreCondition: RESIDENCY_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_StartOfFrame(void)
+{
+    residencyFrameStart = CYCLE_COUNTER_Now();
+    residencyFrame++;
+}
+
+/*********************************************************************
+* Function: void RESIDENCY_Stamp(RESIDENCY_STAMP *stamp);
+*
+* Overview: Stamps an event entering the bridge with the current time
+*
+* PreCondition: RESIDENCY_Initialize() was called
+*
+* Input: RESIDENCY_STAMP *stamp - where to store the time
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Stamp(RESIDENCY_STAMP *stamp)
+{
+    uint8_t frame;
+
+    //The SOF interrupt may update the frame in the middle of the 2 byte
+    //  read of its start, read again if it did
+    do
+    {
+        frame = residencyFrame;
+        stamp->ticks = CYCLE_COUNTER_Now() - residencyFrameStart;
+    } while(frame != residencyFrame);
+
+    stamp->frame = frame;
+}
+
+/*********************************************************************
+* Function: void RESIDENCY_Record(RESIDENCY_STATS *stats,
+*                                 const RESIDENCY_STAMP *stamp);
+*
+* Overview: Adds the time elapsed since an event was stamped to the
+*   statistics of its direction, as the event leaves the bridge
+*
+* PreCondition: The event was stamped with RESIDENCY_Stamp()
+*
+* Input: RESIDENCY_STATS *stats - statistics of the direction, NULL if
+*           the event is not measured
+*        stamp - stamp of the event
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Record(RESIDENCY_STATS *stats, const RESIDENCY_STAMP *stamp)
+{
+    RESIDENCY_STAMP now;
+    uint8_t frames;
+    int32_t ticks;
+    uint8_t bin;
+
+    if(stats == NULL)
+    {
+        return;
+    }
+
+    RESIDENCY_Stamp(&now);
+
+    //Events queued for 256 frames or more are counted 256 frames short
+    frames = now.frame - stamp->frame;
+    ticks = ((int32_t)frames * RESIDENCY_TICKS_PER_FRAME) + now.ticks - stamp->ticks;
+
+    //A late SOF interrupt may make the ticks since the SOF overlap the
+    //  next frame
+    if(ticks < 0)
+    {
+        ticks = 0;
+    }
+
+    if(stats->count == 0)
+    {
+        stats->min = ticks;
+        stats->max = ticks;
+        stats->mean = ticks;
+    }
+    else
+    {
+        if((uint32_t)ticks < stats->min)
+        {
+            stats->min = ticks;
+        }
+        if((uint32_t)ticks > stats->max)
+        {
+            stats->max = ticks;
+        }
+        stats->mean = stats->mean - (stats->mean >> 4) + ((uint32_t)ticks >> 4);
+    }
+    stats->count++;
+
+    if(frames < 4)
+    {
+        bin = frames;
+    }
+    else if(frames < 8)
+    {
+        bin = 4;
+    }
+    else if(frames < 16)
+    {
+        bin = 5;
+    }
+    else if(frames < 32)
+    {
+        bin = 6;
+    }
+    else
+    {
+        bin = 7;
+    }
+
+    if(stats->histogram[bin] != UINT16_MAX)
+    {
+        stats->histogram[bin]++;
+    }
+}
+
+/*********************************************************************
+* Function: void RESIDENCY_Clear(void);
+*
+* Overview: Clears the statistics of both directions
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Clear(void)
+{
+    memset(residencyStats, 0, sizeof(residencyStats));
+}
+
+#endif //BRIDGE_RESIDENCY
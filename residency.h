@@ -0,0 +1,150 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb_config.h"
+
+/*** Residency Definitions ******************************************/
+/* Time spent by the events inside the bridge, from the moment they are
+ * queued on one side until they are taken out to be sent on the other one.
+ *
+ * An event is stamped with the low byte of a frame counter advanced by every
+ * SOF, and with the Timer1 ticks elapsed since that SOF, read with
+ * CYCLE_COUNTER_Now().  Timer1 runs from the instruction clock with a 1:1
+ * prescaler, so a frame is 12000 ticks long. */
+#define RESIDENCY_TICKS_PER_FRAME   12000UL
+
+/* Directions of the bridge */
+#define RESIDENCY_TO_CDC            0       //MIDI OUT endpoint to CDC IN endpoint
+#define RESIDENCY_TO_MIDI           1       //CDC OUT endpoint to MIDI IN endpoint
+#define RESIDENCY_DIRECTIONS        2
+
+/* Histogram bins, by number of frames started while the event was queued:
+ * 0, 1, 2, 3, 4-7, 8-15, 16-31 and 32 or more */
+#define RESIDENCY_BINS              8
+
+typedef struct
+{
+    uint8_t frame;      //low byte of the frame counter
+    uint16_t ticks;     //Timer1 ticks since the SOF of that frame
+} RESIDENCY_STAMP;
+
+/* Statistics of one direction, sent as they are in memory (little endian)
+ * by the VENDOR_REQUEST_RESIDENCY_READ request */
+typedef struct
+{
+    uint32_t count;                         //events measured
+    uint32_t min;                           //shortest residency, in Timer1 ticks
+    uint32_t max;                           //longest residency, in Timer1 ticks
+    uint32_t mean;                          //rolling mean, each event weighs 1/16
+    uint16_t histogram[RESIDENCY_BINS];     //events per bin, saturated at 65535
+} RESIDENCY_STATS;
+
+#if defined(BRIDGE_RESIDENCY)
+
+extern RESIDENCY_STATS residencyStats[RESIDENCY_DIRECTIONS];
+
+/*********************************************************************
+* Function: void RESIDENCY_Initialize(void);
+*
+* Overview: Clears the statistics
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Initialize(void);
+
+/*********************************************************************
+* Function: void RESIDENCY_StartOfFrame(void);
+*
+* Overview: Advances the frame counter. Must be called from the
+*   EVENT_SOF event handler.
+*
+* PreCondition: RESIDENCY_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_StartOfFrame(void);
+
+/*********************************************************************
+* Function: void RESIDENCY_Stamp(RESIDENCY_STAMP *stamp);
+*
+* Overview: Stamps an event entering the bridge with the current time
+*
+* PreCondition: RESIDENCY_Initialize() was called
+*
+* Input: RESIDENCY_STAMP *stamp - where to store the time
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Stamp(RESIDENCY_STAMP *stamp);
+
+/*********************************************************************
+* Function: void RESIDENCY_Record(RESIDENCY_STATS *stats,
+*                                 const RESIDENCY_STAMP *stamp);
+*
+* Overview: Adds the time elapsed since an event was stamped to the
+*   statistics of its direction, as the event leaves the bridge
+*
+* PreCondition: The event was stamped with RESIDENCY_Stamp()
+*
+* Input: RESIDENCY_STATS *stats - statistics of the direction, NULL if
+*           the event is not measured
+*        stamp - stamp of the event
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Record(RESIDENCY_STATS *stats, const RESIDENCY_STAMP *stamp);
+
+/*********************************************************************
+* Function: void RESIDENCY_Clear(void);
+*
+* Overview: Clears the statistics of both directions
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void RESIDENCY_Clear(void);
+
+#else
+
+#define RESIDENCY_Initialize()
+#define RESIDENCY_StartOfFrame()
+
+#endif //BRIDGE_RESIDENCY
+
+#endif //RESIDENCY_H
@@ -0,0 +1,165 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+
+/** INCLUDES *******************************************************/
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb.h"
+
+#include "scheduler.h"
+#include "cycle_counter.h"
+#include "app_device_audio_midi.h"
+#include "app_device_cdc_basic.h"
+#include "app_device_vendor.h"
+
+#if defined(BRIDGE_SCHEDULER)
+
+/** TYPE DEFINITIONS ************************************************/
+typedef struct
+{
+    void (*run)(void);
+    CYCLE_COUNTER_SECTION section;      //cycle counter region of the task
+} SCHEDULER_TASK_ENTRY;
+
+/** VARIABLES ******************************************************/
+SCHEDULER_STATS schedulerStats[SCHEDULER_TASKS];
+volatile uint8_t schedulerReady;        //one bit per SCHEDULER_TASK
+
+static const SCHEDULER_TASK_ENTRY schedulerTasks[SCHEDULER_TASKS] =
+{
+    { APP_DeviceAudioMIDITasks,     CYCLE_COUNTER_MIDI_TASKS },
+    { APP_DeviceCDCBasicDemoTasks,  CYCLE_COUNTER_CDC_TASKS },
+    { APP_DeviceVendorTasks,        CYCLE_COUNTER_VENDOR_TASKS }
+};
+
+/*********************************************************************
+* Function: void SCHEDULER_Initialize(void);
+*
+* Overview: Clears the statistics and marks every task ready
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void SCHEDULER_Initialize(void)
+{
+    SCHEDULER_Clear();
+    SCHEDULER_SetAllReady();
+}
+
+/*********************************************************************
+* Function: void SCHEDULER_Tasks(void);
+*
+* Overview: Runs once each task marked ready so far, or idles the CPU
+*   until the next interrupt when none is.  Called from the main loop in
+*   place of the application tasks.
+*
+* PreCondition: SCHEDULER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void SCHEDULER_Tasks(void)
+{
+    SCHEDULER_STATS *stats;
+    uint16_t start;
+    uint16_t ticks;
+    uint8_t ready;
+    uint8_t task;
+
+    //Tasks marked ready while the others run are left for the next pass
+    USBMaskInterrupts();
+    ready = schedulerReady;
+    schedulerReady = 0;
+    USBUnmaskInterrupts();
+
+    if(ready == 0)
+    {
+        /* With GIE cleared an interrupt flagged before SLEEP still wakes the
+         * CPU up, right away, and its handler runs once GIE is set again, so
+         * a task marked ready after the check is not missed.  In idle mode the
+         * USB module keeps its clock.  The simulated host runs between two
+         * passes of the main loop instead. */
+        #if !defined(USB_SIMULATION)
+            INTCONbits.GIE = 0;
+            if(schedulerReady == 0)
+            {
+                OSCCONbits.IDLEN = 1;
+                Sleep();
+            }
+            INTCONbits.GIE = 1;
+        #endif
+        return;
+    }
+
+    for(task = 0; task < SCHEDULER_TASKS; task++)
+    {
+        if((ready & (1 << task)) == 0)
+        {
+            continue;
+        }
+
+        //The run time includes the interrupts taken meanwhile
+        CYCLE_COUNTER_Enter(schedulerTasks[task].section);
+        start = CYCLE_COUNTER_Now();
+        schedulerTasks[task].run();
+        ticks = CYCLE_COUNTER_Now() - start;
+        CYCLE_COUNTER_Exit(schedulerTasks[task].section);
+
+        stats = &schedulerStats[task];
+        stats->runs++;
+
+        if(ticks > stats->max)
+        {
+            stats->max = ticks;
+        }
+    }
+}
+
+/*********************************************************************
+* Function: void SCHEDULER_Clear(void);
+*
+* Overview: Clears the statistics of every task
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void SCHEDULER_Clear(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < SCHEDULER_TASKS; i++)
+    {
+        schedulerStats[i].runs = 0;
+        schedulerStats[i].max = 0;
+    }
+}
+
+#endif //BRIDGE_SCHEDULER
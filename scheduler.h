@@ -0,0 +1,146 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb_config.h"
+
+/*** Scheduler Definitions ******************************************/
+
+/* The application tasks of the main loop.  A task only runs once it has
+ * been marked ready, by the USB events that may give it work (transfers,
+ * SOF deadlines, button edges sampled on the SOF, vendor requests), and
+ * the CPU idles until the next interrupt when no task is ready.  Tasks run
+ * in this order. */
+typedef enum
+{
+    SCHEDULER_TASK_MIDI,            //APP_DeviceAudioMIDITasks()
+    SCHEDULER_TASK_CDC,             //APP_DeviceCDCBasicDemoTasks()
+    SCHEDULER_TASK_VENDOR,          //APP_DeviceVendorTasks()
+    SCHEDULER_TASKS
+} SCHEDULER_TASK;
+
+#define SCHEDULER_ALL_TASKS         ((1 << SCHEDULER_TASKS) - 1)
+
+/* Statistics of one task, sent as they are in memory (little endian) by
+ * the VENDOR_REQUEST_SCHEDULER_READ request.  Run times are in Timer1
+ * ticks, one per instruction cycle as for cycle_counter.h. */
+typedef struct
+{
+    uint32_t runs;      //times the task ran
+    uint16_t max;       //longest run, must not exceed 65535 ticks
+} SCHEDULER_STATS;
+
+#if defined(BRIDGE_SCHEDULER)
+
+#if !defined(USB_INTERRUPT)
+    #error "BRIDGE_SCHEDULER needs USB_INTERRUPT, the USB interrupt wakes the CPU up"
+#endif
+
+extern SCHEDULER_STATS schedulerStats[SCHEDULER_TASKS];
+extern volatile uint8_t schedulerReady;
+
+/*********************************************************************
+* Function: void SCHEDULER_Initialize(void);
+*
+* Overview: Clears the statistics and marks every task ready
+*
+* PreCondition: CYCLE_COUNTER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void SCHEDULER_Initialize(void);
+
+/*********************************************************************
+* Function: void SCHEDULER_Tasks(void);
+*
+* Overview: Runs once each task marked ready so far, or idles the CPU
+*   until the next interrupt when none is.  Called from the main loop in
+*   place of the application tasks.
+*
+* PreCondition: SCHEDULER_Initialize() was called
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void SCHEDULER_Tasks(void);
+
+/*********************************************************************
+* Function: void SCHEDULER_Clear(void);
+*
+* Overview: Clears the statistics of every task
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void SCHEDULER_Clear(void);
+
+/*********************************************************************
+* Function: void SCHEDULER_SetReady(SCHEDULER_TASK task);
+*
+* Overview: Marks a task ready, it runs on the next SCHEDULER_Tasks().
+*   Meant for the USB event handlers, a single bit set is safe from the
+*   interrupt.
+*
+* PreCondition: None
+*
+* Input: SCHEDULER_TASK task - the task that has work to do
+*
+* Output: None
+*
+********************************************************************/
+#define SCHEDULER_SetReady(task)    (schedulerReady |= (uint8_t)(1 << (task)))
+
+/*********************************************************************
+* Function: void SCHEDULER_SetAllReady(void);
+*
+* Overview: Marks every task ready, when the device state changes
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+#define SCHEDULER_SetAllReady()     (schedulerReady = SCHEDULER_ALL_TASKS)
+
+#else
+
+#define SCHEDULER_Initialize()
+#define SCHEDULER_SetReady(task)
+#define SCHEDULER_SetAllReady()
+
+#endif //BRIDGE_SCHEDULER
+
+#endif //SCHEDULER_H
@@ -0,0 +1,1405 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/* Bridge benchmark run by the simulated host.  Each profile generates raw
+ * MIDI traffic frame by frame for one or both directions of the bridge.
+ * The host sends it as fast as the device takes it, up to
+ * USB_SIM_BENCH_BURST packets back to back on each endpoint per main loop
+ * pass, reads back what comes out of the other endpoint and matches it
+ * against what was sent.  The NAKs of both endpoints are counted, those
+ * of the IN endpoint only while events sent have not come back yet.  Latency
+ * is counted in USB frames from the frame an event was generated in, so
+ * the time it waited on the host side behind NAKed packets is included.
+ * It is also counted in main loop passes, fine enough to tell the main
+ * loop tasks from BRIDGE_TRANSFER_EVENTS apart: running the benchmark
+ * with and without it compares both ways of servicing the endpoints.
+ *
+ * The micro benchmarks time the bridge modules alone, called in a loop by
+ * the host, in wall clock time of the machine running the simulation.
+ */
+
+#if defined(USB_SIM_BENCHMARK)
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "system.h"
+
+#include "usb.h"
+#include "usb_device_midi.h"
+#include "usb_config.h"
+
+#include "midi_parser.h"
+#include "midi_encoder.h"
+#include "midi_router.h"
+#include "copy_bench.h"
+#include "app_device_vendor.h"
+
+#include "usb_sim_host.h"
+#include "usb_sim_bench.h"
+
+/** CONSTANTS ******************************************************/
+#define USB_SIM_BENCH_TO_CDC        0   //MIDI OUT endpoint to CDC IN endpoint
+#define USB_SIM_BENCH_TO_MIDI       1   //CDC OUT endpoint to MIDI IN endpoint
+#define USB_SIM_BENCH_DIRECTIONS    2
+
+//One lane per cable, and one for the realtime messages of every cable
+#define USB_SIM_BENCH_LANE_REALTIME BRIDGE_NUM_CABLES
+#define USB_SIM_BENCH_LANES         (BRIDGE_NUM_CABLES + 1)
+#define USB_SIM_BENCH_ALL_LANES     0xFF
+
+#define USB_SIM_BENCH_PACKET_SIZE   64
+
+#define USB_SIM_BENCH_CABLE_FRAMES  500     //frames of the multi cable profile
+
+#define USB_SIM_BENCH_JITTER_FRAMES 500     //frames of the clock jitter profiles
+#define USB_SIM_BENCH_CLOCK_PERIOD  5       //frames between clock ticks of the jitter profiles
+#define USB_SIM_BENCH_FLOOD_BYTES   120     //SysEx bytes per frame under the clock
+
+#define USB_SIM_BENCH_PARSER_BYTES  4096    //bytes of each parser stream
+#define USB_SIM_BENCH_PARSER_PASSES 2000    //times each stream is parsed
+
+#define USB_SIM_BENCH_ROUTER_EVENTS 4096    //events of the router stream
+#define USB_SIM_BENCH_ROUTER_PASSES 2000    //times the stream is routed
+
+#if defined(BRIDGE_TRANSFER_EVENTS)
+    #define USB_SIM_BENCH_DISPATCH  "transfer_events"
+#else
+    #define USB_SIM_BENCH_DISPATCH  "main_loop"
+#endif
+
+/** TYPES **********************************************************/
+typedef struct
+{
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint32_t frame;                 //frame the event was generated in
+    uint32_t loop;                  //main loop pass the event was generated in
+} USB_SIM_BENCH_EVENT;
+
+typedef struct
+{
+    MIDI_PARSER generators[BRIDGE_NUM_CABLES];  //generated bytes to events, one per cable
+    USB_SIM_BENCH_EVENT events[USB_SIM_BENCH_MAX_EVENTS];
+    uint16_t count;                 //events generated
+    uint16_t sent;                  //events acknowledged by the device
+    uint16_t next[USB_SIM_BENCH_LANES];     //next event expected back in each lane
+
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        MIDI_ENCODER encoder;       //events sent to the CDC OUT endpoint
+        MIDI_PARSER receiver;       //bytes read from the CDC IN endpoint
+    #endif
+
+    uint16_t received;
+    uint32_t bytes[USB_SIM_BENCH_LANES];    //MIDI bytes of the events received in each lane
+    uint16_t unexpected;
+    uint32_t lastFrame;             //frame the last event was received in
+    uint16_t latency[USB_SIM_BENCH_MAX_EVENTS];
+    uint32_t loopLatency[USB_SIM_BENCH_MAX_EVENTS];
+    uint8_t lane[USB_SIM_BENCH_MAX_EVENTS];     //lane of each received event
+    uint16_t realtimeMin;
+    uint16_t realtimeMax;
+    uint32_t realtimeLoopMin;
+    uint32_t realtimeLoopMax;
+    uint16_t realtimeCount;
+    uint32_t outPackets;            //packets acknowledged by the OUT endpoint
+    uint32_t outNaks;
+    uint32_t inPackets;             //packets read from the IN endpoint
+    uint32_t inNaks;                //NAKs while events were on their way
+} USB_SIM_BENCH_STREAM;
+
+typedef struct
+{
+    const char *name;
+    uint8_t directions;             //bit mask of USB_SIM_BENCH_TO_CDC/MIDI
+    uint16_t frames;                //frames traffic is generated for
+    uint8_t cables;                 //cables the traffic uses, each one is also reported alone if more than 1
+    void (*generate)(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+} USB_SIM_BENCH_PROFILE;
+
+/** PRIVATE PROTOTYPES *********************************************/
+static void USB_SIM_BENCH_Sync(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_Notes(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_ControlChanges(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_SysEx(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_ClockAndNotes(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_FullLoad(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_Clock(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+static void USB_SIM_BENCH_ClockAndSysEx(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+#if (BRIDGE_NUM_CABLES > 1) && !defined(BRIDGE_CDC_RAW_MIDI)
+static void USB_SIM_BENCH_MultiCable(USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+#endif
+static void USB_SIM_BENCH_Generate(USB_SIM_BENCH_STREAM *stream, uint8_t cable, const uint8_t *data, uint16_t length);
+static bool USB_SIM_BENCH_Send(uint8_t direction);
+static bool USB_SIM_BENCH_Receive(uint8_t direction);
+static void USB_SIM_BENCH_Match(USB_SIM_BENCH_STREAM *stream, const USB_AUDIO_MIDI_EVENT_PACKET *event);
+static uint8_t USB_SIM_BENCH_Lane(const USB_AUDIO_MIDI_EVENT_PACKET *event);
+static void USB_SIM_BENCH_RunProfile(const USB_SIM_BENCH_PROFILE *profile, FILE *results);
+static void USB_SIM_BENCH_Report(const USB_SIM_BENCH_PROFILE *profile, uint8_t direction, uint8_t lane, uint32_t start, FILE *results);
+static int USB_SIM_BENCH_Compare(const void *a, const void *b);
+static int USB_SIM_BENCH_CompareLoops(const void *a, const void *b);
+static void USB_SIM_BENCH_Parser(FILE *results);
+static void USB_SIM_BENCH_Router(FILE *results);
+static double USB_SIM_BENCH_Seconds(void);
+#if defined(BRIDGE_CYCLE_COUNT)
+static void USB_SIM_BENCH_Copy(void);
+#endif
+
+/** VARIABLES ******************************************************/
+#define USB_SIM_BENCH_BOTH  ((1 << USB_SIM_BENCH_TO_CDC) | (1 << USB_SIM_BENCH_TO_MIDI))
+
+static const USB_SIM_BENCH_PROFILE syncProfile =
+{
+    "sync",                 USB_SIM_BENCH_BOTH,             1,      1,  USB_SIM_BENCH_Sync
+};
+
+static const USB_SIM_BENCH_PROFILE profiles[] =
+{
+    { "single_notes",       (1 << USB_SIM_BENCH_TO_CDC),    1000,   1,  USB_SIM_BENCH_Notes },
+    { "single_notes",       (1 << USB_SIM_BENCH_TO_MIDI),   1000,   1,  USB_SIM_BENCH_Notes },
+    { "dense_cc",           (1 << USB_SIM_BENCH_TO_CDC),    1000,   1,  USB_SIM_BENCH_ControlChanges },
+    { "dense_cc",           (1 << USB_SIM_BENCH_TO_MIDI),   1000,   1,  USB_SIM_BENCH_ControlChanges },
+    { "sysex_4k",           (1 << USB_SIM_BENCH_TO_CDC),    1,      1,  USB_SIM_BENCH_SysEx },
+    { "sysex_4k",           (1 << USB_SIM_BENCH_TO_MIDI),   1,      1,  USB_SIM_BENCH_SysEx },
+    { "clock_24ppqn_notes", (1 << USB_SIM_BENCH_TO_CDC),    1000,   1,  USB_SIM_BENCH_ClockAndNotes },
+    { "clock_24ppqn_notes", (1 << USB_SIM_BENCH_TO_MIDI),   1000,   1,  USB_SIM_BENCH_ClockAndNotes },
+    { "full_load",          USB_SIM_BENCH_BOTH,             1000,   1,  USB_SIM_BENCH_FullLoad },
+    { "clock_jitter",       (1 << USB_SIM_BENCH_TO_CDC),    USB_SIM_BENCH_JITTER_FRAMES,    1,  USB_SIM_BENCH_Clock },
+    { "clock_jitter",       (1 << USB_SIM_BENCH_TO_MIDI),   USB_SIM_BENCH_JITTER_FRAMES,    1,  USB_SIM_BENCH_Clock },
+    { "clock_jitter_sysex", (1 << USB_SIM_BENCH_TO_CDC),    USB_SIM_BENCH_JITTER_FRAMES,    1,  USB_SIM_BENCH_ClockAndSysEx },
+    { "clock_jitter_sysex", (1 << USB_SIM_BENCH_TO_MIDI),   USB_SIM_BENCH_JITTER_FRAMES,    1,  USB_SIM_BENCH_ClockAndSysEx },
+    #if (BRIDGE_NUM_CABLES > 1) && !defined(BRIDGE_CDC_RAW_MIDI)
+    { "multi_cable",        (1 << USB_SIM_BENCH_TO_CDC),    USB_SIM_BENCH_CABLE_FRAMES, BRIDGE_NUM_CABLES,  USB_SIM_BENCH_MultiCable },
+    { "multi_cable",        (1 << USB_SIM_BENCH_TO_MIDI),   USB_SIM_BENCH_CABLE_FRAMES, BRIDGE_NUM_CABLES,  USB_SIM_BENCH_MultiCable },
+    #endif
+};
+
+static const char *directionNames[USB_SIM_BENCH_DIRECTIONS] = { "midi_to_cdc", "cdc_to_midi" };
+
+//MIDI bytes carried by each Code Index Number, as in midi_encoder.c
+static const uint8_t cinLengths[16] = { 0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1 };
+
+static USB_SIM_BENCH_STREAM streams[USB_SIM_BENCH_DIRECTIONS];
+
+/*********************************************************************
+* Function: void USB_SIM_BENCH_Run(void);
+*
+* Overview: Runs every traffic profile through the bridge and writes
+*   the throughput, latency, NAK and drop counts of each direction to the
+*   results file, USB_SIM_BENCH_RESULTS unless the environment variable
+*   of the same name gives another path.  With BRIDGE_CYCLE_COUNT the
+*   cycles per byte of the copy paths of copy_bench.h are then written to
+*   USB_SIM_BENCH_COPY_RESULTS the same way.
+*
+* PreCondition: Only available when built with USB_SIM_BENCHMARK. Runs
+*   on the host coroutine once the device is configured.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_BENCH_Run(void)
+{
+    const char *path = getenv("USB_SIM_BENCH_RESULTS");
+    FILE *results;
+    uint8_t i;
+
+    if(path == NULL)
+    {
+        path = USB_SIM_BENCH_RESULTS;
+    }
+
+    results = fopen(path, "w");
+    if(results == NULL)
+    {
+        USB_SIM_HOST_Fail(path);
+    }
+
+    fprintf(results, "profile,direction,cable,generated,received,dropped,unexpected,events_per_second,kbytes_per_second,"
+                     "latency_p50_frames,latency_p99_frames,latency_max_frames,"
+                     "realtime_latency_max_frames,realtime_jitter_frames,"
+                     "realtime_latency_max_loops,realtime_jitter_loops,"
+                     "latency_p50_loops,latency_p99_loops,latency_max_loops,"
+                     "out_packets,out_naks,in_packets,in_naks,dispatch\n");
+
+    //The converters on both ends keep their running status from one
+    //  profile to the next, the device ones are brought in step with the
+    //  host ones first
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        for(i = 0; i < USB_SIM_BENCH_DIRECTIONS; i++)
+        {
+            MIDI_ENCODER_Initialize(&streams[i].encoder);
+            MIDI_PARSER_Initialize(&streams[i].receiver, 0);
+        }
+    #endif
+    USB_SIM_BENCH_RunProfile(&syncProfile, NULL);
+
+    for(i = 0; i < (sizeof(profiles) / sizeof(profiles[0])); i++)
+    {
+        USB_SIM_BENCH_RunProfile(&profiles[i], results);
+    }
+
+    fclose(results);
+
+    #if defined(BRIDGE_CYCLE_COUNT)
+        USB_SIM_BENCH_Copy();
+    #endif
+
+    path = getenv("USB_SIM_BENCH_MICRO_RESULTS");
+    if(path == NULL)
+    {
+        path = USB_SIM_BENCH_MICRO_RESULTS;
+    }
+
+    results = fopen(path, "w");
+    if(results == NULL)
+    {
+        USB_SIM_HOST_Fail(path);
+    }
+
+    fprintf(results, "benchmark,case,value,unit\n");
+    USB_SIM_BENCH_Parser(results);
+    USB_SIM_BENCH_Router(results);
+    fclose(results);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_RunProfile(
+*               const USB_SIM_BENCH_PROFILE *profile, FILE *results);
+*
+* Overview: Generates the traffic of a profile, then gives the bridge
+*   up to USB_SIM_BENCH_DRAIN_FRAMES frames to deliver all of it, and
+*   reports the result of each direction.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: profile - the profile to run
+*        results - results file, NULL to leave the profile out
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_RunProfile(const USB_SIM_BENCH_PROFILE *profile, FILE *results)
+{
+    uint32_t start = USB_SIM_HOST_Frame();
+    uint32_t generated = 0;
+    uint32_t frame;
+    bool done;
+    uint8_t direction;
+    uint8_t burst;
+    uint8_t lane;
+
+    for(direction = 0; direction < USB_SIM_BENCH_DIRECTIONS; direction++)
+    {
+        USB_SIM_BENCH_STREAM *stream = &streams[direction];
+
+        for(lane = 0; lane < BRIDGE_NUM_CABLES; lane++)
+        {
+            MIDI_PARSER_Initialize(&stream->generators[lane], lane);
+        }
+        for(lane = 0; lane < USB_SIM_BENCH_LANES; lane++)
+        {
+            stream->next[lane] = 0;
+            stream->bytes[lane] = 0;
+        }
+        stream->count = 0;
+        stream->sent = 0;
+        stream->received = 0;
+        stream->unexpected = 0;
+        stream->lastFrame = start;
+        stream->realtimeMin = UINT16_MAX;
+        stream->realtimeMax = 0;
+        stream->realtimeLoopMin = UINT32_MAX;
+        stream->realtimeLoopMax = 0;
+        stream->realtimeCount = 0;
+        stream->outPackets = 0;
+        stream->outNaks = 0;
+        stream->inPackets = 0;
+        stream->inNaks = 0;
+    }
+
+    do
+    {
+        frame = USB_SIM_HOST_Frame() - start;
+        done = (frame >= profile->frames);
+
+        //Traffic of every frame started since the last pass
+        for(; (generated <= frame) && (generated < profile->frames); generated++)
+        {
+            for(direction = 0; direction < USB_SIM_BENCH_DIRECTIONS; direction++)
+            {
+                if((profile->directions & (1 << direction)) != 0)
+                {
+                    profile->generate(&streams[direction], generated);
+                }
+            }
+        }
+
+        for(direction = 0; direction < USB_SIM_BENCH_DIRECTIONS; direction++)
+        {
+            if((profile->directions & (1 << direction)) == 0)
+            {
+                continue;
+            }
+
+            for(burst = 0; (burst < USB_SIM_BENCH_BURST) && USB_SIM_BENCH_Send(direction); burst++);
+            for(burst = 0; (burst < USB_SIM_BENCH_BURST) && USB_SIM_BENCH_Receive(direction); burst++);
+
+            if(streams[direction].received < streams[direction].count)
+            {
+                done = false;
+            }
+        }
+
+        USB_SIM_HOST_Yield();
+    } while((done == false) && (frame < (profile->frames + USB_SIM_BENCH_DRAIN_FRAMES)));
+
+    for(direction = 0; direction < USB_SIM_BENCH_DIRECTIONS; direction++)
+    {
+        if((results != NULL) && ((profile->directions & (1 << direction)) != 0))
+        {
+            USB_SIM_BENCH_Report(profile, direction, USB_SIM_BENCH_ALL_LANES, start, results);
+
+            //Each cable alone, to compare how they share the bridge
+            for(lane = 0; (profile->cables > 1) && (lane < profile->cables); lane++)
+            {
+                USB_SIM_BENCH_Report(profile, direction, lane, start, results);
+            }
+        }
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Sync(USB_SIM_BENCH_STREAM *stream,
+*               uint32_t frame);
+*
+* Overview: A tune request, a system common message that cancels the
+*   running status of the MIDI converters of the bridge.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Sync(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    static const uint8_t tuneRequest = 0xF6;
+
+    USB_SIM_BENCH_Generate(stream, 0, &tuneRequest, 1);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Notes(USB_SIM_BENCH_STREAM *stream,
+*               uint32_t frame);
+*
+* Overview: Single notes, a note on or a note off every 10 frames.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Notes(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    uint8_t message[3];
+
+    if((frame % 10) == 0)
+    {
+        message[0] = ((frame / 10) & 0x01) ? 0x80 : 0x90;
+        message[1] = 60 + ((frame / 20) % 12);
+        message[2] = ((frame / 10) & 0x01) ? 0x00 : 0x64;
+
+        USB_SIM_BENCH_Generate(stream, 0, message, sizeof(message));
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_ControlChanges(
+*               USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+*
+* Overview: Dense automation, 8 controllers moving on one channel every
+*   frame, the channel changing from frame to frame.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_ControlChanges(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    uint8_t message[3];
+    uint8_t i;
+
+    for(i = 0; i < 8; i++)
+    {
+        message[0] = 0xB0 | (frame & 0x0F);
+        message[1] = 1 + i;
+        message[2] = (frame + i) & 0x7F;
+
+        USB_SIM_BENCH_Generate(stream, 0, message, sizeof(message));
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_SysEx(USB_SIM_BENCH_STREAM *stream,
+*               uint32_t frame);
+*
+* Overview: A 4 KB SysEx dump, all of it generated in the first frame.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_SysEx(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    uint8_t dump[4096];
+    uint16_t i;
+
+    dump[0] = 0xF0;
+    for(i = 1; i < (sizeof(dump) - 1); i++)
+    {
+        dump[i] = (uint8_t)(i + frame) & 0x7F;
+    }
+    dump[sizeof(dump) - 1] = 0xF7;
+
+    USB_SIM_BENCH_Generate(stream, 0, dump, sizeof(dump));
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_ClockAndNotes(
+*               USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+*
+* Overview: MIDI clock at 24 PPQN and 120 BPM, 48 ticks a second, under
+*   4 note chords every 10 frames.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_ClockAndNotes(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    static const uint8_t clock = 0xF8;
+    uint8_t chord[7];
+    uint8_t i;
+
+    if((frame == 0) || (((frame * 48) / 1000) != (((frame - 1) * 48) / 1000)))
+    {
+        USB_SIM_BENCH_Generate(stream, 0, &clock, 1);
+    }
+
+    if((frame % 10) == 0)
+    {
+        //Running status
+        chord[0] = 0x90;
+        for(i = 0; i < 3; i++)
+        {
+            chord[1 + (2 * i)] = 60 + (4 * i) + ((frame / 10) % 5);
+            chord[2 + (2 * i)] = ((frame / 10) & 0x01) ? 0x00 : 0x64;
+        }
+
+        USB_SIM_BENCH_Generate(stream, 0, chord, sizeof(chord));
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_FullLoad(USB_SIM_BENCH_STREAM *stream,
+*               uint32_t frame);
+*
+* Overview: A whole packet of events every frame, meant to be run in
+*   both directions at once.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_FullLoad(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    uint8_t message[3];
+    uint8_t i;
+
+    for(i = 0; i < (USB_SIM_BENCH_PACKET_SIZE / sizeof(USB_AUDIO_MIDI_EVENT_PACKET)); i++)
+    {
+        message[0] = ((i & 0x01) ? 0x80 : 0x90) | (i >> 1);
+        message[1] = (frame + i) & 0x7F;
+        message[2] = (i & 0x01) ? 0x00 : 0x64;
+
+        USB_SIM_BENCH_Generate(stream, 0, message, sizeof(message));
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Clock(USB_SIM_BENCH_STREAM *stream,
+*               uint32_t frame);
+*
+* Overview: MIDI clock alone, a tick every USB_SIM_BENCH_CLOCK_PERIOD
+*   frames, the reference the jitter under a SysEx flood is compared to.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Clock(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    static const uint8_t clock = 0xF8;
+
+    if((frame % USB_SIM_BENCH_CLOCK_PERIOD) == 0)
+    {
+        USB_SIM_BENCH_Generate(stream, 0, &clock, 1);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_ClockAndSysEx(
+*               USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+*
+* Overview: The clock of USB_SIM_BENCH_Clock() inside a SysEx dump that
+*   never ends while the profile runs, USB_SIM_BENCH_FLOOD_BYTES bytes of
+*   it every frame.  The ticks are sent in the middle of the dump bytes of
+*   their frame, so they reach the bridge behind part of the dump.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_ClockAndSysEx(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    uint8_t dump[USB_SIM_BENCH_FLOOD_BYTES + 1];
+    uint8_t length = USB_SIM_BENCH_FLOOD_BYTES;
+    uint8_t i;
+
+    for(i = 0; i < USB_SIM_BENCH_FLOOD_BYTES; i++)
+    {
+        dump[i] = (uint8_t)(frame + i) & 0x7F;
+    }
+    if(frame == 0)
+    {
+        dump[0] = 0xF0;
+    }
+    if(frame == (USB_SIM_BENCH_JITTER_FRAMES - 1))
+    {
+        dump[USB_SIM_BENCH_FLOOD_BYTES - 1] = 0xF7;
+    }
+
+    if((frame % USB_SIM_BENCH_CLOCK_PERIOD) == 0)
+    {
+        memmove(&dump[(USB_SIM_BENCH_FLOOD_BYTES / 2) + 1], &dump[USB_SIM_BENCH_FLOOD_BYTES / 2], USB_SIM_BENCH_FLOOD_BYTES / 2);
+        dump[USB_SIM_BENCH_FLOOD_BYTES / 2] = 0xF8;
+        length++;
+    }
+
+    USB_SIM_BENCH_Generate(stream, 0, dump, length);
+}
+
+#if (BRIDGE_NUM_CABLES > 1) && !defined(BRIDGE_CDC_RAW_MIDI)
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_MultiCable(
+*               USB_SIM_BENCH_STREAM *stream, uint32_t frame);
+*
+* Overview: A SysEx dump on cable 0 that never ends while the profile
+*   runs, 120 bytes of it every frame, and a note on or off every other
+*   frame on each of the other cables.  The dump alone keeps the bridge
+*   busy, the latency of the notes tells if the other cables still get
+*   their turn.
+*
+* PreCondition: None
+*
+* Input: stream - stream the traffic is generated for
+*        frame - frame since the start of the profile
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_MultiCable(USB_SIM_BENCH_STREAM *stream, uint32_t frame)
+{
+    uint8_t dump[120];
+    uint8_t message[3];
+    uint8_t cable;
+    uint8_t i;
+
+    for(i = 0; i < sizeof(dump); i++)
+    {
+        dump[i] = (uint8_t)(frame + i) & 0x7F;
+    }
+    if(frame == 0)
+    {
+        dump[0] = 0xF0;
+    }
+    if(frame == (USB_SIM_BENCH_CABLE_FRAMES - 1))
+    {
+        dump[sizeof(dump) - 1] = 0xF7;
+    }
+    USB_SIM_BENCH_Generate(stream, 0, dump, sizeof(dump));
+
+    if((frame & 0x01) == 0)
+    {
+        for(cable = 1; cable < BRIDGE_NUM_CABLES; cable++)
+        {
+            message[0] = ((frame / 2) & 0x01) ? 0x80 : 0x90;
+            message[1] = 60 + cable;
+            message[2] = ((frame / 2) & 0x01) ? 0x00 : 0x64;
+
+            USB_SIM_BENCH_Generate(stream, cable, message, sizeof(message));
+        }
+    }
+}
+#endif
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Generate(USB_SIM_BENCH_STREAM *stream,
+*               uint8_t cable, const uint8_t *data, uint16_t length);
+*
+* Overview: Converts generated MIDI bytes to the events the host sends,
+*   stamped with the current frame.
+*
+* PreCondition: None
+*
+* Input: stream - stream the events are added to
+*        cable - cable the bytes are sent on
+*        data - raw MIDI bytes
+*        length - number of bytes
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Generate(USB_SIM_BENCH_STREAM *stream, uint8_t cable, const uint8_t *data, uint16_t length)
+{
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+
+    for(; length != 0; length--)
+    {
+        if(MIDI_PARSER_Parse(&stream->generators[cable], *data++, &event) == true)
+        {
+            if(stream->count == USB_SIM_BENCH_MAX_EVENTS)
+            {
+                USB_SIM_HOST_Fail("benchmark event buffer");
+            }
+
+            stream->events[stream->count].event = event;
+            stream->events[stream->count].frame = USB_SIM_HOST_Frame();
+            stream->events[stream->count].loop = USB_SIM_HOST_Loop();
+            stream->count++;
+        }
+    }
+}
+
+/*********************************************************************
+* Function: static bool USB_SIM_BENCH_Send(uint8_t direction);
+*
+* Overview: Sends one packet with the next events of a direction. Events
+*   stay queued on the host until the device acknowledges the packet.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: direction - USB_SIM_BENCH_TO_CDC or USB_SIM_BENCH_TO_MIDI
+*
+* Output: bool - true if a packet was acknowledged
+*
+********************************************************************/
+static bool USB_SIM_BENCH_Send(uint8_t direction)
+{
+    USB_SIM_BENCH_STREAM *stream = &streams[direction];
+    uint8_t packet[USB_SIM_BENCH_PACKET_SIZE];
+    uint8_t length = 0;
+    uint16_t events = 0;
+    uint8_t ep;
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        MIDI_ENCODER encoder = stream->encoder;
+    #endif
+
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        if(direction == USB_SIM_BENCH_TO_MIDI)
+        {
+            while( ((stream->sent + events) < stream->count) &&
+                   ((length + MIDI_ENCODER_MAX_LENGTH) <= sizeof(packet)) )
+            {
+                length += MIDI_ENCODER_Encode(&encoder, &stream->events[stream->sent + events].event, &packet[length]);
+                events++;
+            }
+        }
+        else
+    #endif
+    {
+        while( ((stream->sent + events) < stream->count) &&
+               ((length + sizeof(USB_AUDIO_MIDI_EVENT_PACKET)) <= sizeof(packet)) )
+        {
+            memcpy(&packet[length], stream->events[stream->sent + events].event.v, sizeof(USB_AUDIO_MIDI_EVENT_PACKET));
+            length += sizeof(USB_AUDIO_MIDI_EVENT_PACKET);
+            events++;
+        }
+    }
+
+    if(events == 0)
+    {
+        return false;
+    }
+
+    ep = (direction == USB_SIM_BENCH_TO_CDC) ? AUDIO_MIDI_EP : CDC_DATA_EP;
+    if(USB_SIM_HOST_TryOut(ep, packet, length, directionNames[direction]) == false)
+    {
+        stream->outNaks++;
+        return false;
+    }
+
+    stream->outPackets++;
+    stream->sent += events;
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        if(direction == USB_SIM_BENCH_TO_MIDI)
+        {
+            stream->encoder = encoder;
+        }
+    #endif
+
+    return true;
+}
+
+/*********************************************************************
+* Function: static bool USB_SIM_BENCH_Receive(uint8_t direction);
+*
+* Overview: Reads one packet from the endpoint a direction comes out of
+*   and matches its events against the ones sent.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: direction - USB_SIM_BENCH_TO_CDC or USB_SIM_BENCH_TO_MIDI
+*
+* Output: bool - true if a packet was read
+*
+********************************************************************/
+static bool USB_SIM_BENCH_Receive(uint8_t direction)
+{
+    USB_SIM_BENCH_STREAM *stream = &streams[direction];
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint8_t packet[USB_SIM_BENCH_PACKET_SIZE];
+    uint8_t length;
+    uint8_t i;
+    uint8_t ep;
+
+    ep = (direction == USB_SIM_BENCH_TO_CDC) ? CDC_DATA_EP : AUDIO_MIDI_EP;
+    if(USB_SIM_HOST_TryIn(ep, packet, &length, directionNames[direction]) == false)
+    {
+        if(stream->received < stream->sent)
+        {
+            stream->inNaks++;
+        }
+        return false;
+    }
+
+    stream->inPackets++;
+
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        if(direction == USB_SIM_BENCH_TO_CDC)
+        {
+            for(i = 0; i < length; i++)
+            {
+                if(MIDI_PARSER_Parse(&stream->receiver, packet[i], &event) == true)
+                {
+                    USB_SIM_BENCH_Match(stream, &event);
+                }
+            }
+            return true;
+        }
+    #endif
+
+    for(i = 0; (i + sizeof(USB_AUDIO_MIDI_EVENT_PACKET)) <= length; i += sizeof(USB_AUDIO_MIDI_EVENT_PACKET))
+    {
+        memcpy(event.v, &packet[i], sizeof(USB_AUDIO_MIDI_EVENT_PACKET));
+
+        //Padding of a packet
+        if(event.Val != 0)
+        {
+            USB_SIM_BENCH_Match(stream, &event);
+        }
+    }
+
+    return true;
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Match(USB_SIM_BENCH_STREAM *stream,
+*               const USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Finds a received event among the ones sent. The bridge keeps
+*   the order within the cable events and within the realtime messages,
+*   so each lane is matched in order. Events skipped over count as
+*   dropped, an event that was never sent as unexpected.
+*
+* PreCondition: None
+*
+* Input: stream - stream the event belongs to
+*        event - received event
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Match(USB_SIM_BENCH_STREAM *stream, const USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    uint8_t lane = USB_SIM_BENCH_Lane(event);
+    uint16_t latency;
+    uint32_t loops;
+    uint16_t i;
+
+    for(i = stream->next[lane]; i < stream->sent; i++)
+    {
+        if( (USB_SIM_BENCH_Lane(&stream->events[i].event) == lane) &&
+            (stream->events[i].event.Val == event->Val) )
+        {
+            break;
+        }
+    }
+
+    if(i == stream->sent)
+    {
+        stream->unexpected++;
+        return;
+    }
+
+    stream->next[lane] = i + 1;
+    stream->lastFrame = USB_SIM_HOST_Frame();
+    stream->bytes[lane] += cinLengths[event->CodeIndexNumber];
+
+    latency = (uint16_t)(stream->lastFrame - stream->events[i].frame);
+    stream->lane[stream->received] = lane;
+    loops = USB_SIM_HOST_Loop() - stream->events[i].loop;
+    stream->loopLatency[stream->received] = loops;
+    stream->latency[stream->received++] = latency;
+
+    if(lane == USB_SIM_BENCH_LANE_REALTIME)
+    {
+        stream->realtimeCount++;
+        if(latency < stream->realtimeMin)
+        {
+            stream->realtimeMin = latency;
+        }
+        if(latency > stream->realtimeMax)
+        {
+            stream->realtimeMax = latency;
+        }
+        if(loops < stream->realtimeLoopMin)
+        {
+            stream->realtimeLoopMin = loops;
+        }
+        if(loops > stream->realtimeLoopMax)
+        {
+            stream->realtimeLoopMax = loops;
+        }
+    }
+}
+
+/*********************************************************************
+* Function: static uint8_t USB_SIM_BENCH_Lane(
+*               const USB_AUDIO_MIDI_EVENT_PACKET *event);
+*
+* Overview: Returns the lane of the bridge an event goes through, the
+*   same test as MIDI_PORT_Put().
+*
+* PreCondition: None
+*
+* Input: event - the event
+*
+* Output: USB_SIM_BENCH_LANE_REALTIME, or the cable number of the event
+*
+********************************************************************/
+static uint8_t USB_SIM_BENCH_Lane(const USB_AUDIO_MIDI_EVENT_PACKET *event)
+{
+    if((event->CodeIndexNumber == MIDI_CIN_SINGLE_BYTE) && (event->DATA_0 >= 0xF8))
+    {
+        return USB_SIM_BENCH_LANE_REALTIME;
+    }
+
+    //Events of a cable the bridge does not have can only be unexpected
+    #if BRIDGE_NUM_CABLES < 16
+        if(event->CableNumber >= BRIDGE_NUM_CABLES)
+        {
+            return 0;
+        }
+    #endif
+    return event->CableNumber;
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Report(
+*               const USB_SIM_BENCH_PROFILE *profile, uint8_t direction,
+*               uint8_t lane, uint32_t start, FILE *results);
+*
+* Overview: Writes the results of one direction of a profile, of all of
+*   its events or of the events of one cable.  The packet and NAK counts
+*   are those of the whole direction either way.
+*
+* PreCondition: The profile has been run.
+*
+* Input: profile - the profile
+*        direction - USB_SIM_BENCH_TO_CDC or USB_SIM_BENCH_TO_MIDI
+*        lane - cable number, or USB_SIM_BENCH_ALL_LANES
+*        start - frame the profile started in
+*        results - results file
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Report(const USB_SIM_BENCH_PROFILE *profile, uint8_t direction, uint8_t lane, uint32_t start, FILE *results)
+{
+    static uint16_t latency[USB_SIM_BENCH_MAX_EVENTS];
+    static uint32_t loopLatency[USB_SIM_BENCH_MAX_EVENTS];
+    USB_SIM_BENCH_STREAM *stream = &streams[direction];
+    char cable[4] = "all";
+    uint16_t generated = 0;
+    uint16_t received = 0;
+    uint32_t bytes = 0;
+    uint32_t eventsPerSecond = 0;
+    double kbytesPerSecond = 0;
+    uint16_t p50 = 0;
+    uint16_t p99 = 0;
+    uint16_t max = 0;
+    uint16_t realtimeMax = 0;
+    uint16_t realtimeJitter = 0;
+    uint32_t realtimeLoopsMax = 0;
+    uint32_t realtimeLoopsJitter = 0;
+    uint32_t loopsP50 = 0;
+    uint32_t loopsP99 = 0;
+    uint32_t loopsMax = 0;
+    uint16_t i;
+
+    for(i = 0; i < stream->count; i++)
+    {
+        if((lane == USB_SIM_BENCH_ALL_LANES) || (USB_SIM_BENCH_Lane(&stream->events[i].event) == lane))
+        {
+            generated++;
+        }
+    }
+
+    for(i = 0; i < stream->received; i++)
+    {
+        if((lane == USB_SIM_BENCH_ALL_LANES) || (stream->lane[i] == lane))
+        {
+            latency[received] = stream->latency[i];
+            loopLatency[received] = stream->loopLatency[i];
+            received++;
+        }
+    }
+
+    for(i = 0; i < USB_SIM_BENCH_LANES; i++)
+    {
+        if((lane == USB_SIM_BENCH_ALL_LANES) || (i == lane))
+        {
+            bytes += stream->bytes[i];
+        }
+    }
+
+    if(received != 0)
+    {
+        qsort(latency, received, sizeof(latency[0]), USB_SIM_BENCH_Compare);
+
+        p50 = latency[((received - 1) * 50) / 100];
+        p99 = latency[((received - 1) * 99) / 100];
+        max = latency[received - 1];
+
+        qsort(loopLatency, received, sizeof(loopLatency[0]), USB_SIM_BENCH_CompareLoops);
+
+        loopsP50 = loopLatency[((received - 1) * 50) / 100];
+        loopsP99 = loopLatency[((received - 1) * 99) / 100];
+        loopsMax = loopLatency[received - 1];
+
+        //Frames are 1 ms long
+        eventsPerSecond = (uint32_t)(((uint64_t)received * 1000) / (stream->lastFrame - start + 1));
+        kbytesPerSecond = (double)bytes / (stream->lastFrame - start + 1);
+    }
+
+    //The realtime messages of every cable share one lane
+    if((lane == USB_SIM_BENCH_ALL_LANES) && (stream->realtimeCount != 0))
+    {
+        realtimeMax = stream->realtimeMax;
+        realtimeJitter = stream->realtimeMax - stream->realtimeMin;
+        realtimeLoopsMax = stream->realtimeLoopMax;
+        realtimeLoopsJitter = stream->realtimeLoopMax - stream->realtimeLoopMin;
+    }
+
+    if(lane != USB_SIM_BENCH_ALL_LANES)
+    {
+        snprintf(cable, sizeof(cable), "%u", lane);
+    }
+
+    fprintf(results, "%s,%s,%s,%u,%u,%u,%u,%lu,%.1f,%u,%u,%u,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%s\n",
+            profile->name, directionNames[direction], cable,
+            generated, received, generated - received, stream->unexpected,
+            (unsigned long)eventsPerSecond, kbytesPerSecond, p50, p99, max,
+            realtimeMax, realtimeJitter,
+            (unsigned long)realtimeLoopsMax, (unsigned long)realtimeLoopsJitter,
+            (unsigned long)loopsP50, (unsigned long)loopsP99, (unsigned long)loopsMax,
+            (unsigned long)stream->outPackets, (unsigned long)stream->outNaks,
+            (unsigned long)stream->inPackets, (unsigned long)stream->inNaks,
+            USB_SIM_BENCH_DISPATCH);
+
+    printf("%-20s %-12s %-3s %6u events  %6lu events/s %6.1f KB/s  latency p50 %u p99 %u max %u frames (%lu/%lu/%lu loops)  "
+           "NAKs out %lu/%lu in %lu/%lu  %u dropped\n",
+           profile->name, directionNames[direction], cable, generated, (unsigned long)eventsPerSecond, kbytesPerSecond,
+           p50, p99, max, (unsigned long)loopsP50, (unsigned long)loopsP99, (unsigned long)loopsMax,
+           (unsigned long)stream->outNaks, (unsigned long)stream->outPackets,
+           (unsigned long)stream->inNaks, (unsigned long)stream->inPackets,
+           generated - received);
+
+    if((lane == USB_SIM_BENCH_ALL_LANES) && (stream->realtimeCount != 0))
+    {
+        printf("%-20s %-12s %-3s %6u realtime  latency max %u frames (%lu loops)  jitter %u frames (%lu loops)\n",
+               profile->name, directionNames[direction], cable, stream->realtimeCount,
+               realtimeMax, (unsigned long)realtimeLoopsMax, realtimeJitter, (unsigned long)realtimeLoopsJitter);
+    }
+}
+
+/*********************************************************************
+* Function: static int USB_SIM_BENCH_Compare(const void *a, const void *b);
+*
+* Overview: qsort() comparison of two latencies.
+*
+* PreCondition: None
+*
+* Input: a, b - the latencies
+*
+* Output: int - negative, zero or positive as a is lower, equal or higher
+*
+********************************************************************/
+static int USB_SIM_BENCH_Compare(const void *a, const void *b)
+{
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+/*********************************************************************
+* Function: static int USB_SIM_BENCH_CompareLoops(const void *a,
+*               const void *b);
+*
+* Overview: qsort() comparison of two latencies in main loop passes.
+*
+* PreCondition: None
+*
+* Input: a, b - the latencies
+*
+* Output: int - negative, zero or positive as a is lower, equal or higher
+*
+********************************************************************/
+static int USB_SIM_BENCH_CompareLoops(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Parser(FILE *results);
+*
+* Overview: Times MIDI_PARSER_Parse() on streams of channel messages with
+*   running status, of SysEx, and of both with MIDI clock in between,
+*   and writes the bytes parsed per second of each one.
+*
+* PreCondition: None
+*
+* Input: results - micro benchmark results file
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Parser(FILE *results)
+{
+    static const char *caseNames[] = { "channel", "sysex", "mixed" };
+    static uint8_t stream[USB_SIM_BENCH_PARSER_BYTES];
+    MIDI_PARSER parser;
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    volatile uint32_t sink = 0;
+    double seconds;
+    double bytesPerSecond;
+    uint16_t i;
+    uint16_t pass;
+    uint8_t test;
+
+    for(test = 0; test < (sizeof(caseNames) / sizeof(caseNames[0])); test++)
+    {
+        for(i = 0; i < sizeof(stream); i++)
+        {
+            switch(test)
+            {
+                case 0:
+                    //A note on every 64 bytes, then its running status notes and CCs
+                    stream[i] = ((i % 64) == 0) ? 0x90 : ((i % 64) == 31) ? 0xB1 : (i & 0x7F);
+                    break;
+
+                case 1:
+                    //256 byte dumps
+                    stream[i] = ((i % 256) == 0) ? 0xF0 : ((i % 256) == 255) ? 0xF7 : (i & 0x7F);
+                    break;
+
+                default:
+                    //Dumps and notes, with a clock tick every 97 bytes
+                    stream[i] = ((i % 97) == 96) ? 0xF8 : ((i % 512) == 0) ? 0xF0 : ((i % 512) == 255) ? 0xF7 :
+                                ((i % 512) == 256) ? 0x90 : (i & 0x7F);
+                    break;
+            }
+        }
+
+        MIDI_PARSER_Initialize(&parser, 0);
+        seconds = USB_SIM_BENCH_Seconds();
+
+        for(pass = 0; pass < USB_SIM_BENCH_PARSER_PASSES; pass++)
+        {
+            for(i = 0; i < sizeof(stream); i++)
+            {
+                if(MIDI_PARSER_Parse(&parser, stream[i], &event) == true)
+                {
+                    sink += event.Val;
+                }
+            }
+        }
+
+        seconds = USB_SIM_BENCH_Seconds() - seconds;
+        bytesPerSecond = ((double)sizeof(stream) * USB_SIM_BENCH_PARSER_PASSES) / seconds;
+
+        fprintf(results, "parser,%s,%.0f,bytes_per_second\n", caseNames[test], bytesPerSecond);
+        printf("parser %-8s %12.0f bytes/s\n", caseNames[test], bytesPerSecond);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Router(FILE *results);
+*
+* Overview: Times MIDI_ROUTER_Route() on a stream of notes, control
+*   changes, pitch bends and clock ticks with 0, 16 and 64 rules added,
+*   and writes the nanoseconds per event of each one.  The rules are
+*   compiled into the routing tables, so the three should be the same.
+*   The rules are removed again at the end.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: results - micro benchmark results file
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Router(FILE *results)
+{
+    static const uint8_t ruleCounts[] = { 0, 16, 64 };
+    static const uint8_t statuses[] = { 0x90, 0xB0, 0x80, 0xE0, 0x90, 0xB0, 0x80, 0xF8 };
+    static USB_AUDIO_MIDI_EVENT_PACKET stream[USB_SIM_BENCH_ROUTER_EVENTS];
+    MIDI_ROUTER_RULE rule;
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    volatile uint32_t sink = 0;
+    double seconds;
+    double nanoseconds;
+    uint16_t i;
+    uint16_t pass;
+    uint8_t status;
+    uint8_t test;
+
+    for(i = 0; i < USB_SIM_BENCH_ROUTER_EVENTS; i++)
+    {
+        //Notes on and off, CCs and pitch bends over every channel, and clock
+        status = statuses[i % sizeof(statuses)];
+        if(status < 0xF0)
+        {
+            status |= (i / sizeof(statuses)) & 0x0F;
+        }
+
+        stream[i].Val = 0;
+        stream[i].CodeIndexNumber = (status >> 4) & 0x0F;
+        stream[i].DATA_0 = status;
+        stream[i].DATA_1 = (status == 0xF8) ? 0 : (i & 0x7F);
+        stream[i].DATA_2 = (status == 0xF8) ? 0 : ((i >> 7) & 0x7F);
+    }
+
+    for(test = 0; test < sizeof(ruleCounts); test++)
+    {
+        MIDI_ROUTER_Initialize();
+
+        for(i = 0; i < ruleCounts[test]; i++)
+        {
+            //Re-channel a CC, split a zone, drop active sensing or undo a
+            //  pitch bend rule in turn
+            memset(&rule, 0, sizeof(rule));
+            rule.directions = MIDI_RULE_TO_CDC | MIDI_RULE_TO_MIDI;
+            rule.channel = (i + 3) & 0x0F;
+
+            switch(i % 4)
+            {
+                case 0:
+                    rule.action = MIDI_RULE_CHANNEL;
+                    rule.statusFirst = 0xB0 | (i & 0x0F);
+                    rule.statusLast = rule.statusFirst;
+                    break;
+
+                case 1:
+                    rule.action = MIDI_RULE_ZONE;
+                    rule.statusFirst = 0x80;
+                    rule.statusLast = 0x9F;
+                    rule.keyFirst = (i * 2) % 0x70;
+                    rule.keyLast = rule.keyFirst + 0x0F;
+                    break;
+
+                case 2:
+                    rule.action = MIDI_RULE_DROP;
+                    rule.statusFirst = 0xFE;
+                    rule.statusLast = 0xFE;
+                    break;
+
+                default:
+                    rule.action = MIDI_RULE_PASS;
+                    rule.statusFirst = 0xE0 | (i & 0x0F);
+                    rule.statusLast = rule.statusFirst;
+                    break;
+            }
+
+            if(MIDI_ROUTER_AddRule(&rule) == false)
+            {
+                USB_SIM_HOST_Fail("router benchmark rule");
+            }
+        }
+
+        seconds = USB_SIM_BENCH_Seconds();
+
+        for(pass = 0; pass < USB_SIM_BENCH_ROUTER_PASSES; pass++)
+        {
+            for(i = 0; i < USB_SIM_BENCH_ROUTER_EVENTS; i++)
+            {
+                event = stream[i];
+                if(MIDI_ROUTER_Route(MIDI_ROUTER_TO_CDC, &event) == true)
+                {
+                    sink += event.Val;
+                }
+            }
+        }
+
+        seconds = USB_SIM_BENCH_Seconds() - seconds;
+        nanoseconds = (seconds * 1e9) / ((double)USB_SIM_BENCH_ROUTER_EVENTS * USB_SIM_BENCH_ROUTER_PASSES);
+
+        fprintf(results, "router,%u_rules,%.2f,ns_per_event\n", ruleCounts[test], nanoseconds);
+        printf("router   %2u rules %9.2f ns/event\n", ruleCounts[test], nanoseconds);
+    }
+
+    MIDI_ROUTER_Initialize();
+}
+
+/*********************************************************************
+* Function: static double USB_SIM_BENCH_Seconds(void);
+*
+* Overview: Returns the monotonic wall clock time of the machine running
+*   the simulation.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: double - time in seconds
+*
+********************************************************************/
+static double USB_SIM_BENCH_Seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+#if defined(BRIDGE_CYCLE_COUNT)
+/*********************************************************************
+* Function: static void USB_SIM_BENCH_Copy(void);
+*
+* Overview: Runs the copy benchmark of the device with the
+*   VENDOR_REQUEST_COPY_BENCH_RUN request, reads the results with
+*   VENDOR_REQUEST_COPY_BENCH_READ and writes the cycles per byte
+*   of each path to the copy results file.  The cycles are the 83.3ns
+*   ticks of cycle_counter.h, so they compare the paths of this build and
+*   not the PIC18 ones.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_BENCH_Copy(void)
+{
+    static const char *pathNames[COPY_BENCH_PATHS] = { "ram_loop", "usb_memcpy", "rom_loop", "usb_memcpy_rom" };
+    COPY_BENCH_STATS stats[COPY_BENCH_PATHS];
+    const char *path = getenv("USB_SIM_BENCH_COPY_RESULTS");
+    FILE *results;
+    uint8_t i;
+
+    if(path == NULL)
+    {
+        path = USB_SIM_BENCH_COPY_RESULTS;
+    }
+
+    USB_SIM_HOST_ControlWrite(USB_SETUP_TYPE_VENDOR, VENDOR_REQUEST_COPY_BENCH_RUN, 0, 0, NULL, 0, "VENDOR_REQUEST_COPY_BENCH_RUN");
+
+    if(USB_SIM_HOST_ControlRead((USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_VENDOR), VENDOR_REQUEST_COPY_BENCH_READ, 0, 0,
+                                (uint8_t*)stats, sizeof(stats), "VENDOR_REQUEST_COPY_BENCH_READ") != sizeof(stats))
+    {
+        USB_SIM_HOST_Fail("VENDOR_REQUEST_COPY_BENCH_READ");
+    }
+
+    results = fopen(path, "w");
+    if(results == NULL)
+    {
+        USB_SIM_HOST_Fail(path);
+    }
+
+    fprintf(results, "path,bytes,cycles,cycles_per_byte\n");
+
+    for(i = 0; i < COPY_BENCH_PATHS; i++)
+    {
+        fprintf(results, "%s,%lu,%lu,%.4f\n", pathNames[i], (unsigned long)stats[i].bytes,
+                (unsigned long)stats[i].cycles, (double)stats[i].cycles / stats[i].bytes);
+    }
+
+    fclose(results);
+}
+#endif
+
+#endif //USB_SIM_BENCHMARK
@@ -0,0 +1,53 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef USB_SIM_BENCH_H
+#define USB_SIM_BENCH_H
+
+/** CONSTANTS ******************************************************/
+#define USB_SIM_BENCH_RESULTS       "usb_sim_bench.csv"     //default results file
+#define USB_SIM_BENCH_COPY_RESULTS  "usb_sim_copy.csv"      //default copy benchmark results file
+#define USB_SIM_BENCH_MICRO_RESULTS "usb_sim_micro.csv"     //default micro benchmark results file
+#define USB_SIM_BENCH_MAX_EVENTS    0x8000                  //events per direction and profile
+#define USB_SIM_BENCH_DRAIN_FRAMES  1000                    //frames given to the bridge to empty its queues
+#define USB_SIM_BENCH_BURST         4                       //packets tried back to back on an endpoint per main loop pass
+
+/*********************************************************************
+* Function: void USB_SIM_BENCH_Run(void);
+*
+* Overview: Runs every traffic profile through the bridge and writes
+*   the throughput, latency, NAK and drop counts of each direction to the
+*   results file, USB_SIM_BENCH_RESULTS unless the environment variable
+*   of the same name gives another path.  With BRIDGE_CYCLE_COUNT the
+*   cycles per byte of the copy paths of copy_bench.h are then written to
+*   USB_SIM_BENCH_COPY_RESULTS the same way.  The micro benchmarks of
+*   the bridge modules, run on the host without the device, are written
+*   to USB_SIM_BENCH_MICRO_RESULTS.
+*
+* PreCondition: Only available when built with USB_SIM_BENCHMARK. Runs
+*   on the host coroutine once the device is configured.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_BENCH_Run(void);
+
+#endif //USB_SIM_BENCH_H
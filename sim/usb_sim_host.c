@@ -0,0 +1,882 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/* Scripted host for the simulation backend.  It runs as a coroutine next to
+ * the firmware: every pass of the main loop resumes it through
+ * SYSTEM_Tasks(), and it hands control back whenever the device NAKs one of
+ * its tokens, so the application tasks get to run in between.  Transactions
+ * themselves complete at once, the USB interrupt being taken from inside
+ * the token.
+ */
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "system.h"
+
+#include "usb.h"
+#include "usb_device_cdc.h"
+#include "usb_config.h"
+
+#include "app_device_vendor.h"
+#include "bridge_stats.h"
+#include "residency.h"
+
+#include "usb_sim_host.h"
+#include "usb_sim_bench.h"
+#include "usb_sim_test.h"
+
+/** CONSTANTS ******************************************************/
+#define USB_SIM_HOST_STACK_SIZE     0x10000
+#define USB_SIM_HOST_PACKET_EVENTS  16      //event packets in a 64 byte MIDI packet
+#define USB_SIM_HOST_TRANSFER_EP    4       //endpoint of the USBDeviceTransfer() checks, see usb_config.h
+#define USB_SIM_HOST_TRANSFER_EP_SIZE 64
+
+/** VARIABLES ******************************************************/
+static ucontext_t hostContext;
+static ucontext_t deviceContext;
+static uint8_t hostStack[USB_SIM_HOST_STACK_SIZE];
+static bool hostStarted = false;
+
+static uint32_t loops;
+static uint8_t hostAddress;
+static uint8_t inToggle[USB_MAX_EP_NUMBER + 1];
+static uint8_t outToggle[USB_MAX_EP_NUMBER + 1];
+static uint8_t transferData[256];
+static uint8_t transferBuffer[256];
+static volatile uint8_t transferCallbacks;
+
+/** PRIVATE PROTOTYPES *********************************************/
+static void USB_SIM_HOST_Run(void);
+static void USB_SIM_HOST_Wait(uint16_t *waited, const char *step);
+static void USB_SIM_HOST_Setup(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, uint16_t length, const char *step);
+static uint8_t USB_SIM_HOST_In(uint8_t ep, uint8_t *buffer, const char *step);
+static void USB_SIM_HOST_Out(uint8_t ep, const uint8_t *data, uint8_t length, const char *step);
+static void USB_SIM_HOST_Expect(uint8_t ep, const uint8_t *data, uint8_t length, const char *step);
+static void USB_SIM_HOST_ExpectStream(uint8_t ep, const uint8_t *data, uint16_t length, const char *step);
+static void USB_SIM_HOST_Transfers(void);
+static void USB_SIM_HOST_TransferIn(uint16_t length, uint8_t options, const uint8_t *packets, uint8_t count, const char *step);
+static void USB_SIM_HOST_TransferOut(uint16_t length, const uint8_t *packets, uint8_t count, const char *step);
+static void USB_SIM_HOST_TransferDone(uint8_t direction, uint16_t length, const char *step);
+static void USB_SIM_HOST_TransferComplete(void *context);
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_Tasks(void);
+*
+* Overview: Runs the simulated host until its next token gets NAKed,
+*   then returns to the main loop. The host enumerates the device and
+*   sends a MIDI message each way through the bridge and a whole packet
+*   of events from MIDI OUT to CDC IN, then runs the benchmark if built
+*   with USB_SIM_BENCHMARK and exits the program with the result.
+*
+* PreCondition: Only available when built with USB_SIMULATION. Called
+*   from the main loop through SYSTEM_Tasks().
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_HOST_Tasks(void)
+{
+    if(hostStarted == false)
+    {
+        getcontext(&hostContext);
+        hostContext.uc_stack.ss_sp = hostStack;
+        hostContext.uc_stack.ss_size = sizeof(hostStack);
+        hostContext.uc_link = NULL;
+        makecontext(&hostContext, USB_SIM_HOST_Run, 0);
+
+        hostStarted = true;
+    }
+
+    //Interrupts raised while the application had them masked
+    USBSimInterrupt();
+
+    if((++loops % USB_SIM_HOST_LOOPS_PER_FRAME) == 0)
+    {
+        USBSimStartOfFrame();
+    }
+
+    swapcontext(&deviceContext, &hostContext);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_Run(void);
+*
+* Overview: Host script, runs the tests of usb_sim_test.c, enumerates
+*   the device the way a PC does, checks that MIDI messages get through
+*   the bridge in each direction and that the bridge statistics, and the
+*   residency ones with BRIDGE_RESIDENCY, count them and can be cleared,
+*   then checks USBDeviceTransfer() on an endpoint of its own.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: None
+*
+* Output: None, exits the program.
+*
+********************************************************************/
+static void USB_SIM_HOST_Run(void)
+{
+    static const uint8_t lineCoding[] = { 0x12, 0x7A, 0x00, 0x00, 0x00, 0x00, 0x08 };   //31250 baud, 8N1
+    static const uint8_t midiOutEvent[] = { 0x09, 0x90, 0x3C, 0x40 };
+    static const uint8_t midiInEvent[] = { 0x08, 0x80, 0x3C, 0x00 };
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        static const uint8_t cdcInData[] = { 0x90, 0x3C, 0x40 };
+        static const uint8_t cdcOutData[] = { 0x80, 0x3C, 0x00 };
+    #else
+        static const uint8_t cdcInData[] = { 0x09, 0x90, 0x3C, 0x40 };
+        static const uint8_t cdcOutData[] = { 0x08, 0x80, 0x3C, 0x00 };
+        #if BRIDGE_NUM_CABLES < 16
+            //An event of a cable the bridge does not have, then a valid one
+            static const uint8_t cdcOutCables[] = { (BRIDGE_NUM_CABLES << 4) | 0x08, 0x80, 0x3C, 0x00, 0x08, 0x80, 0x3D, 0x00 };
+            static const uint8_t midiInCables[] = { 0x08, 0x80, 0x3D, 0x00 };
+        #endif
+    #endif
+    uint8_t midiOutPacket[USB_SIM_HOST_PACKET_EVENTS * 4];
+    uint8_t cdcInStream[USB_SIM_HOST_PACKET_EVENTS * 4];
+    BRIDGE_STATS stats;
+    BRIDGE_STATS cleared;
+    #if defined(BRIDGE_RESIDENCY)
+        RESIDENCY_STATS residency[RESIDENCY_DIRECTIONS];
+        RESIDENCY_STATS residencyCleared[RESIDENCY_DIRECTIONS];
+    #endif
+    uint8_t buffer[1024];
+    uint16_t length;
+    uint16_t waited = 0;
+    uint8_t i;
+
+    USB_SIM_TEST_Run();
+
+    while(USBSimIsAttached() == false)
+    {
+        USB_SIM_HOST_Wait(&waited, "attach");
+    }
+
+    //The bus stays idle for the attach debounce time before the reset
+    USBSimBusIdle();
+    USB_SIM_HOST_Wait(&waited, "attach");
+
+    hostAddress = 0;
+    USBSimBusReset();
+
+    length = USB_SIM_HOST_ControlRead(USB_SETUP_DEVICE_TO_HOST, USB_REQUEST_GET_DESCRIPTOR, (USB_DESCRIPTOR_DEVICE << 8), 0, buffer, 18, "GET_DESCRIPTOR device");
+    if((length != 18) || (buffer[1] != USB_DESCRIPTOR_DEVICE) || (buffer[7] != USB_EP0_BUFF_SIZE))
+    {
+        USB_SIM_HOST_Fail("device descriptor");
+    }
+
+    USB_SIM_HOST_ControlWrite(USB_SETUP_HOST_TO_DEVICE, USB_REQUEST_SET_ADDRESS, USB_SIM_HOST_ADDRESS, 0, NULL, 0, "SET_ADDRESS");
+    hostAddress = USB_SIM_HOST_ADDRESS;
+
+    length = USB_SIM_HOST_ControlRead(USB_SETUP_DEVICE_TO_HOST, USB_REQUEST_GET_DESCRIPTOR, (USB_DESCRIPTOR_CONFIGURATION << 8), 0, buffer, 9, "GET_DESCRIPTOR configuration");
+    length = buffer[2] | (buffer[3] << 8);
+    if((buffer[1] != USB_DESCRIPTOR_CONFIGURATION) || (length > sizeof(buffer)))
+    {
+        USB_SIM_HOST_Fail("configuration descriptor");
+    }
+    if(USB_SIM_HOST_ControlRead(USB_SETUP_DEVICE_TO_HOST, USB_REQUEST_GET_DESCRIPTOR, (USB_DESCRIPTOR_CONFIGURATION << 8), 0, buffer, length, "GET_DESCRIPTOR configuration") != length)
+    {
+        USB_SIM_HOST_Fail("configuration descriptor length");
+    }
+
+    USB_SIM_HOST_ControlWrite(USB_SETUP_HOST_TO_DEVICE, USB_REQUEST_SET_CONFIGURATION, 1, 0, NULL, 0, "SET_CONFIGURATION");
+    memset(inToggle, 0, sizeof(inToggle));
+    memset(outToggle, 0, sizeof(outToggle));
+
+    USB_SIM_HOST_ControlWrite((USB_SETUP_TYPE_CLASS | USB_SETUP_RECIPIENT_INTERFACE), SET_LINE_CODING, 0, CDC_COMM_INTF_ID, lineCoding, sizeof(lineCoding), "SET_LINE_CODING");
+    USB_SIM_HOST_ControlWrite((USB_SETUP_TYPE_CLASS | USB_SETUP_RECIPIENT_INTERFACE), SET_CONTROL_LINE_STATE, 0x0003, CDC_COMM_INTF_ID, NULL, 0, "SET_CONTROL_LINE_STATE");
+
+    USB_SIM_HOST_Out(AUDIO_MIDI_EP, midiOutEvent, sizeof(midiOutEvent), "MIDI OUT");
+    USB_SIM_HOST_Expect(CDC_DATA_EP, cdcInData, sizeof(cdcInData), "MIDI OUT to CDC IN");
+
+    USB_SIM_HOST_Out(CDC_DATA_EP, cdcOutData, sizeof(cdcOutData), "CDC OUT");
+    USB_SIM_HOST_Expect(AUDIO_MIDI_EP, midiInEvent, sizeof(midiInEvent), "CDC OUT to MIDI IN");
+
+    #if !defined(BRIDGE_CDC_RAW_MIDI) && (BRIDGE_NUM_CABLES < 16)
+        USB_SIM_HOST_Out(CDC_DATA_EP, cdcOutCables, sizeof(cdcOutCables), "CDC OUT cables");
+        USB_SIM_HOST_Expect(AUDIO_MIDI_EP, midiInCables, sizeof(midiInCables), "CDC OUT cables to MIDI IN");
+    #endif
+
+    //A whole packet of control changes, every one of them has to come out
+    //of CDC IN. The channel differs from the note above so the raw stream
+    //starts with a status byte and then runs on running status.
+    length = 0;
+    #if defined(BRIDGE_CDC_RAW_MIDI)
+        cdcInStream[length++] = 0xB1;
+    #endif
+    for(i = 0; i < USB_SIM_HOST_PACKET_EVENTS; i++)
+    {
+        midiOutPacket[(i * 4) + 0] = 0x0B;
+        midiOutPacket[(i * 4) + 1] = 0xB1;
+        midiOutPacket[(i * 4) + 2] = i;
+        midiOutPacket[(i * 4) + 3] = 0x7F - i;
+
+        #if !defined(BRIDGE_CDC_RAW_MIDI)
+            cdcInStream[length++] = 0x0B;
+            cdcInStream[length++] = 0xB1;
+        #endif
+        cdcInStream[length++] = i;
+        cdcInStream[length++] = 0x7F - i;
+    }
+    USB_SIM_HOST_Out(AUDIO_MIDI_EP, midiOutPacket, sizeof(midiOutPacket), "MIDI OUT packet");
+    USB_SIM_HOST_ExpectStream(CDC_DATA_EP, cdcInStream, length, "MIDI OUT packet to CDC IN");
+
+    //The statistics are sent from the main loop, everything above has been
+    //  delivered by now
+    memset(&stats, 0xFF, sizeof(stats));
+    if( (USB_SIM_HOST_ControlRead((USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_VENDOR), VENDOR_REQUEST_BRIDGE_STATS_READ, 0, 0,
+                                  (uint8_t*)&stats, sizeof(stats), "BRIDGE_STATS_READ") != sizeof(stats)) ||
+        (stats.toCdc.eventsIn == 0) || (stats.toCdc.eventsOut != stats.toCdc.eventsIn) ||
+        (stats.toMidi.eventsIn == 0) || (stats.toMidi.eventsOut != stats.toMidi.eventsIn) )
+    {
+        USB_SIM_HOST_Fail("BRIDGE_STATS_READ");
+    }
+
+    USB_SIM_HOST_ControlWrite(USB_SETUP_TYPE_VENDOR, VENDOR_REQUEST_BRIDGE_STATS_CLEAR, 0, 0, NULL, 0, "BRIDGE_STATS_CLEAR");
+
+    memset(&cleared, 0, sizeof(cleared));
+    if( (USB_SIM_HOST_ControlRead((USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_VENDOR), VENDOR_REQUEST_BRIDGE_STATS_READ, 0, 0,
+                                  (uint8_t*)&stats, sizeof(stats), "BRIDGE_STATS_READ cleared") != sizeof(stats)) ||
+        (memcmp(&stats, &cleared, sizeof(stats)) != 0) )
+    {
+        USB_SIM_HOST_Fail("BRIDGE_STATS_READ cleared");
+    }
+
+    #if defined(BRIDGE_RESIDENCY)
+        if( (USB_SIM_HOST_ControlRead((USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_VENDOR), VENDOR_REQUEST_RESIDENCY_READ, 0, 0,
+                                      (uint8_t*)residency, sizeof(residency), "RESIDENCY_READ") != sizeof(residency)) ||
+            (residency[RESIDENCY_TO_CDC].count == 0) || (residency[RESIDENCY_TO_MIDI].count == 0) )
+        {
+            USB_SIM_HOST_Fail("RESIDENCY_READ");
+        }
+
+        USB_SIM_HOST_ControlWrite(USB_SETUP_TYPE_VENDOR, VENDOR_REQUEST_RESIDENCY_CLEAR, 0, 0, NULL, 0, "RESIDENCY_CLEAR");
+
+        memset(residencyCleared, 0, sizeof(residencyCleared));
+        if( (USB_SIM_HOST_ControlRead((USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_VENDOR), VENDOR_REQUEST_RESIDENCY_READ, 0, 0,
+                                      (uint8_t*)residency, sizeof(residency), "RESIDENCY_READ cleared") != sizeof(residency)) ||
+            (memcmp(residency, residencyCleared, sizeof(residency)) != 0) )
+        {
+            USB_SIM_HOST_Fail("RESIDENCY_READ cleared");
+        }
+    #endif
+
+    USB_SIM_HOST_Transfers();
+
+    #if defined(USB_SIM_BENCHMARK)
+        USB_SIM_BENCH_Run();
+    #endif
+
+    printf("PASS\n");
+    exit(EXIT_SUCCESS);
+}
+
+/*********************************************************************
+* Function: *
+* Overview: Reports the step of the script that failed and exits.
+*
+* PreCondition: None
+*
+* Input: step - description of the failed step
+*
+* Output: None, exits the program.
+*
+********************************************************************/
+void USB_SIM_HOST_Fail(const char *step)
+{
+    printf("FAIL: %s\n", step);
+    exit(EXIT_FAILURE);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_Wait(uint16_t *waited, const char *step);
+*
+* Overview: Gives the main loop a pass before a token is retried, and
+*   fails the step once the device has been waited for too long.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: waited - number of passes waited so far for this step
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_Wait(uint16_t *waited, const char *step)
+{
+    if(++(*waited) > USB_SIM_HOST_TIMEOUT)
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+
+    USB_SIM_HOST_Yield();
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_Setup(uint8_t requestType,
+*               uint8_t request, uint16_t value, uint16_t index,
+*               uint16_t length, const char *step);
+*
+* Overview: Sends a setup packet to EP0, retried until the device takes
+*   it. The data and status stages start with DATA1.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: Fields of the setup packet and description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_Setup(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, uint16_t length, const char *step)
+{
+    uint8_t packet[8];
+    uint16_t waited = 0;
+
+    packet[0] = requestType;
+    packet[1] = request;
+    packet[2] = (uint8_t)value;
+    packet[3] = (uint8_t)(value >> 8);
+    packet[4] = (uint8_t)index;
+    packet[5] = (uint8_t)(index >> 8);
+    packet[6] = (uint8_t)length;
+    packet[7] = (uint8_t)(length >> 8);
+
+    while(USBSimSetup(hostAddress, 0, packet) != USB_SIM_ACK)
+    {
+        USB_SIM_HOST_Wait(&waited, step);
+    }
+
+    inToggle[0] = 1;
+    outToggle[0] = 1;
+}
+
+/*********************************************************************
+* Function: uint32_t USB_SIM_HOST_Frame(void);
+*
+* Overview: Returns the number of the current USB frame, the number of
+*   SOF packets sent so far.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint32_t - current frame number
+*
+********************************************************************/
+uint32_t USB_SIM_HOST_Frame(void)
+{
+    return (loops / USB_SIM_HOST_LOOPS_PER_FRAME);
+}
+
+/*********************************************************************
+* Function: uint32_t USB_SIM_HOST_Loop(void);
+*
+* Overview: Returns the number of main loop passes so far, a finer time
+*   base than the frames.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint32_t - current main loop pass
+*
+********************************************************************/
+uint32_t USB_SIM_HOST_Loop(void)
+{
+    return loops;
+}
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_Yield(void);
+*
+* Overview: Gives the main loop one pass.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_HOST_Yield(void)
+{
+    swapcontext(&hostContext, &deviceContext);
+}
+
+/*********************************************************************
+* Function: bool USB_SIM_HOST_TryIn(uint8_t ep, uint8_t *buffer,
+*               uint8_t *length, const char *step);
+*
+* Overview: Sends one IN token. A stall, a timeout or a wrong data
+*   toggle fails the step.
+*
+* PreCondition: Runs on the host coroutine, the device is configured.
+*
+* Input: ep - endpoint number
+*        buffer - room for a whole packet of the endpoint
+*        length - where the length of the packet is written
+*        step - description of the step
+*
+* Output: bool - true if a packet was received, false if NAKed
+*
+********************************************************************/
+bool USB_SIM_HOST_TryIn(uint8_t ep, uint8_t *buffer, uint8_t *length, const char *step)
+{
+    USB_SIM_HANDSHAKE handshake;
+    uint8_t dataToggle;
+
+    handshake = USBSimIn(hostAddress, ep, &dataToggle, buffer, length);
+    if(handshake == USB_SIM_NAK)
+    {
+        return false;
+    }
+
+    if((handshake != USB_SIM_ACK) || (dataToggle != inToggle[ep]))
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+    inToggle[ep] ^= 1;
+
+    return true;
+}
+
+/*********************************************************************
+* Function: bool USB_SIM_HOST_TryOut(uint8_t ep, const uint8_t *data,
+*               uint8_t length, const char *step);
+*
+* Overview: Sends one OUT packet. A stall or a timeout fails the step.
+*
+* PreCondition: Runs on the host coroutine, the device is configured.
+*
+* Input: ep - endpoint number
+*        data - packet to send
+*        length - length of the packet
+*        step - description of the step
+*
+* Output: bool - true if the packet was acknowledged, false if NAKed
+*
+********************************************************************/
+bool USB_SIM_HOST_TryOut(uint8_t ep, const uint8_t *data, uint8_t length, const char *step)
+{
+    USB_SIM_HANDSHAKE handshake;
+
+    handshake = USBSimOut(hostAddress, ep, outToggle[ep], data, length);
+    if(handshake == USB_SIM_NAK)
+    {
+        return false;
+    }
+
+    if(handshake != USB_SIM_ACK)
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+    outToggle[ep] ^= 1;
+
+    return true;
+}
+
+/*********************************************************************
+* Function: static uint8_t USB_SIM_HOST_In(uint8_t ep, uint8_t *buffer,
+*               const char *step);
+*
+* Overview: Reads one packet from an IN endpoint, retried while the
+*   device NAKs.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: ep - endpoint number
+*        buffer - room for a whole packet of the endpoint
+*        step - description of the step
+*
+* Output: uint8_t - length of the packet
+*
+********************************************************************/
+static uint8_t USB_SIM_HOST_In(uint8_t ep, uint8_t *buffer, const char *step)
+{
+    uint8_t length;
+    uint16_t waited = 0;
+
+    while(USB_SIM_HOST_TryIn(ep, buffer, &length, step) == false)
+    {
+        USB_SIM_HOST_Wait(&waited, step);
+    }
+
+    return length;
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_Out(uint8_t ep, const uint8_t *data,
+*               uint8_t length, const char *step);
+*
+* Overview: Writes one packet to an OUT endpoint, retried while the
+*   device NAKs.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: ep - endpoint number
+*        data - packet to send
+*        length - length of the packet
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_Out(uint8_t ep, const uint8_t *data, uint8_t length, const char *step)
+{
+    uint16_t waited = 0;
+
+    while(USB_SIM_HOST_TryOut(ep, data, length, step) == false)
+    {
+        USB_SIM_HOST_Wait(&waited, step);
+    }
+}
+
+/*********************************************************************
+* Function: uint16_t USB_SIM_HOST_ControlRead(uint8_t requestType,
+*               uint8_t request, uint16_t value, uint16_t index,
+*               uint8_t *buffer, uint16_t length, const char *step);
+*
+* Overview: Runs a control transfer with an IN data stage.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: Fields of the setup packet, buffer for the data stage and
+*   description of the step
+*
+* Output: uint16_t - number of bytes received
+*
+********************************************************************/
+uint16_t USB_SIM_HOST_ControlRead(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, uint8_t *buffer, uint16_t length, const char *step)
+{
+    uint8_t packet[USB_EP0_BUFF_SIZE];
+    uint8_t packetLength;
+    uint16_t received = 0;
+
+    USB_SIM_HOST_Setup(requestType, request, value, index, length, step);
+
+    //The data stage ends with a short packet or once length bytes arrived
+    do
+    {
+        packetLength = USB_SIM_HOST_In(0, packet, step);
+        if(packetLength > (length - received))
+        {
+            USB_SIM_HOST_Fail(step);
+        }
+
+        memcpy(&buffer[received], packet, packetLength);
+        received += packetLength;
+    } while((packetLength == USB_EP0_BUFF_SIZE) && (received < length));
+
+    USB_SIM_HOST_Out(0, NULL, 0, step);
+
+    return received;
+}
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_ControlWrite(uint8_t requestType,
+*               uint8_t request, uint16_t value, uint16_t index,
+*               const uint8_t *data, uint16_t length, const char *step);
+*
+* Overview: Runs a control transfer with an OUT data stage, or with no
+*   data stage when length is 0.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: Fields of the setup packet, data stage and description of the
+*   step
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_HOST_ControlWrite(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, const uint8_t *data, uint16_t length, const char *step)
+{
+    uint8_t packet[USB_EP0_BUFF_SIZE];
+    uint16_t sent = 0;
+    uint8_t packetLength;
+
+    USB_SIM_HOST_Setup(requestType, request, value, index, length, step);
+
+    while(sent < length)
+    {
+        packetLength = ((length - sent) > USB_EP0_BUFF_SIZE) ? USB_EP0_BUFF_SIZE : (uint8_t)(length - sent);
+
+        USB_SIM_HOST_Out(0, &data[sent], packetLength, step);
+        sent += packetLength;
+    }
+
+    if(USB_SIM_HOST_In(0, packet, step) != 0)
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_Expect(uint8_t ep,
+*               const uint8_t *data, uint8_t length, const char *step);
+*
+* Overview: Reads one packet from an IN endpoint and checks its content.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: ep - endpoint number
+*        data - expected packet
+*        length - expected length
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_Expect(uint8_t ep, const uint8_t *data, uint8_t length, const char *step)
+{
+    uint8_t packet[64];
+
+    if((USB_SIM_HOST_In(ep, packet, step) != length) || (memcmp(packet, data, length) != 0))
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_ExpectStream(uint8_t ep,
+*               const uint8_t *data, uint16_t length, const char *step);
+*
+* Overview: Reads packets from an IN endpoint until length bytes came
+*   in, however the device split them, and checks their content.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: ep - endpoint number
+*        data - expected stream
+*        length - expected length
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_ExpectStream(uint8_t ep, const uint8_t *data, uint16_t length, const char *step)
+{
+    uint8_t packet[64];
+    uint8_t packetLength;
+    uint16_t received = 0;
+
+    while(received < length)
+    {
+        packetLength = USB_SIM_HOST_In(ep, packet, step);
+        if((packetLength > (length - received)) || (memcmp(packet, &data[received], packetLength) != 0))
+        {
+            USB_SIM_HOST_Fail(step);
+        }
+        received += packetLength;
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_Transfers(void);
+*
+* Overview: Checks USBDeviceTransfer() on USB_SIM_HOST_TRANSFER_EP, an
+*   endpoint none of the interfaces use: IN transfers ending on a short
+*   packet, on a full packet and on a ZLP, and OUT transfers ending on
+*   their length and on a short packet.
+*
+* PreCondition: Runs on the host coroutine, the device is configured.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_Transfers(void)
+{
+    static const uint8_t inPackets[] = { 64, 64, 64, 8 };
+    static const uint8_t inZlpPackets[] = { 64, 64, 0 };
+    static const uint8_t outShortPackets[] = { 64, 64, 10 };
+    uint16_t i;
+
+    for(i = 0; i < sizeof(transferData); i++)
+    {
+        transferData[i] = (uint8_t)(i * 7);
+    }
+
+    USBEnableEndpoint(USB_SIM_HOST_TRANSFER_EP, USB_IN_ENABLED|USB_OUT_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
+    USBDeviceSetTransferCallback(USB_SIM_HOST_TRANSFER_EP, IN_TO_HOST, USB_SIM_HOST_TransferComplete, NULL);
+    USBDeviceSetTransferCallback(USB_SIM_HOST_TRANSFER_EP, OUT_FROM_HOST, USB_SIM_HOST_TransferComplete, NULL);
+
+    USB_SIM_HOST_TransferIn(200, USB_TRANSFER_NO_OPTIONS, inPackets, sizeof(inPackets), "transfer IN 200 bytes");
+    USB_SIM_HOST_TransferIn(128, USB_TRANSFER_ZLP, inZlpPackets, sizeof(inZlpPackets), "transfer IN 128 bytes and ZLP");
+    USB_SIM_HOST_TransferIn(128, USB_TRANSFER_NO_OPTIONS, inZlpPackets, 2, "transfer IN 128 bytes");
+
+    USB_SIM_HOST_TransferOut(256, outShortPackets, sizeof(outShortPackets), "transfer OUT short packet");
+    USB_SIM_HOST_TransferOut(128, inZlpPackets, 2, "transfer OUT 128 bytes");
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_TransferIn(uint16_t length,
+*               uint8_t options, const uint8_t *packets, uint8_t count,
+*               const char *step);
+*
+* Overview: Sends the first length bytes of transferData with
+*   USBDeviceTransfer() and checks the packets the host reads, then that
+*   the endpoint NAKs and that the transfer reported its end once.
+*
+* PreCondition: Called from USB_SIM_HOST_Transfers()
+*
+* Input: length - bytes to send
+*        options - USB_TRANSFER_ZLP or USB_TRANSFER_NO_OPTIONS
+*        packets - length of each packet expected
+*        count - number of packets expected
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_TransferIn(uint16_t length, uint8_t options, const uint8_t *packets, uint8_t count, const char *step)
+{
+    uint8_t packet[64];
+    uint8_t packetLength;
+    uint16_t received = 0;
+    uint8_t i;
+
+    transferCallbacks = 0;
+    if(USBDeviceTransfer(USB_SIM_HOST_TRANSFER_EP, IN_TO_HOST, transferData, length, USB_SIM_HOST_TRANSFER_EP_SIZE, options) == false)
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        packetLength = USB_SIM_HOST_In(USB_SIM_HOST_TRANSFER_EP, packet, step);
+        if((packetLength != packets[i]) || (memcmp(packet, &transferData[received], packetLength) != 0))
+        {
+            USB_SIM_HOST_Fail(step);
+        }
+        received += packetLength;
+    }
+
+    USB_SIM_HOST_TransferDone(IN_TO_HOST, length, step);
+
+    if(USB_SIM_HOST_TryIn(USB_SIM_HOST_TRANSFER_EP, packet, &packetLength, step) == true)
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_TransferOut(uint16_t length,
+*               const uint8_t *packets, uint8_t count, const char *step);
+*
+* Overview: Receives into transferBuffer with USBDeviceTransfer(), sends
+*   packets of transferData and checks the bytes received, then that the
+*   endpoint NAKs and that the transfer reported its end once.
+*
+* PreCondition: Called from USB_SIM_HOST_Transfers()
+*
+* Input: length - bytes the transfer asks for
+*        packets - length of each packet to send, the transfer has to
+*           end with the last one
+*        count - number of packets to send
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_TransferOut(uint16_t length, const uint8_t *packets, uint8_t count, const char *step)
+{
+    uint16_t sent = 0;
+    uint8_t i;
+
+    memset(transferBuffer, 0, sizeof(transferBuffer));
+
+    transferCallbacks = 0;
+    if(USBDeviceTransfer(USB_SIM_HOST_TRANSFER_EP, OUT_FROM_HOST, transferBuffer, length, USB_SIM_HOST_TRANSFER_EP_SIZE, USB_TRANSFER_NO_OPTIONS) == false)
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        USB_SIM_HOST_Out(USB_SIM_HOST_TRANSFER_EP, &transferData[sent], packets[i], step);
+        sent += packets[i];
+    }
+
+    USB_SIM_HOST_TransferDone(OUT_FROM_HOST, sent, step);
+
+    if( (memcmp(transferBuffer, transferData, sent) != 0) ||
+        (USB_SIM_HOST_TryOut(USB_SIM_HOST_TRANSFER_EP, transferData, 1, step) == true) )
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_TransferDone(uint8_t direction,
+*               uint16_t length, const char *step);
+*
+* Overview: Waits for the transfer of a direction to end and checks its
+*   length and that the callback ran once.
+*
+* PreCondition: Called from USB_SIM_HOST_TransferIn() or
+*   USB_SIM_HOST_TransferOut()
+*
+* Input: direction - IN_TO_HOST or OUT_FROM_HOST
+*        length - bytes the transfer has to have moved
+*        step - description of the step
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_TransferDone(uint8_t direction, uint16_t length, const char *step)
+{
+    uint16_t waited = 0;
+
+    while(USBDeviceTransferBusy(USB_SIM_HOST_TRANSFER_EP, direction) == true)
+    {
+        USB_SIM_HOST_Wait(&waited, step);
+    }
+
+    if((USBDeviceTransferLength(USB_SIM_HOST_TRANSFER_EP, direction) != length) || (transferCallbacks != 1))
+    {
+        USB_SIM_HOST_Fail(step);
+    }
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_HOST_TransferComplete(void *context);
+*
+* Overview: Transfer callback of USB_SIM_HOST_TRANSFER_EP, counts the
+*   transfers that ended.
+*
+* PreCondition: None
+*
+* Input: context - not used
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_HOST_TransferComplete(void *context)
+{
+    (void)context;
+    transferCallbacks++;
+}
@@ -0,0 +1,180 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef USB_SIM_HOST_H
+#define USB_SIM_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** CONSTANTS ******************************************************/
+#define USB_SIM_HOST_ADDRESS            1       //address given to the device
+#define USB_SIM_HOST_LOOPS_PER_FRAME    4       //main loop iterations per SOF
+#define USB_SIM_HOST_TIMEOUT            2000    //main loop iterations before a NAKed token fails
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_Tasks(void);
+*
+* Overview: Runs the simulated host until its next token gets NAKed,
+*   then returns to the main loop. The host enumerates the device and
+*   sends a MIDI message each way through the bridge, then runs the
+*   benchmark if built with USB_SIM_BENCHMARK and exits the program with
+*   the result.
+*
+* PreCondition: Only available when built with USB_SIMULATION. Called
+*   from the main loop through SYSTEM_Tasks().
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_HOST_Tasks(void);
+
+/*********************************************************************
+* Function: uint32_t USB_SIM_HOST_Frame(void);
+*
+* Overview: Returns the number of the current USB frame, the number of
+*   SOF packets sent so far.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint32_t - current frame number
+*
+********************************************************************/
+uint32_t USB_SIM_HOST_Frame(void);
+
+/*********************************************************************
+* Function: uint32_t USB_SIM_HOST_Loop(void);
+*
+* Overview: Returns the number of main loop passes so far, a finer time
+*   base than the frames.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint32_t - current main loop pass
+*
+********************************************************************/
+uint32_t USB_SIM_HOST_Loop(void);
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_Yield(void);
+*
+* Overview: Gives the main loop one pass.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_HOST_Yield(void);
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_Fail(const char *step);
+*
+* Overview: Reports the step of the script that failed and exits.
+*
+* PreCondition: None
+*
+* Input: step - description of the failed step
+*
+* Output: None, exits the program.
+*
+********************************************************************/
+void USB_SIM_HOST_Fail(const char *step);
+
+/*********************************************************************
+* Function: bool USB_SIM_HOST_TryIn(uint8_t ep, uint8_t *buffer,
+*               uint8_t *length, const char *step);
+*
+* Overview: Sends one IN token. A stall, a timeout or a wrong data
+*   toggle fails the step.
+*
+* PreCondition: Runs on the host coroutine, the device is configured.
+*
+* Input: ep - endpoint number
+*        buffer - room for a whole packet of the endpoint
+*        length - where the length of the packet is written
+*        step - description of the step
+*
+* Output: bool - true if a packet was received, false if NAKed
+*
+********************************************************************/
+bool USB_SIM_HOST_TryIn(uint8_t ep, uint8_t *buffer, uint8_t *length, const char *step);
+
+/*********************************************************************
+* Function: bool USB_SIM_HOST_TryOut(uint8_t ep, const uint8_t *data,
+*               uint8_t length, const char *step);
+*
+* Overview: Sends one OUT packet. A stall or a timeout fails the step.
+*
+* PreCondition: Runs on the host coroutine, the device is configured.
+*
+* Input: ep - endpoint number
+*        data - packet to send
+*        length - length of the packet
+*        step - description of the step
+*
+* Output: bool - true if the packet was acknowledged, false if NAKed
+*
+********************************************************************/
+bool USB_SIM_HOST_TryOut(uint8_t ep, const uint8_t *data, uint8_t length, const char *step);
+
+/*********************************************************************
+* Function: uint16_t USB_SIM_HOST_ControlRead(uint8_t requestType,
+*               uint8_t request, uint16_t value, uint16_t index,
+*               uint8_t *buffer, uint16_t length, const char *step);
+*
+* Overview: Runs a control transfer with an IN data stage.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: Fields of the setup packet, buffer for the data stage and
+*   description of the step
+*
+* Output: uint16_t - number of bytes received
+*
+********************************************************************/
+uint16_t USB_SIM_HOST_ControlRead(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, uint8_t *buffer, uint16_t length, const char *step);
+
+/*********************************************************************
+* Function: void USB_SIM_HOST_ControlWrite(uint8_t requestType,
+*               uint8_t request, uint16_t value, uint16_t index,
+*               const uint8_t *data, uint16_t length, const char *step);
+*
+* Overview: Runs a control transfer with an OUT data stage, or with no
+*   data stage when length is 0.
+*
+* PreCondition: Runs on the host coroutine.
+*
+* Input: Fields of the setup packet, data stage and description of the
+*   step
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_HOST_ControlWrite(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, const uint8_t *data, uint16_t length, const char *step);
+
+#endif //USB_SIM_HOST_H
@@ -0,0 +1,692 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/* Tests of the bridge modules that do not need the device, run by the
+ * simulated host before it enumerates it.
+ *
+ * The parser corpus feeds raw MIDI streams to MIDI_PARSER and compares the
+ * event packets that come out with the ones of the table.  A case with a
+ * split is fed in two chunks, and the events of the first chunk are
+ * checked before the second one is given, so the state a message leaves
+ * behind at the end of a packet from the host is tested too.
+ *
+ * The encoder cases do the same the other way, with the encoder state kept
+ * from one event of a case to the next, and the round trip test parses a
+ * random stream, encodes the events again and checks that parsing the
+ * result gives the same events.
+ *
+ * The router cases add their rules to a cleared MIDI_ROUTER, route the
+ * events of one direction and compare the ones that go on with the table.
+ *
+ * The queue stress test puts MIDI_QUEUE through the way the bridge uses it
+ * with BRIDGE_TRANSFER_EVENTS: an interval timer signal stands for the USB
+ * interrupt and puts whole 16 event packets while the consumer drains the
+ * queue from the main program.  Like the endpoint, the producer only takes
+ * a packet when all of its events fit, and otherwise NAKs it and tries again
+ * on the next interrupt.  The interrupts are offered faster than full-speed
+ * bulk packets arrive, and every event has to come out once and in order.
+ */
+
+/** INCLUDES *******************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "midi_parser.h"
+#include "midi_encoder.h"
+#include "midi_queue.h"
+#include "midi_router.h"
+
+#include "usb_sim_host.h"
+#include "usb_sim_test.h"
+
+/** CONSTANTS ******************************************************/
+#define USB_SIM_TEST_PACKET_EVENTS  16
+#define USB_SIM_TEST_MAX_INPUT      16
+#define USB_SIM_TEST_MAX_EVENTS     6
+#define USB_SIM_TEST_MAX_RULES      2
+#define USB_SIM_TEST_ROUND_TRIP     20000   //messages of the round trip stream
+#define USB_SIM_TEST_ROUND_TRIP_MAX (USB_SIM_TEST_ROUND_TRIP * 9)  //bytes, the longest message is a 9 byte SysEx
+
+/** TYPES **********************************************************/
+typedef struct
+{
+    const char *name;
+    uint8_t cable;
+    uint8_t length;                                 //bytes of input
+    uint8_t input[USB_SIM_TEST_MAX_INPUT];
+    uint8_t split;                                  //bytes of the first chunk, 0 to feed the input at once
+    uint8_t splitEvents;                            //events the first chunk completes
+    uint8_t events;                                 //events of the whole input
+    uint8_t expected[USB_SIM_TEST_MAX_EVENTS][4];
+} USB_SIM_TEST_PARSER_CASE;
+
+typedef struct
+{
+    const char *name;
+    uint8_t events;                                 //events of the input
+    uint8_t input[USB_SIM_TEST_MAX_EVENTS][4];
+    uint8_t length;                                 //bytes expected
+    uint8_t expected[USB_SIM_TEST_MAX_INPUT];
+} USB_SIM_TEST_ENCODER_CASE;
+
+typedef struct
+{
+    const char *name;
+    uint8_t rules;                                  //rules added before routing
+    MIDI_ROUTER_RULE rule[USB_SIM_TEST_MAX_RULES];
+    uint8_t direction;                              //MIDI_ROUTER_TO_CDC or MIDI_ROUTER_TO_MIDI
+    uint8_t events;                                 //events of the input
+    uint8_t input[USB_SIM_TEST_MAX_EVENTS][4];
+    uint8_t routed;                                 //events that go on
+    uint8_t expected[USB_SIM_TEST_MAX_EVENTS][4];
+} USB_SIM_TEST_ROUTER_CASE;
+
+/** VARIABLES ******************************************************/
+static const USB_SIM_TEST_PARSER_CASE parserCases[] =
+{
+    { "note on", 0,
+        3, { 0x90, 0x3C, 0x40 }, 0, 0,
+        1, { { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "running status", 0,
+        7, { 0x90, 0x3C, 0x40, 0x3E, 0x41, 0x40, 0x00 }, 0, 0,
+        3, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x09, 0x90, 0x3E, 0x41 }, { 0x09, 0x90, 0x40, 0x00 } } },
+    { "running status across packets", 0,
+        7, { 0xB0, 0x07, 0x64, 0x0A, 0x40, 0x0B, 0x7F }, 4, 1,
+        3, { { 0x0B, 0xB0, 0x07, 0x64 }, { 0x0B, 0xB0, 0x0A, 0x40 }, { 0x0B, 0xB0, 0x0B, 0x7F } } },
+    { "two byte channel messages", 0,
+        5, { 0xC5, 0x01, 0x02, 0xD0, 0x7F }, 0, 0,
+        3, { { 0x0C, 0xC5, 0x01, 0x00 }, { 0x0C, 0xC5, 0x02, 0x00 }, { 0x0D, 0xD0, 0x7F, 0x00 } } },
+    { "pitch bend", 0,
+        3, { 0xE0, 0x00, 0x40 }, 0, 0,
+        1, { { 0x0E, 0xE0, 0x00, 0x40 } } },
+    { "realtime inside a message", 0,
+        5, { 0x90, 0xF8, 0x3C, 0xFE, 0x40 }, 0, 0,
+        3, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x0F, 0xFE, 0x00, 0x00 }, { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "realtime keeps running status", 0,
+        6, { 0x90, 0x3C, 0x40, 0xFA, 0x3E, 0x41 }, 0, 0,
+        3, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x0F, 0xFA, 0x00, 0x00 }, { 0x09, 0x90, 0x3E, 0x41 } } },
+    { "realtime inside a SysEx", 0,
+        7, { 0xF0, 0x7E, 0xF8, 0x01, 0x02, 0xFC, 0xF7 }, 0, 0,
+        4, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x04, 0xF0, 0x7E, 0x01 }, { 0x0F, 0xFC, 0x00, 0x00 }, { 0x06, 0x02, 0xF7, 0x00 } } },
+    { "SysEx split across packets", 0,
+        8, { 0xF0, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xF7 }, 5, 1,
+        3, { { 0x04, 0xF0, 0x01, 0x02 }, { 0x04, 0x03, 0x04, 0x05 }, { 0x06, 0x06, 0xF7, 0x00 } } },
+    { "SysEx split before its EOX", 0,
+        4, { 0xF0, 0x01, 0x02, 0xF7 }, 3, 1,
+        2, { { 0x04, 0xF0, 0x01, 0x02 }, { 0x05, 0xF7, 0x00, 0x00 } } },
+    { "short SysEx", 0,
+        5, { 0xF0, 0xF7, 0xF0, 0x01, 0xF7 }, 0, 0,
+        2, { { 0x06, 0xF0, 0xF7, 0x00 }, { 0x07, 0xF0, 0x01, 0xF7 } } },
+    { "SysEx ended by a status", 0,
+        8, { 0xF0, 0x01, 0x02, 0x03, 0x04, 0x90, 0x3C, 0x40 }, 0, 0,
+        2, { { 0x04, 0xF0, 0x01, 0x02 }, { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "system common", 0,
+        8, { 0xF1, 0x10, 0xF2, 0x01, 0x02, 0xF3, 0x05, 0xF6 }, 0, 0,
+        4, { { 0x02, 0xF1, 0x10, 0x00 }, { 0x03, 0xF2, 0x01, 0x02 }, { 0x02, 0xF3, 0x05, 0x00 }, { 0x05, 0xF6, 0x00, 0x00 } } },
+    { "system common split across packets", 0,
+        3, { 0xF2, 0x01, 0x02 }, 2, 0,
+        1, { { 0x03, 0xF2, 0x01, 0x02 } } },
+    { "system common cancels running status", 0,
+        9, { 0x90, 0x3C, 0x40, 0xF3, 0x01, 0x3C, 0x40, 0x02, 0x03 }, 0, 0,
+        2, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x02, 0xF3, 0x01, 0x00 } } },
+    { "stray data bytes", 0,
+        6, { 0x01, 0x02, 0x03, 0x90, 0x3C, 0x40 }, 0, 0,
+        1, { { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "undefined status and stray EOX", 0,
+        11, { 0x90, 0x3C, 0x40, 0xF4, 0x01, 0xF5, 0x02, 0xF7, 0x03, 0x90, 0x3E }, 0, 0,
+        1, { { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "cable number", 3,
+        6, { 0xB0, 0x07, 0x64, 0xF8, 0xF0, 0xF7 }, 0, 0,
+        3, { { 0x3B, 0xB0, 0x07, 0x64 }, { 0x3F, 0xF8, 0x00, 0x00 }, { 0x36, 0xF0, 0xF7, 0x00 } } },
+};
+
+static const USB_SIM_TEST_ENCODER_CASE encoderCases[] =
+{
+    { "note on",
+        1, { { 0x09, 0x90, 0x3C, 0x40 } },
+        3, { 0x90, 0x3C, 0x40 } },
+    { "running status",
+        3, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x09, 0x90, 0x3E, 0x41 }, { 0x08, 0x80, 0x3C, 0x00 } },
+        8, { 0x90, 0x3C, 0x40, 0x3E, 0x41, 0x80, 0x3C, 0x00 } },
+    { "running status across CCs",
+        3, { { 0x0B, 0xB0, 0x07, 0x64 }, { 0x0B, 0xB0, 0x0A, 0x40 }, { 0x0B, 0xB1, 0x07, 0x64 } },
+        8, { 0xB0, 0x07, 0x64, 0x0A, 0x40, 0xB1, 0x07, 0x64 } },
+    { "two byte channel messages",
+        3, { { 0x0C, 0xC5, 0x01, 0x00 }, { 0x0C, 0xC5, 0x02, 0x00 }, { 0x0D, 0xD0, 0x7F, 0x00 } },
+        5, { 0xC5, 0x01, 0x02, 0xD0, 0x7F } },
+    { "realtime keeps running status",
+        3, { { 0x0B, 0xB0, 0x07, 0x64 }, { 0x0F, 0xF8, 0x00, 0x00 }, { 0x0B, 0xB0, 0x0A, 0x40 } },
+        6, { 0xB0, 0x07, 0x64, 0xF8, 0x0A, 0x40 } },
+    { "system common cancels running status",
+        3, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x02, 0xF3, 0x01, 0x00 }, { 0x09, 0x90, 0x3E, 0x41 } },
+        8, { 0x90, 0x3C, 0x40, 0xF3, 0x01, 0x90, 0x3E, 0x41 } },
+    { "system common",
+        4, { { 0x02, 0xF1, 0x10, 0x00 }, { 0x03, 0xF2, 0x01, 0x02 }, { 0x05, 0xF6, 0x00, 0x00 }, { 0x0F, 0xFE, 0x00, 0x00 } },
+        7, { 0xF1, 0x10, 0xF2, 0x01, 0x02, 0xF6, 0xFE } },
+    { "SysEx start, continue and end",
+        4, { { 0x04, 0xF0, 0x01, 0x02 }, { 0x04, 0x03, 0x04, 0x05 }, { 0x06, 0x06, 0xF7, 0x00 }, { 0x05, 0xF7, 0x00, 0x00 } },
+        9, { 0xF0, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0xF7, 0xF7 } },
+    { "short SysEx",
+        2, { { 0x06, 0xF0, 0xF7, 0x00 }, { 0x07, 0xF0, 0x01, 0xF7 } },
+        5, { 0xF0, 0xF7, 0xF0, 0x01, 0xF7 } },
+    { "SysEx cancels running status",
+        3, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x06, 0xF0, 0xF7, 0x00 }, { 0x09, 0x90, 0x3E, 0x41 } },
+        8, { 0x90, 0x3C, 0x40, 0xF0, 0xF7, 0x90, 0x3E, 0x41 } },
+    { "reserved CINs and padding",
+        5, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x00, 0x00, 0x00, 0x00 }, { 0x01, 0x90, 0x3C, 0x40 }, { 0x30, 0x12, 0x34, 0x56 }, { 0x09, 0x90, 0x3E, 0x41 } },
+        5, { 0x90, 0x3C, 0x40, 0x3E, 0x41 } },
+    { "cable number",
+        2, { { 0x39, 0x90, 0x3C, 0x40 }, { 0xF9, 0x90, 0x3E, 0x41 } },
+        5, { 0x90, 0x3C, 0x40, 0x3E, 0x41 } },
+    { "single bytes",
+        2, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x0F, 0x05, 0x00, 0x00 } },
+        2, { 0xF8, 0x05 } },
+};
+
+static const USB_SIM_TEST_ROUTER_CASE routerCases[] =
+{
+    { "no rule",
+        0, { { 0 } }, MIDI_ROUTER_TO_MIDI,
+        3, { { 0x09, 0x93, 0x3C, 0x40 }, { 0x0F, 0xFE, 0x00, 0x00 }, { 0x04, 0xF0, 0x01, 0x02 } },
+        3, { { 0x09, 0x93, 0x3C, 0x40 }, { 0x0F, 0xFE, 0x00, 0x00 }, { 0x04, 0xF0, 0x01, 0x02 } } },
+    { "drop active sensing",
+        1, { { MIDI_RULE_TO_MIDI, MIDI_RULE_DROP, 0xFE, 0xFE, 0, 0, 0, 0 } }, MIDI_ROUTER_TO_MIDI,
+        3, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x0F, 0xFE, 0x00, 0x00 }, { 0x09, 0x90, 0x3C, 0x40 } },
+        2, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "channel remap",
+        1, { { MIDI_RULE_TO_MIDI, MIDI_RULE_CHANNEL, 0x80, 0x9F, 5, 0, 0, 0 } }, MIDI_ROUTER_TO_MIDI,
+        4, { { 0x09, 0x90, 0x3C, 0x40 }, { 0x08, 0x8A, 0x3C, 0x00 }, { 0x0B, 0xB0, 0x07, 0x64 }, { 0x0F, 0xF8, 0x00, 0x00 } },
+        4, { { 0x09, 0x95, 0x3C, 0x40 }, { 0x08, 0x85, 0x3C, 0x00 }, { 0x0B, 0xB0, 0x07, 0x64 }, { 0x0F, 0xF8, 0x00, 0x00 } } },
+    { "channel remap of the other direction",
+        1, { { MIDI_RULE_TO_CDC, MIDI_RULE_CHANNEL, 0x80, 0x9F, 5, 0, 0, 0 } }, MIDI_ROUTER_TO_MIDI,
+        1, { { 0x09, 0x90, 0x3C, 0x40 } },
+        1, { { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "keyboard split",
+        2, { { MIDI_RULE_TO_MIDI, MIDI_RULE_ZONE, 0x80, 0x9F, 1, 0x00, 0x3B, 0 },
+             { MIDI_RULE_TO_MIDI, MIDI_RULE_ZONE, 0x80, 0x9F, 2, 0x3C, 0x7F, 0 } }, MIDI_ROUTER_TO_MIDI,
+        4, { { 0x09, 0x90, 0x3B, 0x40 }, { 0x09, 0x90, 0x3C, 0x40 }, { 0x08, 0x80, 0x3C, 0x00 }, { 0x0B, 0xB0, 0x3C, 0x64 } },
+        4, { { 0x09, 0x91, 0x3B, 0x40 }, { 0x09, 0x92, 0x3C, 0x40 }, { 0x08, 0x82, 0x3C, 0x00 }, { 0x0B, 0xB0, 0x3C, 0x64 } } },
+    { "notes outside the zone keep their channel",
+        1, { { MIDI_RULE_TO_MIDI, MIDI_RULE_ZONE, 0x90, 0x9F, 1, 0x00, 0x3B, 0 } }, MIDI_ROUTER_TO_MIDI,
+        2, { { 0x09, 0x93, 0x3B, 0x40 }, { 0x09, 0x93, 0x3C, 0x40 } },
+        2, { { 0x09, 0x91, 0x3B, 0x40 }, { 0x09, 0x93, 0x3C, 0x40 } } },
+    { "zones of each direction, to MIDI",
+        2, { { MIDI_RULE_TO_MIDI, MIDI_RULE_ZONE, 0x90, 0x9F, 4, 0x00, 0x7F, 0 },
+             { MIDI_RULE_TO_CDC, MIDI_RULE_ZONE, 0x90, 0x9F, 3, 0x00, 0x7F, 0 } }, MIDI_ROUTER_TO_MIDI,
+        1, { { 0x09, 0x90, 0x3C, 0x40 } },
+        1, { { 0x09, 0x94, 0x3C, 0x40 } } },
+    { "zones of each direction, to CDC",
+        2, { { MIDI_RULE_TO_CDC, MIDI_RULE_ZONE, 0x90, 0x9F, 3, 0x00, 0x7F, 0 },
+             { MIDI_RULE_TO_MIDI, MIDI_RULE_ZONE, 0x90, 0x9F, 4, 0x00, 0x7F, 0 } }, MIDI_ROUTER_TO_CDC,
+        1, { { 0x09, 0x90, 0x3C, 0x40 } },
+        1, { { 0x09, 0x93, 0x3C, 0x40 } } },
+    { "SysEx drop",
+        1, { { MIDI_RULE_TO_CDC, MIDI_RULE_DROP, 0xF0, 0xF0, 0, 0, 0, 0 } }, MIDI_ROUTER_TO_CDC,
+        6, { { 0x04, 0xF0, 0x01, 0x02 }, { 0x04, 0x03, 0x04, 0x05 }, { 0x0F, 0xF8, 0x00, 0x00 }, { 0x05, 0xF7, 0x00, 0x00 },
+             { 0x07, 0xF0, 0x01, 0xF7 }, { 0x09, 0x90, 0x3C, 0x40 } },
+        2, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x09, 0x90, 0x3C, 0x40 } } },
+    { "SysEx drop, two byte ends",
+        1, { { MIDI_RULE_TO_CDC, MIDI_RULE_DROP, 0xF0, 0xF0, 0, 0, 0, 0 } }, MIDI_ROUTER_TO_CDC,
+        4, { { 0x04, 0xF0, 0x01, 0x02 }, { 0x06, 0x03, 0xF7, 0x00 }, { 0x06, 0xF0, 0xF7, 0x00 }, { 0x0F, 0xFE, 0x00, 0x00 } },
+        1, { { 0x0F, 0xFE, 0x00, 0x00 } } },
+    { "pass undoes a drop",
+        2, { { MIDI_RULE_TO_MIDI, MIDI_RULE_DROP, 0xF8, 0xFF, 0, 0, 0, 0 },
+             { MIDI_RULE_TO_MIDI, MIDI_RULE_PASS, 0xF8, 0xF8, 0, 0, 0, 0 } }, MIDI_ROUTER_TO_MIDI,
+        3, { { 0x0F, 0xF8, 0x00, 0x00 }, { 0x0F, 0xFE, 0x00, 0x00 }, { 0x0F, 0xFF, 0x00, 0x00 } },
+        1, { { 0x0F, 0xF8, 0x00, 0x00 } } },
+};
+
+static MIDI_PARSER testParser;
+static MIDI_ENCODER testEncoder;
+static uint8_t roundTripStream[USB_SIM_TEST_ROUND_TRIP_MAX];
+static uint8_t roundTripEncoded[USB_SIM_TEST_ROUND_TRIP_MAX];
+static USB_AUDIO_MIDI_EVENT_PACKET roundTripEvents[USB_SIM_TEST_ROUND_TRIP_MAX];
+static MIDI_QUEUE stressQueue;
+static volatile uint32_t stressPut;
+static volatile uint32_t stressNaks;
+
+/** PRIVATE PROTOTYPES *********************************************/
+static void USB_SIM_TEST_ParserCorpus(void);
+static void USB_SIM_TEST_EncoderCorpus(void);
+static void USB_SIM_TEST_RoundTrip(void);
+static void USB_SIM_TEST_RouterCorpus(void);
+static void USB_SIM_TEST_QueueStress(void);
+static void USB_SIM_TEST_QueueProducer(int signal);
+
+/*********************************************************************
+* Function: void USB_SIM_TEST_Run(void);
+*
+* Overview: Runs the tests of the bridge modules that need no device,
+*   and prints one line per test. A failed test fails the run through
+*   USB_SIM_HOST_Fail().
+*
+* PreCondition: Only available when built with USB_SIMULATION.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_TEST_Run(void)
+{
+    USB_SIM_TEST_ParserCorpus();
+    USB_SIM_TEST_EncoderCorpus();
+    USB_SIM_TEST_RoundTrip();
+    USB_SIM_TEST_RouterCorpus();
+    USB_SIM_TEST_QueueStress();
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_TEST_ParserCorpus(void);
+*
+* Overview: Runs every case of parserCases through a fresh parser and
+*   checks the events it completes, and at which chunk.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_TEST_ParserCorpus(void)
+{
+    const USB_SIM_TEST_PARSER_CASE *test;
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint8_t count;
+    uint8_t i;
+    uint8_t j;
+
+    for(i = 0; i < (sizeof(parserCases) / sizeof(parserCases[0])); i++)
+    {
+        test = &parserCases[i];
+        MIDI_PARSER_Initialize(&testParser, test->cable);
+        count = 0;
+
+        for(j = 0; j < test->length; j++)
+        {
+            if((test->split != 0) && (j == test->split) && (count != test->splitEvents))
+            {
+                USB_SIM_HOST_Fail(test->name);
+            }
+
+            if(MIDI_PARSER_Parse(&testParser, test->input[j], &event) == true)
+            {
+                if((count == test->events) || (memcmp(event.v, test->expected[count], sizeof(event.v)) != 0))
+                {
+                    USB_SIM_HOST_Fail(test->name);
+                }
+                count++;
+            }
+        }
+
+        if(count != test->events)
+        {
+            USB_SIM_HOST_Fail(test->name);
+        }
+    }
+
+    printf("parser corpus: %u cases passed\n", (unsigned)(sizeof(parserCases) / sizeof(parserCases[0])));
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_TEST_EncoderCorpus(void);
+*
+* Overview: Runs the events of every case of encoderCases through a
+*   fresh encoder and checks the bytes that come out.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_TEST_EncoderCorpus(void)
+{
+    const USB_SIM_TEST_ENCODER_CASE *test;
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint8_t buffer[USB_SIM_TEST_MAX_EVENTS * MIDI_ENCODER_MAX_LENGTH];
+    uint8_t length;
+    uint8_t i;
+    uint8_t j;
+
+    for(i = 0; i < (sizeof(encoderCases) / sizeof(encoderCases[0])); i++)
+    {
+        test = &encoderCases[i];
+        MIDI_ENCODER_Initialize(&testEncoder);
+        length = 0;
+
+        for(j = 0; j < test->events; j++)
+        {
+            memcpy(event.v, test->input[j], sizeof(event.v));
+            length += MIDI_ENCODER_Encode(&testEncoder, &event, &buffer[length]);
+        }
+
+        if((length != test->length) || (memcmp(buffer, test->expected, length) != 0))
+        {
+            USB_SIM_HOST_Fail(test->name);
+        }
+    }
+
+    printf("encoder corpus: %u cases passed\n", (unsigned)(sizeof(encoderCases) / sizeof(encoderCases[0])));
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_TEST_RoundTrip(void);
+*
+* Overview: Parses a random stream of channel messages with and without
+*   running status, system common messages, SysEx and realtime messages
+*   dropped in anywhere, encodes the events and parses the result again.
+*   Both parsers have to give the same events.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_TEST_RoundTrip(void)
+{
+    static const uint8_t systemCommon[] = { 0xF1, 0xF2, 0xF3, 0xF6 };
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint32_t length = 0;
+    uint32_t encoded = 0;
+    uint32_t events = 0;
+    uint32_t matched = 0;
+    uint32_t i;
+    uint8_t status = 0;
+    uint8_t data;
+    uint8_t j;
+
+    srand(1);
+
+    for(i = 0; i < USB_SIM_TEST_ROUND_TRIP; i++)
+    {
+        switch(rand() % 8)
+        {
+            case 0:
+                roundTripStream[length++] = 0xF8 + (rand() % 8);
+                break;
+
+            case 1:
+                status = systemCommon[rand() % sizeof(systemCommon)];
+                roundTripStream[length++] = status;
+                data = (status == 0xF6) ? 0 : (status == 0xF2) ? 2 : 1;
+                for(j = 0; j < data; j++)
+                {
+                    roundTripStream[length++] = rand() & 0x7F;
+                }
+                status = 0;
+                break;
+
+            case 2:
+                roundTripStream[length++] = 0xF0;
+                data = rand() % 8;
+                for(j = 0; j < data; j++)
+                {
+                    //Realtime messages may show up inside a SysEx too
+                    roundTripStream[length++] = ((rand() % 8) == 0) ? 0xF8 : (rand() & 0x7F);
+                }
+                roundTripStream[length++] = 0xF7;
+                status = 0;
+                break;
+
+            default:
+                //Running status half of the time once there is one
+                if((status == 0) || (rand() & 0x01))
+                {
+                    status = 0x80 + (rand() % 0x70);
+                    roundTripStream[length++] = status;
+                }
+                roundTripStream[length++] = rand() & 0x7F;
+                if((status & 0xE0) != 0xC0)
+                {
+                    roundTripStream[length++] = rand() & 0x7F;
+                }
+                break;
+        }
+    }
+
+    MIDI_PARSER_Initialize(&testParser, 0);
+    MIDI_ENCODER_Initialize(&testEncoder);
+    for(i = 0; i < length; i++)
+    {
+        if(MIDI_PARSER_Parse(&testParser, roundTripStream[i], &event) == true)
+        {
+            roundTripEvents[events++] = event;
+            encoded += MIDI_ENCODER_Encode(&testEncoder, &event, &roundTripEncoded[encoded]);
+        }
+    }
+
+    MIDI_PARSER_Initialize(&testParser, 0);
+    for(i = 0; i < encoded; i++)
+    {
+        if(MIDI_PARSER_Parse(&testParser, roundTripEncoded[i], &event) == true)
+        {
+            if((matched == events) || (event.Val != roundTripEvents[matched].Val))
+            {
+                USB_SIM_HOST_Fail("encoder round trip");
+            }
+            matched++;
+        }
+    }
+
+    if((matched != events) || (encoded > length))
+    {
+        USB_SIM_HOST_Fail("encoder round trip");
+    }
+
+    printf("encoder round trip: %lu events, %lu bytes in, %lu bytes out\n",
+           (unsigned long)events, (unsigned long)length, (unsigned long)encoded);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_TEST_RouterCorpus(void);
+*
+* Overview: Adds the rules of every case of routerCases to a cleared
+*   router, routes the events of the case and checks the ones that go on.
+*   The router is cleared again at the end, for the device.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_TEST_RouterCorpus(void)
+{
+    const USB_SIM_TEST_ROUTER_CASE *test;
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    bool passThrough;
+    uint8_t count;
+    uint8_t i;
+    uint8_t j;
+
+    for(i = 0; i < (sizeof(routerCases) / sizeof(routerCases[0])); i++)
+    {
+        test = &routerCases[i];
+        MIDI_ROUTER_Initialize();
+        passThrough = true;
+
+        for(j = 0; j < test->rules; j++)
+        {
+            if(MIDI_ROUTER_AddRule(&test->rule[j]) == false)
+            {
+                USB_SIM_HOST_Fail(test->name);
+            }
+
+            if((test->rule[j].directions & (1 << test->direction)) != 0)
+            {
+                passThrough = false;
+            }
+        }
+
+        //Only the rules of its own direction take a direction off the fast path
+        if(MIDI_ROUTER_IsPassThrough(test->direction) != passThrough)
+        {
+            USB_SIM_HOST_Fail(test->name);
+        }
+
+        count = 0;
+        for(j = 0; j < test->events; j++)
+        {
+            memcpy(event.v, test->input[j], sizeof(event.v));
+
+            if(MIDI_ROUTER_Route(test->direction, &event) == true)
+            {
+                if((count == test->routed) || (memcmp(event.v, test->expected[count], sizeof(event.v)) != 0))
+                {
+                    USB_SIM_HOST_Fail(test->name);
+                }
+                count++;
+            }
+        }
+
+        if(count != test->routed)
+        {
+            USB_SIM_HOST_Fail(test->name);
+        }
+    }
+
+    MIDI_ROUTER_Initialize();
+
+    printf("router corpus: %u cases passed\n", (unsigned)(sizeof(routerCases) / sizeof(routerCases[0])));
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_TEST_QueueStress(void);
+*
+* Overview: Drains the queue while the producer signal fills it, checks
+*   that the events come out once and in order and that the queue never
+*   overflowed, and prints the event rate reached.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_TEST_QueueStress(void)
+{
+    struct sigaction action;
+    struct itimerval timer;
+    struct timespec start;
+    struct timespec end;
+    uint8_t buffer[USB_SIM_TEST_PACKET_EVENTS * sizeof(USB_AUDIO_MIDI_EVENT_PACKET)];
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint32_t expected = 0;
+    uint32_t total = (uint32_t)USB_SIM_TEST_STRESS_PACKETS * USB_SIM_TEST_PACKET_EVENTS;
+    uint8_t length;
+    uint8_t i;
+    double seconds;
+
+    MIDI_QUEUE_Initialize(&stressQueue);
+    stressPut = 0;
+    stressNaks = 0;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = USB_SIM_TEST_QueueProducer;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = USB_SIM_TEST_STRESS_PERIOD;
+    timer.it_value = timer.it_interval;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    while(expected < total)
+    {
+        length = MIDI_QUEUE_Read(&stressQueue, buffer, USB_SIM_TEST_PACKET_EVENTS);
+
+        for(i = 0; i < length; i += sizeof(USB_AUDIO_MIDI_EVENT_PACKET))
+        {
+            memcpy(&event, &buffer[i], sizeof(event));
+            if(event.Val != expected)
+            {
+                USB_SIM_HOST_Fail("queue stress order");
+            }
+            expected++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_REAL, &timer, NULL);
+    signal(SIGALRM, SIG_DFL);
+
+    if((stressQueue.overflows != 0) || (MIDI_QUEUE_IsEmpty(&stressQueue) == false))
+    {
+        USB_SIM_HOST_Fail("queue stress loss");
+    }
+
+    seconds = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1e9);
+    printf("queue stress: %lu events, 0 lost, %.0f events/s (full-speed bulk %u events/s), %lu packets NAKed\n",
+           (unsigned long)total, total / seconds, USB_SIM_TEST_FULL_SPEED_EVENTS, (unsigned long)stressNaks);
+}
+
+/*********************************************************************
+* Function: static void USB_SIM_TEST_QueueProducer(int signal);
+*
+* Overview: Interrupt of the stress test, puts the next packet of 16
+*   numbered events if all of them fit, or NAKs it.
+*
+* PreCondition: Installed as the SIGALRM handler.
+*
+* Input: signal - unused
+*
+* Output: None
+*
+********************************************************************/
+static void USB_SIM_TEST_QueueProducer(int signal)
+{
+    USB_AUDIO_MIDI_EVENT_PACKET event;
+    uint8_t i;
+
+    (void)signal;
+
+    if(stressPut >= ((uint32_t)USB_SIM_TEST_STRESS_PACKETS * USB_SIM_TEST_PACKET_EVENTS))
+    {
+        return;
+    }
+
+    if(MIDI_QUEUE_Free(&stressQueue) < USB_SIM_TEST_PACKET_EVENTS)
+    {
+        stressNaks++;
+        return;
+    }
+
+    for(i = 0; i < USB_SIM_TEST_PACKET_EVENTS; i++)
+    {
+        event.Val = stressPut++;
+        MIDI_QUEUE_Put(&stressQueue, &event);
+    }
+}
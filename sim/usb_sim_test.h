@@ -0,0 +1,44 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef USB_SIM_TEST_H
+#define USB_SIM_TEST_H
+
+/** CONSTANTS ******************************************************/
+#define USB_SIM_TEST_STRESS_PACKETS     20000   //16 event packets put by the stress test producer
+#define USB_SIM_TEST_STRESS_PERIOD      50      //us between two producer interrupts
+#define USB_SIM_TEST_FULL_SPEED_EVENTS  304000  //events/s of 19 bulk packets per full-speed frame
+
+/*********************************************************************
+* Function: void USB_SIM_TEST_Run(void);
+*
+* Overview: Runs the tests of the bridge modules that need no device,
+*   and prints one line per test. A failed test fails the run through
+*   USB_SIM_HOST_Fail().
+*
+* PreCondition: Only available when built with USB_SIMULATION.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void USB_SIM_TEST_Run(void);
+
+#endif //USB_SIM_TEST_H
@@ -0,0 +1,33 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+/* PIC18F4550 registers used outside of the USB module, see xc.h */
+
+/** INCLUDES *******************************************************/
+#include <xc.h>
+
+/** VARIABLES ******************************************************/
+volatile PORTAbits_t PORTAbits = { 0x30 };  //buttons on RA4 and RA5 released
+volatile PORTAbits_t TRISAbits = { 0xFF };
+volatile PORTDbits_t LATDbits;
+volatile PORTDbits_t TRISDbits = { 0xFF };
+
+volatile uint8_t ADCON1;
+volatile uint8_t T1CON;
+volatile uint16_t TMR1;
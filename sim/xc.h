@@ -0,0 +1,105 @@
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license), 
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+
+#ifndef XC_H
+#define XC_H
+
+/* Stand-in for the XC8 device header when the firmware is built for the
+ * simulation backend (USB_SIMULATION).  The PIC18F4550 registers used
+ * outside of the USB module are plain variables, defined in
+ * usb_sim_host.c. */
+
+#include <stdint.h>
+
+#if !defined(USB_SIMULATION)
+    #error "sim/xc.h is only meant for the simulation backend."
+#endif
+
+#define __18F4550
+
+#define __delay_ms(x)
+#define __delay_us(x)
+#define Nop()
+#define ClrWdt()
+#define Sleep()
+
+typedef union
+{
+    uint8_t Val;
+    struct
+    {
+        uint8_t RA0:1;
+        uint8_t RA1:1;
+        uint8_t RA2:1;
+        uint8_t RA3:1;
+        uint8_t RA4:1;
+        uint8_t RA5:1;
+        uint8_t RA6:1;
+        uint8_t :1;
+    };
+    struct
+    {
+        uint8_t TRISA0:1;
+        uint8_t TRISA1:1;
+        uint8_t TRISA2:1;
+        uint8_t TRISA3:1;
+        uint8_t TRISA4:1;
+        uint8_t TRISA5:1;
+        uint8_t TRISA6:1;
+        uint8_t :1;
+    };
+} PORTAbits_t;
+
+typedef union
+{
+    uint8_t Val;
+    struct
+    {
+        uint8_t LATD0:1;
+        uint8_t LATD1:1;
+        uint8_t LATD2:1;
+        uint8_t LATD3:1;
+        uint8_t LATD4:1;
+        uint8_t LATD5:1;
+        uint8_t LATD6:1;
+        uint8_t LATD7:1;
+    };
+    struct
+    {
+        uint8_t TRISD0:1;
+        uint8_t TRISD1:1;
+        uint8_t TRISD2:1;
+        uint8_t TRISD3:1;
+        uint8_t TRISD4:1;
+        uint8_t TRISD5:1;
+        uint8_t TRISD6:1;
+        uint8_t TRISD7:1;
+    };
+} PORTDbits_t;
+
+extern volatile PORTAbits_t PORTAbits;
+extern volatile PORTAbits_t TRISAbits;
+extern volatile PORTDbits_t LATDbits;
+extern volatile PORTDbits_t TRISDbits;
+
+extern volatile uint8_t ADCON1;
+extern volatile uint8_t T1CON;
+extern volatile uint16_t TMR1;
+
+#endif //XC_H
@@ -19,6 +19,9 @@ please contact mla_licensing@microchip.com
 
 #include "system.h"
 #include "usb_device.h"
+#include "cycle_counter.h"
+#include "residency.h"
+#include "scheduler.h"
 
 /** CONFIGURATION Bits **********************************************/
 #pragma config PLLDIV   = 5         // (20 MHz crystal on PICDEM FS USB board)
@@ -81,6 +84,9 @@ void SYSTEM_Initialize( SYSTEM_STATE state )
             ADCON1 = 0x0F; // All digital I/O
             LED_Enable(LED_USB_DEVICE_STATE);
             BUTTON_Enable(BUTTON_DEVICE_AUDIO_MIDI);
+            CYCLE_COUNTER_Initialize();
+            RESIDENCY_Initialize();
+            SCHEDULER_Initialize();
             break;
             
         case SYSTEM_STATE_USB_SUSPEND: 
@@ -96,6 +102,8 @@ void SYSTEM_Initialize( SYSTEM_STATE state )
 #if defined(__XC8) && defined(USB_INTERRUPT)
 void interrupt SYS_InterruptHigh(void)
 {
+    CYCLE_COUNTER_Enter(CYCLE_COUNTER_USB_DEVICE_TASKS);
     USBDeviceTasks();
+    CYCLE_COUNTER_Exit(CYCLE_COUNTER_USB_DEVICE_TASKS);
 }
 #endif
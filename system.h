@@ -31,7 +31,13 @@ please contact mla_licensing@microchip.com
 
 #include "usb_config.h"
 
-#define MAIN_RETURN void
+#if defined(USB_SIMULATION)
+    #include "usb_sim_host.h"
+
+    #define MAIN_RETURN int
+#else
+    #define MAIN_RETURN void
+#endif
 
 /*** System States **************************************************/
 typedef enum
@@ -68,6 +74,10 @@ void SYSTEM_Initialize( SYSTEM_STATE state );
 *
 ********************************************************************/
 //void SYSTEM_Tasks(void);
-#define SYSTEM_Tasks()
+#if defined(USB_SIMULATION)
+    #define SYSTEM_Tasks() USB_SIM_HOST_Tasks()
+#else
+    #define SYSTEM_Tasks()
+#endif
 
 #endif //SYSTEM_H
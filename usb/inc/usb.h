@@ -56,6 +56,7 @@ please contact mla_licensing@microchip.com
 #endif
 
 #include "usb_hal.h"            // Hardware Abstraction Layer interface
+#include "usb_memcpy.h"         // Block copies to and from the endpoint buffers
 
 /* USB Library version number.  This can be used to verify in an application 
    specific version of the library is being used.
@@ -62,6 +62,9 @@ please contact mla_licensing@microchip.com
 #define USB_EP0_NO_DATA        0x00     //no data to send
 #define USB_EP0_NO_OPTIONS     0x00     //no options set
 
+#define USB_TRANSFER_ZLP        0x01    //end a transfer of full packets with a zero length packet
+#define USB_TRANSFER_NO_OPTIONS 0x00    //no options set
+
 /********************************************************************
  * Standard Request Codes
  * USB 2.0 Spec Ref Table 9-4
@@ -162,6 +165,12 @@ typedef enum
 
 } USB_DEVICE_STACK_EVENTS;
 
+/* Transfer complete callback registered with USBDeviceSetTransferCallback().
+   It is called by USBDeviceTasks() with the context pointer given when it was
+   registered, each time the SIE hands a buffer descriptor of the endpoint and
+   direction back to the CPU. */
+typedef void (*USB_TRANSFER_CALLBACK)(void *context);
+
 /** Function Prototypes **********************************************/
 
 
@@ -351,6 +360,152 @@ void USBDeviceTasks(void);
 void USBEnableEndpoint(uint8_t ep, uint8_t options);
 
 
+/*******************************************************************************
+  Function:
+        void USBDeviceSetTransferCallback(uint8_t ep, uint8_t direction,
+                        USB_TRANSFER_CALLBACK callback, void *context)
+    
+  Summary:
+    Registers the function called when a transaction completes on the
+    specified endpoint and direction.
+  Description:
+    Registers the function called when a transaction completes on the
+    specified endpoint and direction.  USBDeviceTasks() looks the callback up
+    in a table indexed by endpoint and direction right after reading USTAT, so
+    the class driver is called directly instead of going through the
+    EVENT_TRANSFER case of the USB_TRANSFER_COMPLETE_HANDLER() event switch.
+    Transactions on endpoints without a registered callback are still reported
+    with EVENT_TRANSFER.
+    
+    All callbacks are removed on bus reset and when a SET_CONFIGURATION
+    request is received, so they should be registered again from the
+    EVENT_CONFIGURED handler, together with the USBEnableEndpoint() calls.
+    
+    Typical Usage:
+    <code>
+    void CDCInitEP(void)
+    {
+        USBEnableEndpoint(CDC_DATA_EP,USB_IN_ENABLED|USB_OUT_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
+        USBDeviceSetTransferCallback(CDC_DATA_EP, IN_TO_HOST, CDCTxComplete, NULL);
+    }
+    </code>
+  Conditions:
+    None
+  Input:
+    uint8_t ep -                    the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction -             OUT_FROM_HOST or IN_TO_HOST
+    USB_TRANSFER_CALLBACK callback - function to call, NULL removes the
+                                    callback
+    void *context -                 pointer passed back to the callback
+  Return:
+    None
+  Remarks:
+    When the stack runs in USB_INTERRUPT mode the callback is executed from the
+    interrupt context, it should be short and must not call USBDeviceTasks().
+    The table entry is not updated atomically, callbacks should be registered
+    from the EVENT_CONFIGURED handler or with the USB interrupt masked.
+    EP0 is always serviced by the stack and can not have a callback.
+  *****************************************************************************/
+void USBDeviceSetTransferCallback(uint8_t ep, uint8_t direction, USB_TRANSFER_CALLBACK callback, void *context);
+
+
+/*******************************************************************************
+  Function:
+        bool USBDeviceTransfer(uint8_t ep, uint8_t direction, uint8_t *data,
+                        uint16_t length, uint8_t maxPacketSize, uint8_t options)
+    
+  Summary:
+    Moves a buffer of any length over a non-EP0 endpoint, one packet after
+    the other, without the caller handling each packet.
+  Description:
+    Moves a buffer of any length over a non-EP0 endpoint.  The buffer is cut
+    in maxPacketSize packets which are loaded by USBDeviceTasks() as the
+    previous ones complete, and the callback registered with
+    USBDeviceSetTransferCallback() is called once, when the whole transfer is
+    done, instead of after each packet.
+    
+    IN transfers keep both ping-pong buffer descriptors of the endpoint loaded
+    when ping-pong buffering is enabled.  With USB_TRANSFER_ZLP a transfer
+    whose length is a multiple of maxPacketSize is terminated with a zero
+    length packet, so the host does not wait for more data.
+    
+    OUT transfers end when length bytes have been received or on a short
+    packet, USBDeviceTransferLength() then gives the number of bytes
+    received.  Only one OUT packet is armed at a time, the end of the
+    transfer is only known once the previous packet has been received.
+    
+    Typical Usage:
+    <code>
+    //Sends a 200 byte buffer as 64 + 64 + 64 + 8 byte packets
+    if(USBDeviceTransferBusy(CDC_DATA_EP, IN_TO_HOST) == false)
+    {
+        USBDeviceTransfer(CDC_DATA_EP, IN_TO_HOST, buffer, 200, CDC_DATA_IN_EP_SIZE, USB_TRANSFER_ZLP);
+    }
+    </code>
+  Conditions:
+    The endpoint has to be enabled with USBEnableEndpoint().
+  Input:
+    uint8_t ep -            the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction -     OUT_FROM_HOST or IN_TO_HOST
+    uint8_t *data -         buffer to send or to receive into, it must be in
+                            RAM the USB module can access and stay untouched
+                            until the transfer is done
+    uint16_t length -       number of bytes to transfer, 0 transfers a single
+                            zero length packet
+    uint8_t maxPacketSize - wMaxPacketSize of the endpoint
+    uint8_t options -       USB_TRANSFER_ZLP or USB_TRANSFER_NO_OPTIONS
+  Return:
+    bool - false if a transfer is already in progress on the endpoint and
+    direction, or if the endpoint is not valid.
+  Remarks:
+    USBTransferOnePacket() must not be used on the endpoint and direction
+    while the transfer is in progress.  OUT transfer lengths should be a
+    multiple of maxPacketSize, a packet larger than the room left in the
+    buffer is an error.
+  *****************************************************************************/
+bool USBDeviceTransfer(uint8_t ep, uint8_t direction, uint8_t *data, uint16_t length, uint8_t maxPacketSize, uint8_t options);
+
+
+/*******************************************************************************
+  Function:
+        bool USBDeviceTransferBusy(uint8_t ep, uint8_t direction)
+    
+  Summary:
+    Checks if a transfer started with USBDeviceTransfer() is in progress.
+  Conditions:
+    None
+  Input:
+    uint8_t ep -        the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction - OUT_FROM_HOST or IN_TO_HOST
+  Return:
+    bool - true until the last packet of the transfer has completed.
+  Remarks:
+    None
+  *****************************************************************************/
+bool USBDeviceTransferBusy(uint8_t ep, uint8_t direction);
+
+
+/*******************************************************************************
+  Function:
+        uint16_t USBDeviceTransferLength(uint8_t ep, uint8_t direction)
+    
+  Summary:
+    Returns the number of bytes moved by the packets of the last transfer
+    started with USBDeviceTransfer() that have completed.
+  Conditions:
+    None
+  Input:
+    uint8_t ep -        the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction - OUT_FROM_HOST or IN_TO_HOST
+  Return:
+    uint16_t - bytes sent or received so far, the length of the transfer
+    once USBDeviceTransferBusy() is false.
+  Remarks:
+    None
+  *****************************************************************************/
+uint16_t USBDeviceTransferLength(uint8_t ep, uint8_t direction);
+
+
 /*************************************************************************
   Function:
     USB_HANDLE USBTransferOnePacket(uint8_t ep, uint8_t dir, uint8_t* data, uint8_t len)
@@ -95,6 +95,7 @@ please contact mla_licensing@microchip.com
 #define CDC_TX_BUSY                 1
 #define CDC_TX_BUSY_ZLP             2       // ZLP: Zero Length Packet
 #define CDC_TX_COMPLETING           3
+#define CDC_TX_DIRECT               4       // CDCSendDirect() transfer
 
 #if defined(USB_CDC_SET_LINE_CODING_HANDLER) 
     #define LINE_CODING_TARGET &cdc_notice.SetLineCoding._byte[0]
@@ -388,10 +389,56 @@ please contact mla_licensing@microchip.com
         Make sure the application periodically calls the CDCTxService()
         handler, or pending USB IN transfers will not be able to advance
         and complete.
+
+        When the bulk data IN endpoint uses ping-pong buffering, true only
+        means that one of the two IN buffers is free; the previous packet may
+        still be on the bus (see USBUSARTIsTxOnBus()).
   
  *****************************************************************************/
 #define USBUSARTIsTxTrfReady()      (cdc_trf_state == CDC_TX_READY)
 
+/******************************************************************************
+    Function:
+        bool USBUSARTIsTxOnBus(void)
+        
+    Summary:
+        This macro is used to check if the last packet loaded by
+        CDCTxService() is still waiting to be read by the host.
+
+    Description:
+        When the bulk IN endpoint uses ping-pong buffering,
+        USBUSARTIsTxTrfReady() already returns true while the previous packet
+        is still on the bus, so that the next one can be loaded in the other
+        buffer.  This macro tells both cases apart.  An application streaming
+        data can use it to keep accumulating data while a packet is on the
+        bus, and send fewer but fuller packets.
+
+        Typical Usage:
+        <code>
+            if(USBUSARTIsTxTrfReady() && 
+               ((USBUSARTIsTxOnBus() == false) || (count >= CDC_DATA_IN_EP_SIZE)))
+            {
+                putUSBUSART(buffer, count);
+            }
+        </code>
+        
+    PreCondition:
+        The return value of this function is only valid if the device is in a
+        configured state (i.e. - USBDeviceGetState() returns CONFIGURED_STATE)
+        
+    Parameters:
+        None
+        
+    Return Values:
+        true if a packet is armed on the bulk data IN endpoint, false if all
+        of the packets sent so far have been read by the host.
+        
+    Remarks:
+        None
+  
+ *****************************************************************************/
+#define USBUSARTIsTxOnBus()         USBHandleBusy(CDCDataInHandle)
+
 /******************************************************************************
     Function:
         void mUSBUSARTTxRam(uint8_t *pData, uint8_t len)
@@ -404,7 +451,7 @@ please contact mla_licensing@microchip.com
 
 /******************************************************************************
     Function:
-        void mUSBUSARTTxRam(uint8_t *pData, uint8_t len)
+        void mUSBUSARTTxRam(uint8_t *pData, uint16_t len)
         
     Description:
         Use this macro to transfer data located in data memory.
@@ -426,7 +473,6 @@ please contact mla_licensing@microchip.com
         
     PreCondition:
         cdc_trf_state must be in the CDC_TX_READY state.
-        Value of 'len' must be equal to or smaller than 255 bytes.
         The USB stack should have reached the CONFIGURED_STATE prior
         to calling this API function for the first time.
         
@@ -458,7 +504,7 @@ please contact mla_licensing@microchip.com
 
 /******************************************************************************
     Function:
-        void mUSBUSARTTxRom(rom uint8_t *pData, uint8_t len)
+        void mUSBUSARTTxRom(rom uint8_t *pData, uint16_t len)
         
     Description:
         Use this macro to transfer data located in program memory.
@@ -481,7 +527,6 @@ please contact mla_licensing@microchip.com
        
     PreCondition:
         cdc_trf_state must be in the CDC_TX_READY state.
-        Value of 'len' must be equal to or smaller than 255 bytes.
         
     Parameters:
         pDdata  : Pointer to the starting location of data bytes
@@ -535,6 +580,51 @@ please contact mla_licensing@microchip.com
   **************************************************************************/
 void CDCInitEP(void);
 
+/**************************************************************************
+  Function:
+        void CDCSetRxCallback(USB_TRANSFER_CALLBACK callback, void *context)
+    
+  Summary:
+    Registers the function called when a packet is received through the
+    USB CDC Bulk OUT endpoint.
+  Description:
+    Registers the function called when a packet is received through the
+    USB CDC Bulk OUT endpoint.  The packet can be read from the callback with
+    getsUSBUSART() or CDCPeek().
+  Conditions:
+    CDCInitEP() must have been called previously.
+  Input:
+    callback -  function to call, NULL removes the callback
+    context -   pointer passed back to the callback
+  Remarks:
+    The callback runs from USBDeviceTasks(), in the interrupt context when
+    USB_INTERRUPT is used.
+  **************************************************************************/
+void CDCSetRxCallback(USB_TRANSFER_CALLBACK callback, void *context);
+
+/**************************************************************************
+  Function:
+        void CDCSetTxCallback(USB_TRANSFER_CALLBACK callback, void *context)
+    
+  Summary:
+    Registers the function called when a packet has been sent through the
+    USB CDC Bulk IN endpoint.
+  Description:
+    Registers the function called when a packet has been sent through the
+    USB CDC Bulk IN endpoint.  The driver first runs CDCTxService() to load
+    the next packet of the current transfer, so the callback can check
+    USBUSARTIsTxTrfReady() and start the next one with putUSBUSART().
+  Conditions:
+    CDCInitEP() must have been called previously, it removes the callback.
+  Input:
+    callback -  function to call, NULL removes the callback
+    context -   pointer passed back to the callback
+  Remarks:
+    The callback runs from USBDeviceTasks(), in the interrupt context when
+    USB_INTERRUPT is used.
+  **************************************************************************/
+void CDCSetTxCallback(USB_TRANSFER_CALLBACK callback, void *context);
+
 /******************************************************************************
  	Function:
  		void USBCheckCDCRequest(void)
@@ -652,6 +742,95 @@ bool USBCDCEventHandler(USB_EVENT event, void *pdata, uint16_t size);
   **********************************************************************************/
 uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len);
 
+/**********************************************************************************
+  Function:
+        uint16_t CDCGet(uint8_t *buffer, uint16_t len)
+    
+  Summary:
+    CDCGet copies the data received through the USB CDC Bulk OUT endpoint to
+    a user's specified location, several packets at a time. It is a
+    non-blocking function.
+
+  Description:
+    CDCGet works like getsUSBUSART() with a 16-bit length.  Once the first
+    packet is copied, the following packets already received (the other
+    ping-pong buffer) are appended as long as they fit whole in 'buffer',
+    so a buffer of several CDC_DATA_OUT_EP_SIZE bytes is filled in one
+    call.  getsUSBUSART() is a wrapper of CDCGet().
+    
+    Typical Usage:
+    <code>
+        uint16_t numBytes;
+        uint8_t buffer[2 * CDC_DATA_OUT_EP_SIZE];
+    
+        numBytes = CDCGet(buffer, sizeof(buffer));
+        if(numBytes \> 0)
+        {
+            //we received numBytes bytes of data in buffer[]
+        }
+    </code>
+  Conditions:
+    As with getsUSBUSART(), the bytes of the first packet that do not fit
+    in 'len' are dropped.
+  Input:
+    buffer -  Pointer to where received BYTEs are to be stored
+    len -     The number of BYTEs expected.
+  Return:
+    uint16_t - the number of bytes copied into 'buffer', 0 if no new data
+    was available.
+  
+  **********************************************************************************/
+uint16_t CDCGet(uint8_t *buffer, uint16_t len);
+
+/**********************************************************************************
+  Function:
+        uint8_t CDCPeek(uint8_t **data)
+    
+  Summary:
+    CDCPeek gives access to the data received through the USB CDC Bulk OUT
+    endpoint without copying it. It is a non-blocking function.
+
+  Description:
+    CDCPeek points 'data' at the bytes of the last packet received through the
+    USB CDC Bulk OUT endpoint that have not been released with CDCConsume()
+    yet, straight in the endpoint buffer. The buffer is not given back to
+    the endpoint, so once no other buffer is armed (the other ping-pong
+    buffer is full too, or there is none) the host is NAKed until the whole
+    packet has been consumed.
+
+  Conditions:
+    Do not call getsUSBUSART() while the data returned by CDCPeek() is
+    still in use.
+  Input:
+    data -  where to store the address of the first unconsumed byte.
+  Return:
+    uint8_t - Returns the number of bytes available at 'data', 0 if no
+    data has been received.
+  
+  **********************************************************************************/
+uint8_t CDCPeek(uint8_t **data);
+
+/**********************************************************************************
+  Function:
+        void CDCConsume(uint8_t len)
+    
+  Summary:
+    CDCConsume releases bytes returned by CDCPeek().
+
+  Description:
+    CDCConsume releases the first 'len' bytes returned by CDCPeek(). Once all
+    of the bytes of the packet are released, the USB CDC Bulk OUT endpoint is
+    re-armed for the next packet.
+    
+  Conditions:
+    'len' must not be larger than the value returned by the last CDCPeek()
+    call.
+  Input:
+    len -  the number of bytes to release.
+  
+  **********************************************************************************/
+void CDCConsume(uint8_t len);
+
 /******************************************************************************
   Function:
 	void putUSBUSART(char *data, uint8_t length)
@@ -681,11 +860,15 @@ uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len);
     \long string of data over multiple USB transactions. CDCTxService()
     must be called periodically to keep sending blocks of data to the host.
 
+    Each packet is copied into the CDC IN buffers, so 'data' can be
+    anywhere in RAM.  Data already in USB RAM is sent without the copy by
+    CDCSendDirect().
+
   Conditions:
     USBUSARTIsTxTrfReady() must return true. This indicates that the last
     transfer is complete and is ready to receive a new block of data. The
     string of characters pointed to by 'data' must equal to or smaller than
-    255 BYTEs.
+    255 BYTEs, CDCPut() sends longer ones.
 
   Input:
     char *data - pointer to a RAM array of data to be transfered to the host
@@ -694,6 +877,41 @@ uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len);
  *****************************************************************************/
 void putUSBUSART(uint8_t *data, uint8_t Length);
 
+/******************************************************************************
+  Function:
+    bool CDCPut(uint8_t *data, uint16_t length)
+		
+  Summary:
+    CDCPut writes an array of data of up to 65535 bytes to the USB.
+
+  Description:
+    CDCPut works like putUSBUSART() with a 16-bit length, so a whole SysEx
+    dump or patch bank is sent with a single call.  CDCTxService() splits it
+    in CDC_DATA_IN_EP_SIZE packets and ends the transfer with a zero length
+    packet when the last one is full.  putUSBUSART() is a wrapper of
+    CDCPut().
+    
+    Typical Usage:
+    <code>
+        if(USBUSARTIsTxTrfReady())
+        {
+            CDCPut(dump, sizeof(dump));
+        }
+    </code>
+
+  Conditions:
+    'data' must stay untouched until USBUSARTIsTxTrfReady() returns true
+    again.
+
+  Input:
+    uint8_t *data - pointer to a RAM array of data to be transfered to the host
+    uint16_t length - the number of bytes to be transfered
+		
+  Return:
+    bool - false if the last transfer is not complete, nothing is sent.
+ *****************************************************************************/
+bool CDCPut(uint8_t *data, uint16_t length);
+
 /******************************************************************************
 	Function:
 		void putsUSBUSART(char *data)
@@ -830,6 +1048,95 @@ void putrsUSBUSART(const const char *data);
   ************************************************************************/
 void CDCTxService(void);
 
+/**************************************************************************
+  Function:
+        uint16_t CDCWrite(uint8_t *data, uint16_t length)
+    
+  Summary:
+    Queues data to be sent through the USB CDC Bulk IN endpoint.
+
+  Description:
+    CDCWrite copies as much of 'data' as fits in the transmit ring and
+    returns right away, whether or not the previous data has been sent.
+    CDCTxService() loads it on the endpoint, a packet on each free IN
+    buffer, so unlike putUSBUSART() it can be called at any time and the
+    next packets are ready as soon as the host has read one.
+
+    Typical Usage:
+    <code>
+        sent = CDCWrite(buffer, count);
+        CDCTxService();
+    </code>
+
+  Conditions:
+    CDC_TX_RING_SIZE is defined.  Data passed to putUSBUSART() and the
+    like is sent after the ring data already loaded on the endpoint, and
+    before the rest of it.
+  Input:
+    data -    pointer to the data to send
+    length -  number of bytes to send
+  Return:
+    uint16_t - the number of bytes queued, less than 'length' when the
+    ring is full.
+  **************************************************************************/
+uint16_t CDCWrite(uint8_t *data, uint16_t length);
+
+/**************************************************************************
+  Function:
+        uint16_t CDCWriteFree(void)
+    
+  Summary:
+    Returns the number of bytes CDCWrite() can queue.
+
+  Conditions:
+    CDC_TX_RING_SIZE is defined.
+  Return:
+    uint16_t - free space of the transmit ring, in bytes.
+  **************************************************************************/
+uint16_t CDCWriteFree(void);
+
+/**************************************************************************
+  Function:
+        bool CDCSendDirect(uint8_t *data, uint16_t length)
+    
+  Summary:
+    Sends a buffer of any length through the USB CDC Bulk IN endpoint
+    without copying it.
+
+  Description:
+    CDCSendDirect points the IN buffer descriptors at 'data' itself,
+    instead of copying it into the CDC driver buffers as putUSBUSART()
+    does.  The buffer is sent in CDC_DATA_IN_EP_SIZE packets with
+    USBDeviceTransfer(), which keeps both ping-pong buffer descriptors
+    loaded, and a transfer ending with a full packet is ended with a zero
+    length packet.
+
+    The transfer is over, and the buffer can be written again, once
+    USBUSARTIsTxTrfReady() returns true.  The callback set with
+    CDCSetTxCallback() is called at that time.
+
+    Typical Usage:
+    <code>
+        if(USBUSARTIsTxTrfReady())
+        {
+            CDCSendDirect(usbRamBuffer, 200);
+        }
+    </code>
+
+  Conditions:
+    'data' must be in RAM the USB module can access (USB RAM on PIC18
+    devices) and stay untouched until the transfer is over.  Data in
+    program memory is sent with putrsUSBUSART(), and data anywhere else in
+    RAM with putUSBUSART() or putsUSBUSART(), which copy it.
+  Input:
+    data -    pointer to the data to send
+    length -  number of bytes to send, 0 sends a zero length packet
+  Return:
+    bool - false if the previous transfer, or the data queued with
+    CDCWrite(), has not been sent yet.  Nothing is sent then.
+  **************************************************************************/
+bool CDCSendDirect(uint8_t *data, uint16_t length);
+
 
 /** S T R U C T U R E S ******************************************************/
 
@@ -940,13 +1247,14 @@ typedef struct
 
 //DOM-IGNORE-BEGIN
 /** E X T E R N S ************************************************************/
-extern uint8_t cdc_rx_len;
+extern uint16_t cdc_rx_len;
 extern USB_HANDLE lastTransmission;
 
 extern uint8_t cdc_trf_state;
 extern POINTER pCDCSrc;
-extern uint8_t cdc_tx_len;
+extern uint16_t cdc_tx_len;
 extern uint8_t cdc_mem_type;
+extern USB_HANDLE CDCDataInHandle;
 
 extern CDC_NOTICE cdc_notice;
 extern LINE_CODING line_coding;
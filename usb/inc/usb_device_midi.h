@@ -19,6 +19,11 @@ please contact mla_licensing@microchip.com
 *******************************************************************************/
 //DOM-IGNORE-END
 
+#ifndef USB_DEVICE_MIDI_H
+#define USB_DEVICE_MIDI_H
+
+#include <stdint.h>
+
 typedef union
 {
     uint32_t Val;
@@ -67,3 +72,5 @@ typedef union
 #define MIDI_CIN_CHANNEL_PREASURE               0xD
 #define MIDI_CIN_PITCH_BEND_CHANGE              0xE
 #define MIDI_CIN_SINGLE_BYTE                    0xF
+
+#endif //USB_DEVICE_MIDI_H
@@ -29,7 +29,9 @@ please contact mla_licensing@microchip.com
 // *****************************************************************************
 #include <stdint.h>
 
-#if defined(__18CXX) || defined(__XC8)
+#if defined(USB_SIMULATION)
+    #include "usb_hal_sim.h"
+#elif defined(__18CXX) || defined(__XC8)
     #if defined(_PIC14E)
         #include "usb_hal_pic16f1.h"
     #else
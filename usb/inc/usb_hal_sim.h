@@ -0,0 +1,657 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license),
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+//DOM-IGNORE-END
+
+#ifndef _USB_HAL_SIM_H
+#define _USB_HAL_SIM_H
+
+/* Hardware abstraction layer of the simulation backend.
+ *
+ * Selected by defining USB_SIMULATION, it lets the device stack and the
+ * application run on a Linux host.  The PIC18 USB module (SIE) is modeled in
+ * memory by usb_hal_sim.c: the registers are plain variables, the BDT lives
+ * in ordinary RAM and holds native pointers, and the SIE side of the
+ * ping-pong pointers and the 4 entry USTAT FIFO are tracked the way the
+ * hardware does.  A simulated host drives the bus through the USBSim token
+ * functions declared at the end of this file.
+ */
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "usb_config.h"
+
+#ifdef __cplusplus  // Provide C++ Compatability
+    extern "C" {
+#endif
+
+#if (USB_PING_PONG_MODE != USB_PING_PONG__FULL_PING_PONG) && (USB_PING_PONG_MODE != USB_PING_PONG__NO_PING_PONG)
+    #error "The simulation backend only models USB_PING_PONG__FULL_PING_PONG and USB_PING_PONG__NO_PING_PONG."
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+#define USB_HAL_VBUSTristate()                  //No VBUS pin to configure
+
+/* Endpoint control register (UEPn) bits, as on PIC18 */
+#define USB_HANDSHAKE_ENABLED   0x10
+#define USB_HANDSHAKE_DISABLED  0x00
+
+#define USB_OUT_ENABLED         0x04
+#define USB_OUT_DISABLED        0x00
+
+#define USB_IN_ENABLED          0x02
+#define USB_IN_DISABLED         0x00
+
+#define USB_ALLOW_SETUP         0x00
+#define USB_DISALLOW_SETUP      0x08
+
+#define USB_STALL_ENDPOINT      0x01
+
+/* Configuration register (UCFG) bits */
+#define USB_PULLUP_ENABLE 0x10
+#define USB_PULLUP_DISABLED 0x00
+
+#define USB_INTERNAL_TRANSCEIVER 0x00
+#define USB_EXTERNAL_TRANSCEIVER 0x08
+
+#define USB_FULL_SPEED 0x04
+#define USB_LOW_SPEED  0x00
+
+/* Interrupt flags, with the layout of the PIC18 UIR/UIE registers */
+#define USBTransactionCompleteIE usbSimUIE.TRNIF
+#define USBTransactionCompleteIF usbSimUIR.TRNIF
+#define USBTransactionCompleteIFReg U1IR
+#define USBTransactionCompleteIFBitNum 0xF7
+
+#define USBResetIE  usbSimUIE.URSTIF
+#define USBResetIF  usbSimUIR.URSTIF
+#define USBResetIFReg U1IR
+#define USBResetIFBitNum 0xFE
+
+#define USBIdleIE usbSimUIE.IDLEIF
+#define USBIdleIF usbSimUIR.IDLEIF
+#define USBIdleIFReg U1IR
+#define USBIdleIFBitNum 0xEF
+
+#define USBActivityIE usbSimUIE.ACTVIF
+#define USBActivityIF usbSimUIR.ACTVIF
+#define USBActivityIFReg U1IR
+#define USBActivityIFBitNum 0xFB
+
+#define USBSOFIE usbSimUIE.SOFIF
+#define USBSOFIF usbSimUIR.SOFIF
+#define USBSOFIFReg U1IR
+#define USBSOFIFBitNum 0xBF
+
+#define USBStallIE usbSimUIE.STALLIF
+#define USBStallIF usbSimUIR.STALLIF
+#define USBStallIFReg U1IR
+#define USBStallIFBitNum 0xDF
+
+#define USBErrorIE usbSimUIE.UERRIF
+#define USBErrorIF usbSimUIR.UERRIF
+#define USBErrorIFReg U1IR
+#define USBErrorIFBitNum 0xFD
+
+#if defined(USB_DISABLE_SOF_HANDLER)
+    #define USB_SOF_INTERRUPT 0x00
+#else
+    #define USB_SOF_INTERRUPT 0x40
+#endif
+
+#define USB_ERROR_INTERRUPT 0x02
+
+/* Control register (UCON) bits.  Writing the ping-pong reset bit, whatever
+ * the value, resets the SIE ping-pong pointers right away. */
+#define USBPingPongBufferReset (*USBSimPingPongBufferReset())
+#define USBSE0Event usbSimUCON.SE0
+#define USBSuspendControl usbSimUCON.SUSPND
+#define USBPacketDisable usbSimUCON.PKTDIS
+#define USBResumeControl usbSimUCON.RESUME
+
+/* Buffer Descriptor Status Register Initialization Parameters */
+#define _BSTALL     0x04        //Buffer Stall enable
+#define _DTSEN      0x08        //Data Toggle Synch enable
+#define _INCDIS     0x10        //Address increment disable
+#define _KEN        0x20        //SIE keeps buff descriptors enable
+#define _DAT0       0x00        //DATA0 packet expected next
+#define _DAT1       0x40        //DATA1 packet expected next
+#define _DTSMASK    0x40        //DTS Mask
+#define _USIE       0x80        //SIE owns buffer
+#define _UCPU       0x00        //CPU owns buffer
+
+#define _STAT_MASK  0xFF
+
+#define USTAT_EP0_PP_MASK   ~0x02
+#define USTAT_EP_MASK       0x7E
+#define USTAT_EP0_OUT       0x00
+#define USTAT_EP0_OUT_EVEN  0x00
+#define USTAT_EP0_OUT_ODD   0x02
+#define USTAT_EP0_IN        0x04
+#define USTAT_EP0_IN_EVEN   0x04
+#define USTAT_EP0_IN_ODD    0x06
+
+#define ENDPOINT_MASK 0b01111000
+
+#define UEP_STALL 0x0001
+
+/* Endpoint configuration options for USBEnableEndpoint() function */
+#define EP_CTRL     0x06            // Cfg Control pipe for this ep
+#define EP_OUT      0x0C            // Cfg OUT only pipe for this ep
+#define EP_IN       0x0A            // Cfg IN only pipe for this ep
+#define EP_OUT_IN   0x0E            // Cfg both OUT & IN pipes for this ep
+
+/* Register names used by the device stack */
+#define U1ADDR usbSimUADDR
+#define U1IE usbSimUIE.Val
+#define U1IR usbSimUIR.Val
+#define U1EIR usbSimUEIR
+#define U1EIE usbSimUEIE
+#define U1CON usbSimUCON.Val
+#define U1EP0 usbSimUEP[0].Val
+#define U1CONbits usbSimUCON
+#define U1EP1 usbSimUEP[1].Val
+#define U1CNFG1 usbSimUCFG
+#define U1STAT usbSimUSTAT
+#define U1EP0bits usbSimUEP[0]
+
+/* Each BDT entry takes 16 bytes to hold a native pointer, so the stack
+ * toggles between the EVEN and ODD entries by flipping bit 4 of their
+ * address. */
+#define USB_BDT_ENTRY_SIZE  16
+
+#if (USB_PING_PONG_MODE == USB_PING_PONG__NO_PING_PONG)
+    #define BDT_NUM_ENTRIES      ((USB_MAX_EP_NUMBER + 1) * 2)
+#elif (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG)
+    #define BDT_NUM_ENTRIES      ((USB_MAX_EP_NUMBER + 1) * 4)
+#endif
+
+#define BDT_BASE_ADDR_TAG   __attribute__ ((aligned (512)))
+#define CTRL_TRF_SETUP_ADDR_TAG
+#define CTRL_TRF_DATA_ADDR_TAG
+#define MSD_CBW_ADDR_TAG
+#define MSD_CSW_ADDR_TAG
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef union _BD_STAT
+{
+    uint8_t Val;
+    struct{
+        uint8_t BC8:1;          //bit 8 of the byte count
+        uint8_t BC9:1;          //bit 9 of the byte count
+        uint8_t BSTALL:1;       //Buffer Stall Enable
+        uint8_t DTSEN:1;        //Data Toggle Synch Enable
+        uint8_t INCDIS:1;       //Address Increment Disable
+        uint8_t KEN:1;          //BD Keep Enable
+        uint8_t DTS:1;          //Data Toggle Synch Value
+        uint8_t UOWN:1;         //USB Ownership
+    };
+    struct{
+        uint8_t :2;
+        uint8_t PID:4;          //Packet Identifier
+        uint8_t :2;
+    };
+} BD_STAT;                      //Buffer Descriptor Status Register
+
+// BDT Entry Layout.  The status and count keep the PIC18 layout in the low
+// word, the buffer address is a native pointer.
+typedef union __BDT
+{
+    struct
+    {
+        BD_STAT STAT;
+        uint8_t CNT;
+        uint8_t reserved[6];
+        uintptr_t ADR;                      //Buffer Address
+    };
+    uint32_t Val;
+    uint8_t v[USB_BDT_ENTRY_SIZE];
+} BDT_ENTRY;
+
+// USTAT Register Layout
+typedef union __USTAT
+{
+    struct
+    {
+        unsigned char filler1:1;
+        unsigned char ping_pong:1;
+        unsigned char direction:1;
+        unsigned char endpoint_number:4;
+    };
+    uint8_t Val;
+} USTAT_FIELDS;
+
+//Macros for fetching parameters from a USTAT_FIELDS variable.
+#define USBHALGetLastEndpoint(stat)     stat.endpoint_number
+#define USBHALGetLastDirection(stat)    stat.direction
+#define USBHALGetLastPingPong(stat)     stat.ping_pong
+
+typedef union _POINTER
+{
+    struct
+    {
+        uint8_t bLow;
+        uint8_t bHigh;
+    };
+    uint16_t _word;                         // bLow & bHigh
+    uint8_t* bRam;                          // Ram byte pointer
+    uint16_t* wRam;                         // Ram word pointer
+    const uint8_t* bRom;                    // Const byte pointer
+    const uint16_t* wRom;
+} POINTER;
+
+/* Interrupt flag and enable registers (UIR/UIE) */
+typedef union
+{
+    uint8_t Val;
+    struct
+    {
+        uint8_t URSTIF:1;
+        uint8_t UERRIF:1;
+        uint8_t ACTVIF:1;
+        uint8_t TRNIF:1;
+        uint8_t IDLEIF:1;
+        uint8_t STALLIF:1;
+        uint8_t SOFIF:1;
+        uint8_t :1;
+    };
+} USB_SIM_UIR;
+
+/* Control register (UCON) */
+typedef union
+{
+    uint8_t Val;
+    struct
+    {
+        uint8_t :1;
+        uint8_t SUSPND:1;
+        uint8_t RESUME:1;
+        uint8_t USBEN:1;
+        uint8_t PKTDIS:1;
+        uint8_t SE0:1;
+        uint8_t PPBRST:1;
+        uint8_t :1;
+    };
+} USB_SIM_UCON;
+
+/* Endpoint control registers (UEPn) */
+typedef union
+{
+    uint8_t Val;
+    struct
+    {
+        uint8_t EPSTALL:1;
+        uint8_t EPINEN:1;
+        uint8_t EPOUTEN:1;
+        uint8_t EPCONDIS:1;
+        uint8_t EPHSHK:1;
+        uint8_t :3;
+    };
+} USB_SIM_UEP;
+
+/* Handshake seen by the simulated host at the end of a transaction */
+typedef enum
+{
+    USB_SIM_ACK,
+    USB_SIM_NAK,
+    USB_SIM_STALL,
+    USB_SIM_TIMEOUT         //the device did not answer
+} USB_SIM_HANDSHAKE;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Simulated Registers
+// *****************************************************************************
+// *****************************************************************************
+extern volatile USB_SIM_UIR usbSimUIR;
+extern volatile USB_SIM_UIR usbSimUIE;
+extern volatile USB_SIM_UCON usbSimUCON;
+extern volatile USB_SIM_UEP usbSimUEP[16];
+extern volatile uint8_t usbSimUEIR;
+extern volatile uint8_t usbSimUEIE;
+extern volatile uint8_t usbSimUADDR;
+extern volatile uint8_t usbSimUCFG;
+extern volatile uint8_t usbSimUSTAT;
+extern volatile bool usbSimInterruptEnable;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+#define ConvertToPhysicalAddress(a) ((uintptr_t)(a))
+#define ConvertToVirtualAddress(a)  ((void *)(a))
+
+#define USBClearUSBInterrupt()
+#define USBInterruptFlag ((usbSimUIR.Val & usbSimUIE.Val) != 0)
+
+#if defined(USB_INTERRUPT)
+    #define USBMaskInterrupts() {usbSimInterruptEnable = false;}
+    #define USBUnmaskInterrupts() {usbSimInterruptEnable = true;}
+    #define USBEnableInterrupts() {usbSimInterruptEnable = true;}
+#else
+    #define USBMaskInterrupts()
+    #define USBUnmaskInterrupts()
+    #define USBEnableInterrupts()
+#endif
+
+#define USBDisableInterrupts() {usbSimInterruptEnable = false;}
+
+#define SetConfigurationOptions()   {\
+                                        U1CNFG1 = USB_PULLUP_OPTION | USB_TRANSCEIVER_OPTION | USB_SPEED_OPTION | USB_PING_PONG_MODE;\
+                                        U1EIE = 0x9F;\
+                                        U1IE = 0x39 | USB_SOF_INTERRUPT | USB_ERROR_INTERRUPT;\
+                                    }
+
+#define USBPowerModule()
+
+#define USBModuleDisable() {\
+    U1CON = 0;\
+    U1IE = 0;\
+    USBDeviceState = DETACHED_STATE;\
+}
+
+#define USBSetBDTAddress(addr)
+
+/* Clearing TRNIF advances the USTAT FIFO, so the flags are cleared by the
+ * SIE model */
+#define USBClearInterruptFlag(reg_name, if_and_flag_mask)   USBSimClearInterruptFlag(&(reg_name), (if_and_flag_mask))
+
+#define USBClearInterruptRegister(reg) USBSimClearInterruptFlag(&(reg), 0x00)
+
+#define DisableNonZeroEndpoints(last_ep_num) memset((void*)&U1EP1,0x00,(last_ep_num));
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: External Variables
+// *****************************************************************************
+// *****************************************************************************
+#if !defined(USBDEVICE_C)
+    extern USB_VOLATILE uint8_t USBActiveConfiguration;
+    extern USB_VOLATILE IN_PIPE inPipes[1];
+    extern USB_VOLATILE OUT_PIPE outPipes[1];
+#endif
+
+extern volatile BDT_ENTRY* pBDTEntryOut[USB_MAX_EP_NUMBER+1];
+extern volatile BDT_ENTRY* pBDTEntryIn[USB_MAX_EP_NUMBER+1];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Simulation Interface
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************
+    Function:
+        void USBSimClearInterruptFlag(volatile uint8_t *reg, uint8_t mask)
+
+    Summary:
+        Clears interrupt flags of the SIE model.
+
+    Description:
+        ANDs the register with the mask.  When the transaction complete
+        flag is cleared, the next USTAT FIFO entry (if any) is loaded in
+        U1STAT and the flag is set again, as the SIE does.
+
+    Parameters:
+        reg - the flag register
+        mask - AND mask, 0 clears every flag
+
+    Return Values:
+        None
+
+    Remarks:
+        None
+  ****************************************************************/
+void USBSimClearInterruptFlag(volatile uint8_t *reg, uint8_t mask);
+
+/****************************************************************
+    Function:
+        volatile uint8_t* USBSimPingPongBufferReset(void)
+
+    Summary:
+        Resets the SIE ping-pong pointers to the EVEN buffers.
+
+    Description:
+        Backs the USBPingPongBufferReset macro.  Every access resets the
+        pointers and returns the UCON.PPBRST storage.
+
+    Parameters:
+        None
+
+    Return Values:
+        pointer to the PPBRST flag
+
+    Remarks:
+        None
+  ****************************************************************/
+volatile uint8_t* USBSimPingPongBufferReset(void);
+
+/****************************************************************
+    Function:
+        bool USBSimIsAttached(void)
+
+    Summary:
+        Checks if the device drives the bus.
+
+    Description:
+        The device is attached once the module is enabled with its pull-up
+        resistor.
+
+    Parameters:
+        None
+
+    Return Values:
+        true if the device is attached
+
+    Remarks:
+        None
+  ****************************************************************/
+bool USBSimIsAttached(void);
+
+/****************************************************************
+    Function:
+        void USBSimBusReset(void)
+
+    Summary:
+        Sends a bus reset to the device.
+
+    Description:
+        Sets the reset interrupt flag (and the activity flag while the module
+        is suspended) and runs the USB interrupt.
+
+    Parameters:
+        None
+
+    Return Values:
+        None
+
+    Remarks:
+        None
+  ****************************************************************/
+void USBSimBusReset(void);
+
+/****************************************************************
+    Function:
+        void USBSimBusIdle(void)
+
+    Summary:
+        Leaves the bus idle for more than 3 ms.
+
+    Description:
+        Sets the idle interrupt flag and runs the USB interrupt.
+
+    Parameters:
+        None
+
+    Return Values:
+        None
+
+    Remarks:
+        None
+  ****************************************************************/
+void USBSimBusIdle(void);
+
+/****************************************************************
+    Function:
+        void USBSimStartOfFrame(void)
+
+    Summary:
+        Sends a start of frame packet to the device.
+
+    Description:
+        Sets the SOF interrupt flag (and the activity flag while the module
+        is suspended) and runs the USB interrupt.
+
+    Parameters:
+        None
+
+    Return Values:
+        None
+
+    Remarks:
+        None
+  ****************************************************************/
+void USBSimStartOfFrame(void);
+
+/****************************************************************
+    Function:
+        USB_SIM_HANDSHAKE USBSimSetup(uint8_t address, uint8_t ep,
+                                      const uint8_t *packet)
+
+    Summary:
+        Runs a SETUP transaction.
+
+    Description:
+        Writes the 8 byte setup packet to the EP0 OUT buffer owned by the
+        SIE, whatever its stall bit, and disables packet processing until
+        the stack re-enables it.
+
+    Parameters:
+        address - device address of the token
+        ep - endpoint number
+        packet - the 8 byte setup packet (DATA0)
+
+    Return Values:
+        USB_SIM_ACK, or USB_SIM_TIMEOUT if the device could not take it
+
+    Remarks:
+        None
+  ****************************************************************/
+USB_SIM_HANDSHAKE USBSimSetup(uint8_t address, uint8_t ep, const uint8_t *packet);
+
+/****************************************************************
+    Function:
+        USB_SIM_HANDSHAKE USBSimOut(uint8_t address, uint8_t ep,
+                                    uint8_t dataToggle, const uint8_t *data,
+                                    uint8_t length)
+
+    Summary:
+        Runs an OUT transaction.
+
+    Description:
+        Writes the data packet to the current OUT buffer of the endpoint.
+        With data toggle synchronization enabled in the buffer descriptor,
+        a packet with the wrong toggle is acknowledged but dropped.
+
+    Parameters:
+        address - device address of the token
+        ep - endpoint number
+        dataToggle - 0 for DATA0, 1 for DATA1
+        data - the packet
+        length - size of the packet
+
+    Return Values:
+        handshake returned by the device
+
+    Remarks:
+        None
+  ****************************************************************/
+USB_SIM_HANDSHAKE USBSimOut(uint8_t address, uint8_t ep, uint8_t dataToggle, const uint8_t *data, uint8_t length);
+
+/****************************************************************
+    Function:
+        USB_SIM_HANDSHAKE USBSimIn(uint8_t address, uint8_t ep,
+                                   uint8_t *dataToggle, uint8_t *data,
+                                   uint8_t *length)
+
+    Summary:
+        Runs an IN transaction.
+
+    Description:
+        Reads the data packet of the current IN buffer of the endpoint.
+
+    Parameters:
+        address - device address of the token
+        ep - endpoint number
+        dataToggle - receives the toggle of the packet
+        data - receives the packet, at least 64 bytes long
+        length - receives the size of the packet
+
+    Return Values:
+        handshake returned by the device
+
+    Remarks:
+        None
+  ****************************************************************/
+USB_SIM_HANDSHAKE USBSimIn(uint8_t address, uint8_t ep, uint8_t *dataToggle, uint8_t *data, uint8_t *length);
+
+/****************************************************************
+    Function:
+        void USBSimInterrupt(void)
+
+    Summary:
+        Runs the USB interrupt if it is pending.
+
+    Description:
+        With USB_INTERRUPT, calls USBDeviceTasks() while an enabled flag is
+        set and interrupts are not masked.  Does nothing with USB_POLLING.
+
+    Parameters:
+        None
+
+    Return Values:
+        None
+
+    Remarks:
+        Interrupts are only taken where the simulated host runs, never in
+        the middle of the main loop code.
+  ****************************************************************/
+void USBSimInterrupt(void);
+
+#ifdef __cplusplus  // Provide C++ Compatibility
+    }
+#endif
+
+#endif //#ifndef _USB_HAL_SIM_H
@@ -0,0 +1,102 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license),
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+//DOM-IGNORE-END
+
+/* Block copies used by the device stack to move data in and out of the
+ * endpoint buffers.  On PIC18 devices they are loops on the FSR and table
+ * read registers, elsewhere they are the memcpy() of the C library.  The
+ * copy benchmark of copy_bench.h reports the cycles per byte of both
+ * against the byte loops they replaced.
+ *
+ * The PIC18 loops need the compiled stack model of the project: the
+ * hybrid and reentrant models keep the software stack pointer in FSR1,
+ * which an interrupt taken during a copy would then use.
+ */
+
+//DOM-IGNORE-BEGIN
+#ifndef _USB_MEMCPY_H_
+#define _USB_MEMCPY_H_
+//DOM-IGNORE-END
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__XC8) && !defined(_PIC14E) && !defined(USB_SIMULATION)
+    #define USB_MEMCPY_PIC18
+#endif
+
+#if defined(USB_MEMCPY_PIC18)
+
+/*******************************************************************************
+  Function:
+        void usb_memcpy(void *dst, const void *src, uint16_t length)
+
+  Summary:
+    Copies a block of data memory.
+  Description:
+    Copies length bytes from src to dst, both in data memory, with a
+    MOVFF POSTINC0, POSTINC1 loop.  The blocks must not overlap.
+  Conditions:
+    None
+  Input:
+    void *dst -         where to copy the data
+    const void *src -   data to copy, in RAM
+    uint16_t length -   number of bytes to copy
+  Return:
+    None
+  Remarks:
+    FSR0 and FSR1 are given back their value on return, so it can be
+    called both from the main loop and from the interrupt.
+  *****************************************************************************/
+void usb_memcpy(void *dst, const void *src, uint16_t length);
+
+/*******************************************************************************
+  Function:
+        void usb_memcpy_rom(void *dst, const uint8_t *src, uint16_t length)
+
+  Summary:
+    Copies a block of program memory to data memory.
+  Description:
+    Copies length bytes from src, in program memory, to dst with a
+    TBLRD*+ loop.
+  Conditions:
+    None
+  Input:
+    void *dst -             where to copy the data
+    const uint8_t *src -    data to copy, in program memory
+    uint16_t length -       number of bytes to copy
+  Return:
+    None
+  Remarks:
+    TBLPTR and FSR1 are given back their value on return, as with
+    usb_memcpy().
+  *****************************************************************************/
+void usb_memcpy_rom(void *dst, const uint8_t *src, uint16_t length);
+
+#else
+
+//Data and program memory share the same address space, the copy of the C
+//library moves whole words at a time
+#define usb_memcpy(dst,src,length)      memcpy((dst),(src),(length))
+#define usb_memcpy_rom(dst,src,length)  memcpy((dst),(src),(length))
+
+#endif
+
+#endif //_USB_MEMCPY_H_
@@ -55,6 +55,8 @@ please contact mla_licensing@microchip.com
 #include "usb_device.h"
 #include "usb_device_local.h"
 
+#include "cycle_counter.h"
+
 #ifndef uintptr_t
     #if  defined(__XC8__) || defined(__XC16__)
         #define uintptr_t uint16_t
@@ -98,6 +100,14 @@ please contact mla_licensing@microchip.com
     #define USB_MAX_NUM_CONFIG_DSC      1
 #endif
 
+//Packets a USBDeviceTransfer() keeps on the bus.  OUT transfers only arm one
+//packet at a time, the end of the transfer is known from the previous one.
+#if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG) || (USB_PING_PONG_MODE == USB_PING_PONG__ALL_BUT_EP0)
+    #define USB_TRANSFER_MAX_PENDING(direction)     (((direction) == IN_TO_HOST) ? 2u : 1u)
+#else
+    #define USB_TRANSFER_MAX_PENDING(direction)     1u
+#endif
+
 #if defined(__XC8)
     //Suppress expected/harmless compiler warning message about unused RAM variables
     //and certain function pointer usage.
@@ -133,6 +143,24 @@ typedef union
     } bits;
 } uint8_t_VAL, uint8_t_BITS;
 
+typedef struct
+{
+    USB_TRANSFER_CALLBACK callback;
+    void *context;
+} USB_TRANSFER_CALLBACK_ENTRY;
+
+typedef struct
+{
+    uint8_t *data;              //next byte to send or receive into
+    uint16_t remaining;         //bytes not loaded in a packet yet
+    uint16_t length;            //bytes moved by the completed packets
+    USB_HANDLE packets[2];      //packets on the bus, oldest at packets[head]
+    uint8_t head;
+    uint8_t pending;            //number of packets on the bus
+    uint8_t maxPacketSize;
+    uint8_t options;            //USB_TRANSFER_ZLP while a ZLP may still be needed
+} USB_TRANSFER_STATE;
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Variables
@@ -165,6 +193,8 @@ volatile bool USBDeferINDataStagePackets;
 volatile bool USBDeferOUTDataStagePackets;
 USB_VOLATILE uint32_t USB1msTickCount;
 USB_VOLATILE uint8_t USBTicksSinceSuspendEnd;
+static USB_TRANSFER_CALLBACK_ENTRY USBTransferCallbacks[USB_MAX_EP_NUMBER+1][2];    //indexed by endpoint and direction
+static USB_TRANSFER_STATE USBTransfers[USB_MAX_EP_NUMBER+1][2];                     //indexed by endpoint and direction
 
 /** USB FIXED LOCATION VARIABLES ***********************************/
 #if defined(COMPILER_MPLAB_C18)
@@ -244,6 +274,8 @@ static void USBConfigureEndpoint(uint8_t EPNum, uint8_t direction);
 static void USBWakeFromSuspend(void);
 static void USBSuspend(void);
 static void USBStallHandler(void);
+static void USBTransferLoad(uint8_t ep, uint8_t direction);
+static bool USBTransferService(uint8_t ep, uint8_t direction);
 
 // *****************************************************************************
 // *****************************************************************************
@@ -350,6 +382,10 @@ void USBDeviceInit(void)
         ep_data_out[i].Val = 0u;
     }
 
+    //Forget the transfer complete callbacks and transfers of the previous configuration
+    memset((void*)USBTransferCallbacks, 0x00, sizeof(USBTransferCallbacks));
+    memset((void*)USBTransfers, 0x00, sizeof(USBTransfers));
+
     //Get ready for the first packet
     pBDTEntryIn[0] = (volatile BDT_ENTRY*)&BDT[EP0_IN_EVEN];
     // Initialize EP0 as a Ctrl EP
@@ -714,7 +750,7 @@ void USBDeviceTasks(void)
         }    
         USBClearInterruptFlag(USBSOFIFReg,USBSOFIFBitNum);
 
-        #if defined(__XC8__) || defined(__C18__)
+        #if defined(__XC8__) || defined(__C18__) || defined(USB_SIMULATION)
             USBIncrement1msInternalTimers();
         #endif
 
@@ -782,6 +818,7 @@ void USBDeviceTasks(void)
      */
     if(USBTransactionCompleteIE)
     {
+        CYCLE_COUNTER_Enter(CYCLE_COUNTER_USB_TRANSACTIONS);
         for(i = 0; i < 4u; i++)	//Drain or deplete the USAT FIFO entries.  If the USB FIFO ever gets full, USB bandwidth
         {						//utilization can be compromised, and the device won't be able to receive SETUP packets.
             if(USBTransactionCompleteIF)
@@ -809,11 +846,28 @@ void USBDeviceTasks(void)
                 //It ignores all other EP transactions.
                 if(endpoint_number == 0)
                 {
+                    CYCLE_COUNTER_Enter(CYCLE_COUNTER_USB_CTRL_EP);
                     USBCtrlEPService();
+                    CYCLE_COUNTER_Exit(CYCLE_COUNTER_USB_CTRL_EP);
                 }
                 else
                 {
-                    USB_TRANSFER_COMPLETE_HANDLER(EVENT_TRANSFER, (uint8_t*)&USTATcopy.Val, 0);
+                    uint8_t direction = USBHALGetLastDirection(USTATcopy);
+                    USB_TRANSFER_CALLBACK_ENTRY *entry = &USBTransferCallbacks[endpoint_number][direction];
+
+                    //The packets of a USBDeviceTransfer() are loaded here,
+                    //only the end of the transfer is reported
+                    if((USBTransfers[endpoint_number][direction].pending == 0) || USBTransferService(endpoint_number, direction))
+                    {
+                        if(entry->callback != NULL)
+                        {
+                            entry->callback(entry->context);
+                        }
+                        else
+                        {
+                            USB_TRANSFER_COMPLETE_HANDLER(EVENT_TRANSFER, (uint8_t*)&USTATcopy.Val, 0);
+                        }
+                    }
                 }
             }//end if(USBTransactionCompleteIF)
             else
@@ -821,6 +875,7 @@ void USBDeviceTasks(void)
                 break;	//USTAT FIFO must be empty.
             }
         }//end for()
+        CYCLE_COUNTER_Exit(CYCLE_COUNTER_USB_TRANSACTIONS);
     }//end if(USBTransactionCompleteIE)
 
     USBClearUSBInterrupt();
@@ -902,6 +957,182 @@ void USBEnableEndpoint(uint8_t ep, uint8_t options)
 }
 
 
+/*******************************************************************************
+  Function:
+        void USBDeviceSetTransferCallback(uint8_t ep, uint8_t direction,
+                        USB_TRANSFER_CALLBACK callback, void *context)
+    
+  Summary:
+    Registers the function called when a transaction completes on the
+    specified endpoint and direction.
+  Description:
+    Registers the function called when a transaction completes on the
+    specified endpoint and direction.  USBDeviceTasks() calls it directly
+    after reading USTAT instead of raising EVENT_TRANSFER.
+  Conditions:
+    None
+  Input:
+    uint8_t ep -                    the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction -             OUT_FROM_HOST or IN_TO_HOST
+    USB_TRANSFER_CALLBACK callback - function to call, NULL removes the
+                                    callback
+    void *context -                 pointer passed back to the callback
+  Return:
+    None
+  Remarks:
+    The table entry is not updated atomically, callbacks should be registered
+    from the EVENT_CONFIGURED handler or with the USB interrupt masked.
+  *****************************************************************************/
+void USBDeviceSetTransferCallback(uint8_t ep, uint8_t direction, USB_TRANSFER_CALLBACK callback, void *context)
+{
+    if((ep == 0u) || (ep > USB_MAX_EP_NUMBER))
+    {
+        return;
+    }
+
+    USBTransferCallbacks[ep][direction & 0x01].context = context;
+    USBTransferCallbacks[ep][direction & 0x01].callback = callback;
+}
+
+
+/*******************************************************************************
+  Function:
+        bool USBDeviceTransfer(uint8_t ep, uint8_t direction, uint8_t *data,
+                        uint16_t length, uint8_t maxPacketSize, uint8_t options)
+    
+  Summary:
+    Moves a buffer of any length over a non-EP0 endpoint, one packet after
+    the other, without the caller handling each packet.
+  Description:
+    Moves a buffer of any length over a non-EP0 endpoint.  The first packets
+    are loaded here, the next ones by USBTransferService() as the previous
+    ones complete.  The callback registered with
+    USBDeviceSetTransferCallback() is called once, when the whole transfer is
+    done.
+  Conditions:
+    The endpoint has to be enabled with USBEnableEndpoint().
+  Input:
+    uint8_t ep -            the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction -     OUT_FROM_HOST or IN_TO_HOST
+    uint8_t *data -         buffer in USB RAM to send or to receive into
+    uint16_t length -       number of bytes to transfer, 0 transfers a single
+                            zero length packet
+    uint8_t maxPacketSize - wMaxPacketSize of the endpoint
+    uint8_t options -       USB_TRANSFER_ZLP or USB_TRANSFER_NO_OPTIONS
+  Return:
+    bool - false if a transfer is already in progress on the endpoint and
+    direction, or if the endpoint is not valid.
+  Remarks:
+    None
+  *****************************************************************************/
+bool USBDeviceTransfer(uint8_t ep, uint8_t direction, uint8_t *data, uint16_t length, uint8_t maxPacketSize, uint8_t options)
+{
+    USB_TRANSFER_STATE *transfer;
+
+    if((ep == 0u) || (ep > USB_MAX_EP_NUMBER) || (maxPacketSize == 0u))
+    {
+        return false;
+    }
+
+    direction &= 0x01;
+    transfer = &USBTransfers[ep][direction];
+
+    USBMaskInterrupts();
+
+    if(transfer->pending != 0u)
+    {
+        USBUnmaskInterrupts();
+        return false;
+    }
+
+    //Only an IN transfer ending on a full packet needs a ZLP, and an empty
+    //transfer is a single ZLP in both directions
+    if((direction == OUT_FROM_HOST) || ((length % maxPacketSize) != 0u))
+    {
+        options &= ~USB_TRANSFER_ZLP;
+    }
+    if(length == 0u)
+    {
+        options |= USB_TRANSFER_ZLP;
+    }
+
+    transfer->data = data;
+    transfer->remaining = length;
+    transfer->length = 0;
+    transfer->head = 0;
+    transfer->maxPacketSize = maxPacketSize;
+    transfer->options = options;
+
+    USBTransferLoad(ep, direction);
+
+    USBUnmaskInterrupts();
+
+    return true;
+}
+
+
+/*******************************************************************************
+  Function:
+        bool USBDeviceTransferBusy(uint8_t ep, uint8_t direction)
+    
+  Summary:
+    Checks if a transfer started with USBDeviceTransfer() is in progress.
+  Conditions:
+    None
+  Input:
+    uint8_t ep -        the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction - OUT_FROM_HOST or IN_TO_HOST
+  Return:
+    bool - true until the last packet of the transfer has completed.
+  Remarks:
+    None
+  *****************************************************************************/
+bool USBDeviceTransferBusy(uint8_t ep, uint8_t direction)
+{
+    if(ep > USB_MAX_EP_NUMBER)
+    {
+        return false;
+    }
+
+    return (USBTransfers[ep][direction & 0x01].pending != 0u);
+}
+
+
+/*******************************************************************************
+  Function:
+        uint16_t USBDeviceTransferLength(uint8_t ep, uint8_t direction)
+    
+  Summary:
+    Returns the number of bytes moved by the packets of the last transfer
+    started with USBDeviceTransfer() that have completed.
+  Conditions:
+    None
+  Input:
+    uint8_t ep -        the endpoint number, 1 to USB_MAX_EP_NUMBER
+    uint8_t direction - OUT_FROM_HOST or IN_TO_HOST
+  Return:
+    uint16_t - bytes sent or received so far, the length of the transfer
+    once USBDeviceTransferBusy() is false.
+  Remarks:
+    None
+  *****************************************************************************/
+uint16_t USBDeviceTransferLength(uint8_t ep, uint8_t direction)
+{
+    uint16_t length;
+
+    if(ep > USB_MAX_EP_NUMBER)
+    {
+        return 0;
+    }
+
+    USBMaskInterrupts();
+    length = USBTransfers[ep][direction & 0x01].length;
+    USBUnmaskInterrupts();
+
+    return length;
+}
+
+
 /*************************************************************************
   Function:
     USB_HANDLE USBTransferOnePacket(uint8_t ep, uint8_t dir, uint8_t* data, uint8_t len)
@@ -1585,6 +1816,103 @@ static void USBConfigureEndpoint(uint8_t EPNum, uint8_t direction)
 }
 
 
+/********************************************************************
+ * Function:        void USBTransferLoad(uint8_t ep, uint8_t direction)
+ *
+ * PreCondition:    A transfer has been started with USBDeviceTransfer()
+ *
+ * Input:           uint8_t ep - the endpoint of the transfer
+ *                  uint8_t direction - OUT_FROM_HOST or IN_TO_HOST
+ *
+ * Output:          None
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function hands the next packets of a
+ *                  transfer to the SIE, until the buffer descriptors
+ *                  the transfer may use are all owned by the SIE or
+ *                  the whole buffer has been loaded.
+ *
+ * Note:            None
+ *******************************************************************/
+static void USBTransferLoad(uint8_t ep, uint8_t direction)
+{
+    USB_TRANSFER_STATE *transfer = &USBTransfers[ep][direction];
+    uint8_t size;
+
+    while(transfer->pending < USB_TRANSFER_MAX_PENDING(direction))
+    {
+        if(transfer->remaining == 0u)
+        {
+            if((transfer->options & USB_TRANSFER_ZLP) == 0u)
+            {
+                break;
+            }
+
+            //The last packet was full, tell the host the transfer is over
+            transfer->options &= ~USB_TRANSFER_ZLP;
+            size = 0;
+        }
+        else if(transfer->remaining > transfer->maxPacketSize)
+        {
+            size = transfer->maxPacketSize;
+        }
+        else
+        {
+            size = (uint8_t)transfer->remaining;
+        }
+
+        transfer->packets[(transfer->head + transfer->pending) & 0x01] = USBTransferOnePacket(ep, direction, transfer->data, size);
+        transfer->pending++;
+        transfer->data += size;
+        transfer->remaining -= size;
+    }
+}
+
+
+/********************************************************************
+ * Function:        bool USBTransferService(uint8_t ep, uint8_t direction)
+ *
+ * PreCondition:    A packet of a transfer started with
+ *                  USBDeviceTransfer() has just completed
+ *
+ * Input:           uint8_t ep - the endpoint of the transfer
+ *                  uint8_t direction - OUT_FROM_HOST or IN_TO_HOST
+ *
+ * Output:          bool - true if it was the last packet of the
+ *                  transfer
+ *
+ * Side Effects:    None
+ *
+ * Overview:        This function accounts for the oldest packet of
+ *                  the transfer, packets of an endpoint complete in
+ *                  the order they were loaded, and loads the next
+ *                  ones.  A short OUT packet ends the transfer.
+ *
+ * Note:            None
+ *******************************************************************/
+static bool USBTransferService(uint8_t ep, uint8_t direction)
+{
+    USB_TRANSFER_STATE *transfer = &USBTransfers[ep][direction];
+    uint8_t size;
+
+    size = (uint8_t)USBHandleGetLength(transfer->packets[transfer->head]);
+    transfer->head ^= 1;
+    transfer->pending--;
+    transfer->length += size;
+
+    if((direction == OUT_FROM_HOST) && (size < transfer->maxPacketSize))
+    {
+        transfer->remaining = 0;
+        transfer->options &= ~USB_TRANSFER_ZLP;
+    }
+
+    USBTransferLoad(ep, direction);
+
+    return (transfer->pending == 0u);
+}
+
+
 /******************************************************************************
  * Function:        void USBCtrlEPServiceComplete(void)
  *
@@ -1805,22 +2133,15 @@ static void USBCtrlTrfTxService(void)
 
     //Now copy the data from the source location, to the CtrlTrfData[] buffer,
     //which we will send to the host.
-    pDst = (USB_VOLATILE uint8_t*)CtrlTrfData;                // Set destination pointer
     if(inPipes[0].info.bits.ctrl_trf_mem == USB_EP0_ROM)   // Determine type of memory source
     {
-        while(byteToSend)
-        {
-            *pDst++ = *inPipes[0].pSrc.bRom++;
-            byteToSend--;
-        }//end while(byte_to_send.Val)
+        usb_memcpy_rom((uint8_t*)CtrlTrfData, inPipes[0].pSrc.bRom, byteToSend);
+        inPipes[0].pSrc.bRom += byteToSend;
     }
     else  // RAM
     {
-        while(byteToSend)
-        {
-            *pDst++ = *inPipes[0].pSrc.bRam++;
-            byteToSend--;
-        }//end while(byte_to_send.Val)
+        usb_memcpy((uint8_t*)CtrlTrfData, inPipes[0].pSrc.bRam, byteToSend);
+        inPipes[0].pSrc.bRam += byteToSend;
     }//end if(usb_stat.ctrl_trf_mem == _const)
 }//end USBCtrlTrfTxService
 
@@ -1852,7 +2173,6 @@ static void USBCtrlTrfTxService(void)
 static void USBCtrlTrfRxService(void)
 {
     uint8_t byteToRead;
-    uint8_t i;
 
     //Load byteToRead with the number of bytes the host just sent us in the 
     //last OUT transaction.
@@ -1871,10 +2191,8 @@ static void USBCtrlTrfRxService(void)
 
     //Copy the OUT DATAx packet bytes that we just received from the host,
     //into the user application buffer space.
-    for(i=0;i<byteToRead;i++)
-    {
-        *outPipes[0].pDst.bRam++ = CtrlTrfData[i];
-    }//end while(byteToRead.Val)
+    usb_memcpy(outPipes[0].pDst.bRam, (uint8_t*)CtrlTrfData, byteToRead);
+    outPipes[0].pDst.bRam += byteToRead;
 
     //If there is more data to receive, prepare EP0 OUT so that it can receive 
 	//the next packet in the sequence.
@@ -1993,6 +2311,11 @@ static void USBStdSetCfgHandler(void)
     //clear the alternate interface settings
     memset((void*)&USBAlternateInterface,0x00,USB_MAX_NUM_INT);
 
+    //The class drivers register their callbacks again on EVENT_CONFIGURED,
+    //the transfers in progress were lost with the BDT entries
+    memset((void*)USBTransferCallbacks, 0x00, sizeof(USBTransferCallbacks));
+    memset((void*)USBTransfers, 0x00, sizeof(USBTransfers));
+
     //Stop trying to reset ping pong buffer pointers
     USBPingPongBufferReset = 0;
 
@@ -2270,7 +2593,7 @@ static void USBSuspend(void)
     USBActivityIE = 1;                     // Enable bus activity interrupt
     USBClearInterruptFlag(USBIdleIFReg,USBIdleIFBitNum);
 
-    #if defined(__18CXX) || defined(_PIC14E) || defined(__XC8)
+    #if defined(__18CXX) || defined(_PIC14E) || defined(__XC8) || defined(USB_SIMULATION)
         U1CONbits.SUSPND = 1;                   // Put USB module in power conserve
                                                 // mode, SIE clock inactive
     #endif
@@ -2310,7 +2633,7 @@ static void USBWakeFromSuspend(void)
      */
     USB_WAKEUP_FROM_SUSPEND_HANDLER(EVENT_RESUME,0,0);
 
-    #if defined(__18CXX) || defined(_PIC14E) || defined(__XC8)
+    #if defined(__18CXX) || defined(_PIC14E) || defined(__XC8) || defined(USB_SIMULATION)
         //To avoid improperly clocking the USB module, make sure the oscillator
         //settings are consistent with USB operation before clearing the SUSPND bit.
         //Make sure the correct oscillator settings are selected in the 
@@ -2337,7 +2660,7 @@ static void USBWakeFromSuspend(void)
     ********************************************************************/
 
     // UIRbits.ACTVIF = 0;                      // Removed
-    #if defined(__18CXX) || defined(__XC8)
+    #if defined(__18CXX) || defined(__XC8) || defined(USB_SIMULATION)
     while(USBActivityIF)
     #endif
     {
@@ -2382,7 +2705,7 @@ static void USBCtrlEPService(void)
     if((USTATcopy.Val & USTAT_EP0_PP_MASK) == USTAT_EP0_OUT_EVEN)
     {
 		//Point to the EP0 OUT buffer of the buffer that arrived
-        #if defined (_PIC14E) || defined(__18CXX) || defined(__XC8)
+        #if defined (_PIC14E) || defined(__18CXX) || defined(__XC8) || defined(USB_SIMULATION)
             pBDTEntryEP0OutCurrent = (volatile BDT_ENTRY*)&BDT[(USTATcopy.Val & USTAT_EP_MASK)>>1];
         #elif defined(__C30__) || defined(__C32__) || defined __XC16__
             pBDTEntryEP0OutCurrent = (volatile BDT_ENTRY*)&BDT[(USTATcopy.Val & USTAT_EP_MASK)>>2];
@@ -2856,6 +3179,12 @@ static void USBStdFeatureReqHandler(void)
 		//Check if it was a SET_FEATURE endpoint halt request
         if(SetupPkt.bRequest == USB_REQUEST_SET_FEATURE)
         {
+            //A USBDeviceTransfer() in progress on the endpoint is dropped,
+            //its owner learns it from the EVENT_TRANSFER_TERMINATED event
+            USBTransfers[SetupPkt.EPNum][SetupPkt.EPDir].pending = 0;
+            USBTransfers[SetupPkt.EPNum][SetupPkt.EPDir].remaining = 0;
+            USBTransfers[SetupPkt.EPNum][SetupPkt.EPDir].options = 0;
+
             if(p->STAT.UOWN == 1)
             {
                 //Mark that we are terminating this transfer and that the user
@@ -48,12 +48,29 @@ please contact mla_licensing@microchip.com
 #include "system.h"
 #include "usb.h"
 #include "usb_device_cdc.h"
+#include "cycle_counter.h"
 
 #ifdef USB_USE_CDC
 
+//When the data IN endpoint has an EVEN and an ODD BDT, two IN buffers are
+//used alternately so the next packet can be loaded while the previous one is
+//still waiting for the host.
+#if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG) || (USB_PING_PONG_MODE == USB_PING_PONG__ALL_BUT_EP0)
+    #define CDC_TX_PING_PONG
+#endif
+
+//With ping-pong buffering both OUT BDTs of the data endpoint are kept armed,
+//each with its own buffer, so the host can send the next packet while the
+//previous one is still being read.
+#if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG) || (USB_PING_PONG_MODE == USB_PING_PONG__ALL_BUT_EP0)
+    #define CDC_RX_PING_PONG
+#endif
+
 #ifndef FIXED_ADDRESS_MEMORY
     #define IN_DATA_BUFFER_ADDRESS_TAG
+    #define IN_DATA_ODD_BUFFER_ADDRESS_TAG
     #define OUT_DATA_BUFFER_ADDRESS_TAG
+    #define OUT_DATA_ODD_BUFFER_ADDRESS_TAG
     #define CONTROL_BUFFER_ADDRESS_TAG
 #endif
 
@@ -61,9 +78,27 @@ please contact mla_licensing@microchip.com
     #error "One of the fixed memory address definitions is not defined.  Please define the required address tags for the required buffers."
 #endif
 
+#if defined(CDC_TX_PING_PONG) && !defined(IN_DATA_ODD_BUFFER_ADDRESS_TAG)
+    #error "The ping-pong IN buffer needs IN_DATA_ODD_BUFFER_ADDRESS_TAG to be defined."
+#endif
+
+#if defined(CDC_RX_PING_PONG) && !defined(OUT_DATA_ODD_BUFFER_ADDRESS_TAG)
+    #error "The ping-pong OUT buffer needs OUT_DATA_ODD_BUFFER_ADDRESS_TAG to be defined."
+#endif
+
+#if defined(CDC_TX_RING_SIZE) && (((CDC_TX_RING_SIZE & (CDC_TX_RING_SIZE - 1)) != 0) || (CDC_TX_RING_SIZE > 512))
+    #error "CDC_TX_RING_SIZE must be a power of two, up to 512."
+#endif
+
 /** V A R I A B L E S ********************************************************/
 volatile unsigned char cdc_data_tx[CDC_DATA_IN_EP_SIZE] IN_DATA_BUFFER_ADDRESS_TAG;
+#if defined(CDC_TX_PING_PONG)
+    volatile unsigned char cdc_data_tx_odd[CDC_DATA_IN_EP_SIZE] IN_DATA_ODD_BUFFER_ADDRESS_TAG;
+#endif
 volatile unsigned char cdc_data_rx[CDC_DATA_OUT_EP_SIZE] OUT_DATA_BUFFER_ADDRESS_TAG;
+#if defined(CDC_RX_PING_PONG)
+    volatile unsigned char cdc_data_rx_odd[CDC_DATA_OUT_EP_SIZE] OUT_DATA_ODD_BUFFER_ADDRESS_TAG;
+#endif
 
 typedef union
 {
@@ -80,16 +115,40 @@ CDC_NOTICE cdc_notice;
     SERIAL_STATE_NOTIFICATION SerialStatePacket;
 #endif
 
-uint8_t cdc_rx_len;            // total rx length
+uint16_t cdc_rx_len;           // total rx length
+uint8_t cdc_rx_offset;         // bytes of the OUT buffer being read released with CDCConsume()
 uint8_t cdc_trf_state;         // States are defined cdc.h
 POINTER pCDCSrc;            // Dedicated source pointer
 POINTER pCDCDst;            // Dedicated destination pointer
-uint8_t cdc_tx_len;            // total tx length
+uint16_t cdc_tx_len;           // total tx length
 uint8_t cdc_mem_type;          // _ROM, _RAM
 
 USB_HANDLE CDCDataOutHandle;
 USB_HANDLE CDCDataInHandle;
 
+#if defined(CDC_TX_PING_PONG)
+    static USB_HANDLE CDCDataInHandles[2];  // last packet sent from each IN buffer
+    static uint8_t cdc_tx_buffer;           // IN buffer the next packet goes to
+#endif
+
+#if defined(CDC_TX_RING_SIZE)
+    static uint8_t cdc_tx_ring[CDC_TX_RING_SIZE];   // data queued with CDCWrite()
+    static volatile uint16_t cdc_tx_ring_head;      // bytes written so far, free running
+    static volatile uint16_t cdc_tx_ring_tail;      // bytes loaded on the IN endpoint so far, free running
+    static bool cdc_tx_ring_zlp;                    // last packet loaded from the ring was full
+#endif
+
+#if defined(CDC_RX_PING_PONG)
+    static USB_HANDLE CDCDataOutHandles[2]; // packet armed on each OUT buffer
+    static uint8_t cdc_rx_buffer;           // OUT buffer read next, CDCDataOutHandle is its handle
+    #define CDC_RX_DATA     ((cdc_rx_buffer != 0) ? (uint8_t*)cdc_data_rx_odd : (uint8_t*)cdc_data_rx)
+#else
+    #define CDC_RX_DATA     ((uint8_t*)cdc_data_rx)
+#endif
+
+static USB_TRANSFER_CALLBACK cdc_tx_callback;   // called after CDCTxService() once an IN packet is sent
+static void *cdc_tx_context;
+
 
 CONTROL_SIGNAL_BITMAP control_signal_bitmap;
 uint32_t BaudRateGen;			// BRG value calculated from baud rate
@@ -115,6 +174,12 @@ CTRL_TRF_RETURN USB_CDC_SET_LINE_CODING_HANDLER(CTRL_TRF_PARAMS);
 
 /** P R I V A T E  P R O T O T Y P E S ***************************************/
 void USBCDCSetLineCoding(void);
+static void CDCDataInComplete(void *context);
+static void CDCRxStart(USB_HANDLE first);
+static void CDCRxNext(void);
+#if defined(CDC_TX_RING_SIZE)
+static void CDCTxRingService(void);
+#endif
 
 /** D E C L A R A T I O N S **************************************************/
 //#pragma code
@@ -300,6 +365,7 @@ void CDCInitEP(void)
     line_coding.bDataBits = 0x08;               // 5,6,7,8, or 16
 
     cdc_rx_len = 0;
+    cdc_rx_offset = 0;
     
     /*
      * Do not have to init Cnt of IN pipes here.
@@ -315,9 +381,26 @@ void CDCInitEP(void)
     USBEnableEndpoint(CDC_COMM_EP,USB_IN_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
     USBEnableEndpoint(CDC_DATA_EP,USB_IN_ENABLED|USB_OUT_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
 
-    CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+    CDCRxStart(NULL);
     CDCDataInHandle = NULL;
 
+    //Load the next IN packet as soon as the previous one has been sent
+    cdc_tx_callback = NULL;
+    cdc_tx_context = NULL;
+    USBDeviceSetTransferCallback(CDC_DATA_EP, IN_TO_HOST, CDCDataInComplete, NULL);
+
+    #if defined(CDC_TX_PING_PONG)
+        CDCDataInHandles[0] = NULL;
+        CDCDataInHandles[1] = NULL;
+        cdc_tx_buffer = 0;
+    #endif
+
+    #if defined(CDC_TX_RING_SIZE)
+        cdc_tx_ring_head = 0;
+        cdc_tx_ring_tail = 0;
+        cdc_tx_ring_zlp = false;
+    #endif
+
     #if defined(USB_CDC_SUPPORT_DSR_REPORTING)
       	CDCNotificationInHandle = NULL;
         mInitDTSPin();  //Configure DTS as a digital input
@@ -346,6 +429,73 @@ void CDCInitEP(void)
     cdc_trf_state = CDC_TX_READY;
 }//end CDCInitEP
 
+/**************************************************************************
+  Function:
+        void CDCSetRxCallback(USB_TRANSFER_CALLBACK callback, void *context)
+    
+  Summary:
+    Registers the function called when a packet is received through the
+    USB CDC Bulk OUT endpoint.
+  Description:
+    Registers the function called when a packet is received through the
+    USB CDC Bulk OUT endpoint.  The packet can be read from the callback with
+    getsUSBUSART() or CDCPeek().
+  Conditions:
+    CDCInitEP() must have been called previously.
+  Input:
+    callback -  function to call, NULL removes the callback
+    context -   pointer passed back to the callback
+  Remarks:
+    The callback runs from USBDeviceTasks(), in the interrupt context when
+    USB_INTERRUPT is used.
+  **************************************************************************/
+void CDCSetRxCallback(USB_TRANSFER_CALLBACK callback, void *context)
+{
+    USBDeviceSetTransferCallback(CDC_DATA_EP, OUT_FROM_HOST, callback, context);
+}
+
+/**************************************************************************
+  Function:
+        void CDCSetTxCallback(USB_TRANSFER_CALLBACK callback, void *context)
+    
+  Summary:
+    Registers the function called when a packet has been sent through the
+    USB CDC Bulk IN endpoint.
+  Description:
+    Registers the function called when a packet has been sent through the
+    USB CDC Bulk IN endpoint.  The driver first runs CDCTxService() to load
+    the next packet of the current transfer, so the callback can check
+    USBUSARTIsTxTrfReady() and start the next one with putUSBUSART().
+  Conditions:
+    CDCInitEP() must have been called previously, it removes the callback.
+  Input:
+    callback -  function to call, NULL removes the callback
+    context -   pointer passed back to the callback
+  Remarks:
+    The callback runs from USBDeviceTasks(), in the interrupt context when
+    USB_INTERRUPT is used.
+  **************************************************************************/
+void CDCSetTxCallback(USB_TRANSFER_CALLBACK callback, void *context)
+{
+    USBMaskInterrupts();
+    cdc_tx_context = context;
+    cdc_tx_callback = callback;
+    USBUnmaskInterrupts();
+}
+
+/* Transfer complete callback of the CDC Bulk IN endpoint */
+static void CDCDataInComplete(void *context)
+{
+    (void)context;
+
+    CDCTxService();
+
+    if(cdc_tx_callback != NULL)
+    {
+        cdc_tx_callback(cdc_tx_context);
+    }
+}
+
 
 /**************************************************************************
   Function: void CDCNotificationHandler(void)
@@ -426,16 +576,37 @@ bool USBCDCEventHandler(USB_EVENT event, void *pdata, uint16_t size)
     switch( (uint16_t)event )
     {  
         case EVENT_TRANSFER_TERMINATED:
+            #if defined(CDC_RX_PING_PONG)
+            /*
+             * The stack reports the buffer the SIE uses next last, start over
+             * from it once neither buffer is armed anymore
+             */
+            if( ((pdata == CDCDataOutHandles[0]) || (pdata == CDCDataOutHandles[1])) &&
+                !USBHandleBusy(CDCDataOutHandles[0]) && !USBHandleBusy(CDCDataOutHandles[1]) )
+            {
+                CDCRxStart(pdata);
+            }
+            #else
             if(pdata == CDCDataOutHandle)
             {
-                CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+                CDCRxStart(NULL);
             }
+            #endif
+            #if defined(CDC_TX_PING_PONG)
+            if((pdata == CDCDataInHandles[0]) || (pdata == CDCDataInHandles[1]))
+            #else
             if(pdata == CDCDataInHandle)
+            #endif
             {
                 //flush all of the data in the CDC buffer
                 cdc_trf_state = CDC_TX_READY;
                 cdc_tx_len = 0;
             }
+            else if((cdc_trf_state == CDC_TX_DIRECT) && !USBDeviceTransferBusy(CDC_DATA_EP, IN_TO_HOST))
+            {
+                //the CDCSendDirect() transfer was dropped with the halt
+                cdc_trf_state = CDC_TX_READY;
+            }
             break;
         default:
             return false;
@@ -484,34 +655,236 @@ bool USBCDCEventHandler(USB_EVENT event, void *pdata, uint16_t size)
   **********************************************************************************/
 uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len)
 {
+    return (uint8_t)CDCGet(buffer, len);
+}//end getsUSBUSART
+
+/**********************************************************************************
+  Function:
+        uint16_t CDCGet(uint8_t *buffer, uint16_t len)
+    
+  Summary:
+    CDCGet copies the data received through the USB CDC Bulk OUT endpoint to
+    a user's specified location, several packets at a time. It is a
+    non-blocking function.
+
+  Description:
+    CDCGet works like getsUSBUSART() with a 16-bit length.  Once the first
+    packet is copied, the following packets already received (the other
+    ping-pong buffer) are appended as long as they fit whole in 'buffer',
+    so a buffer of several CDC_DATA_OUT_EP_SIZE bytes is filled in one
+    call.
+    
+    Typical Usage:
+    <code>
+        uint16_t numBytes;
+        uint8_t buffer[2 * CDC_DATA_OUT_EP_SIZE];
+    
+        numBytes = CDCGet(buffer, sizeof(buffer));
+        if(numBytes \> 0)
+        {
+            //we received numBytes bytes of data in buffer[]
+        }
+    </code>
+  Conditions:
+    As with getsUSBUSART(), the bytes of the first packet that do not fit
+    in 'len' are dropped.
+  Input:
+    buffer -  Pointer to where received BYTEs are to be stored
+    len -     The number of BYTEs expected.
+  Return:
+    uint16_t - the number of bytes copied into 'buffer', 0 if no new data
+    was available.
+  
+  **********************************************************************************/
+uint16_t CDCGet(uint8_t *buffer, uint16_t len)
+{
+    uint16_t available;
+
     cdc_rx_len = 0;
     
-    if(!USBHandleBusy(CDCDataOutHandle))
+    while(!USBHandleBusy(CDCDataOutHandle))
     {
         /*
          * Adjust the expected number of BYTEs to equal
-         * the actual number of BYTEs received.
+         * the actual number of BYTEs received.  A packet that does not
+         * fit whole is left for the next call, except for the first one.
          */
-        if(len > USBHandleGetLength(CDCDataOutHandle))
-            len = USBHandleGetLength(CDCDataOutHandle);
+        available = USBHandleGetLength(CDCDataOutHandle) - cdc_rx_offset;
+        if(available > len)
+        {
+            if(cdc_rx_len != 0)
+                break;
+            available = len;
+        }
         
         /*
-         * Copy data from dual-ram buffer to user's buffer
+         * Copy data from dual-ram buffer to user's buffer, skipping
+         * the bytes already released with CDCConsume()
          */
-        for(cdc_rx_len = 0; cdc_rx_len < len; cdc_rx_len++)
-            buffer[cdc_rx_len] = cdc_data_rx[cdc_rx_len];
+        usb_memcpy(&buffer[cdc_rx_len], &CDC_RX_DATA[cdc_rx_offset], available);
+        cdc_rx_len += available;
+        len -= available;
 
         /*
          * Prepare dual-ram buffer for next OUT transaction
          */
+        CDCRxNext();
 
-        CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
-
-    }//end if
+        if(len == 0)
+            break;
+    }//end while
     
     return cdc_rx_len;
     
-}//end getsUSBUSART
+}//end CDCGet
+
+/**********************************************************************************
+  Function:
+        uint8_t CDCPeek(uint8_t **data)
+    
+  Summary:
+    CDCPeek gives access to the data received through the USB CDC Bulk OUT
+    endpoint without copying it. It is a non-blocking function.
+
+  Description:
+    CDCPeek points 'data' at the bytes of the last packet received through the
+    USB CDC Bulk OUT endpoint that have not been released with CDCConsume()
+    yet, straight in the endpoint buffer. The endpoint is not re-armed, so
+    the host is NAKed until the whole packet has been consumed.
+
+    Since the endpoint buffer is in USB RAM, it may be handed over to another
+    endpoint (with USBTxOnePacket()) as long as it is only consumed once that
+    transfer is complete.
+    
+    Typical Usage:
+    <code>
+        uint8_t *data;
+        uint8_t numBytes;
+    
+        numBytes = CDCPeek(&data);
+        if(numBytes \> 0)
+        {
+            //process some of the data[] bytes, then release them
+            CDCConsume(numBytes);
+        }
+    </code>
+  Conditions:
+    Do not call getsUSBUSART() while the data returned by CDCPeek() is
+    still in use.
+  Input:
+    data -  where to store the address of the first unconsumed byte.
+  Return:
+    uint8_t - Returns the number of bytes available at 'data', 0 if no
+    data has been received.
+  
+  **********************************************************************************/
+uint8_t CDCPeek(uint8_t **data)
+{
+    uint8_t length;
+
+    /*
+     * A zero length packet carries no data, give the buffer back right away
+     * and look at the next one
+     */
+    while(!USBHandleBusy(CDCDataOutHandle))
+    {
+        length = USBHandleGetLength(CDCDataOutHandle);
+
+        if(length > cdc_rx_offset)
+        {
+            *data = &CDC_RX_DATA[cdc_rx_offset];
+            return length - cdc_rx_offset;
+        }
+
+        CDCRxNext();
+    }
+
+    return 0;
+}//end CDCPeek
+
+/**********************************************************************************
+  Function:
+        void CDCConsume(uint8_t len)
+    
+  Summary:
+    CDCConsume releases bytes returned by CDCPeek().
+
+  Description:
+    CDCConsume releases the first 'len' bytes returned by CDCPeek(). Once all
+    of the bytes of the packet are released, the USB CDC Bulk OUT endpoint is
+    re-armed for the next packet.
+    
+  Conditions:
+    'len' must not be larger than the value returned by the last CDCPeek()
+    call.
+  Input:
+    len -  the number of bytes to release.
+  
+  **********************************************************************************/
+void CDCConsume(uint8_t len)
+{
+    cdc_rx_offset += len;
+
+    if(cdc_rx_offset >= USBHandleGetLength(CDCDataOutHandle))
+    {
+        CDCRxNext();
+    }
+}//end CDCConsume
+
+/**************************************************************************
+  Function:
+        static void CDCRxStart(USB_HANDLE first)
+    
+  Summary:
+    Arms the OUT buffers of the data endpoint, dropping any data not read
+    yet.
+  Conditions:
+    None of the OUT buffers is armed.
+  Input:
+    first -  with ping-pong buffering, the handle of the buffer descriptor
+             the SIE fills first, NULL if it is the one armed first.
+  Remarks:
+    None
+  **************************************************************************/
+static void CDCRxStart(USB_HANDLE first)
+{
+    cdc_rx_offset = 0;
+
+    #if defined(CDC_RX_PING_PONG)
+        CDCDataOutHandles[0] = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+        CDCDataOutHandles[1] = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx_odd,sizeof(cdc_data_rx_odd));
+        cdc_rx_buffer = ((first == NULL) || (first == CDCDataOutHandles[0])) ? 0 : 1;
+        CDCDataOutHandle = CDCDataOutHandles[cdc_rx_buffer];
+    #else
+        CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+    #endif
+}
+
+/**************************************************************************
+  Function:
+        static void CDCRxNext(void)
+    
+  Summary:
+    Gives the OUT buffer just read back to the endpoint, and moves on to
+    the other one with ping-pong buffering.
+  Conditions:
+    CDCDataOutHandle is not busy.
+  Remarks:
+    The SIE fills the buffers alternately, so re-arming them in the order
+    they are read keeps each one on the same buffer descriptor.
+  **************************************************************************/
+static void CDCRxNext(void)
+{
+    cdc_rx_offset = 0;
+
+    #if defined(CDC_RX_PING_PONG)
+        CDCDataOutHandles[cdc_rx_buffer] = USBRxOnePacket(CDC_DATA_EP,CDC_RX_DATA,CDC_DATA_OUT_EP_SIZE);
+        cdc_rx_buffer ^= 1;
+        CDCDataOutHandle = CDCDataOutHandles[cdc_rx_buffer];
+    #else
+        CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+    #endif
+}
 
 /******************************************************************************
   Function:
@@ -546,7 +919,7 @@ uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len)
     USBUSARTIsTxTrfReady() must return true. This indicates that the last
     transfer is complete and is ready to receive a new block of data. The
     string of characters pointed to by 'data' must equal to or smaller than
-    255 BYTEs.
+    255 BYTEs, CDCPut() sends longer ones.
 
   Input:
     char *data - pointer to a RAM array of data to be transfered to the host
@@ -578,13 +951,56 @@ void putUSBUSART(uint8_t *data, uint8_t  length)
      * multi-tasking and a blocking code is not acceptable.
      * Use a state machine instead.
      */
+    CDCPut(data, length);
+}//end putUSBUSART
+
+/******************************************************************************
+  Function:
+    bool CDCPut(uint8_t *data, uint16_t length)
+		
+  Summary:
+    CDCPut writes an array of data of up to 65535 bytes to the USB.
+
+  Description:
+    CDCPut works like putUSBUSART() with a 16-bit length, so a whole SysEx
+    dump or patch bank is sent with a single call.  CDCTxService() splits it
+    in CDC_DATA_IN_EP_SIZE packets and ends the transfer with a zero length
+    packet when the last one is full.
+    
+    Typical Usage:
+    <code>
+        if(USBUSARTIsTxTrfReady())
+        {
+            CDCPut(dump, sizeof(dump));
+        }
+    </code>
+
+  Conditions:
+    'data' must stay untouched until USBUSARTIsTxTrfReady() returns true
+    again.
+
+  Input:
+    uint8_t *data - pointer to a RAM array of data to be transfered to the host
+    uint16_t length - the number of bytes to be transfered
+		
+  Return:
+    bool - false if the last transfer is not complete, nothing is sent.
+ *****************************************************************************/
+bool CDCPut(uint8_t *data, uint16_t length)
+{
+    bool started = false;
+
+    //See the remarks of putUSBUSART(), the state is checked once more
     USBMaskInterrupts();
     if(cdc_trf_state == CDC_TX_READY)
     {
         mUSBUSARTTxRam((uint8_t*)data, length);     // See cdc.h
+        started = true;
     }
     USBUnmaskInterrupts();
-}//end putUSBUSART
+
+    return started;
+}//end CDCPut
 
 /******************************************************************************
 	Function:
@@ -836,13 +1252,35 @@ void putrsUSBUSART(const const char *data)
 void CDCTxService(void)
 {
     uint8_t byte_to_send;
-    uint8_t i;
+    uint8_t* tx_buffer;
     
     USBMaskInterrupts();
     
     CDCNotificationHandler();
     
+    /*
+     * A CDCSendDirect() transfer is over once USBDeviceTransfer() is done
+     * with it, both IN buffers are free again then.
+     */
+    if(cdc_trf_state == CDC_TX_DIRECT)
+    {
+        if(USBDeviceTransferBusy(CDC_DATA_EP, IN_TO_HOST))
+        {
+            USBUnmaskInterrupts();
+            return;
+        }
+        cdc_trf_state = CDC_TX_READY;
+    }
+
+    /*
+     * With ping-pong buffering only the buffer the next packet goes to
+     * has to be free, the other one may still be waiting for the host.
+     */
+    #if defined(CDC_TX_PING_PONG)
+    if(USBHandleBusy(CDCDataInHandles[cdc_tx_buffer]))
+    #else
     if(USBHandleBusy(CDCDataInHandle)) 
+    #endif
     {
         USBUnmaskInterrupts();
         return;
@@ -857,10 +1295,14 @@ void CDCTxService(void)
         cdc_trf_state = CDC_TX_READY;
     
     /*
-     * If CDC_TX_READY state, nothing to do, just return.
+     * If CDC_TX_READY state, nothing to do but loading the data queued with
+     * CDCWrite(), just return.
      */
     if(cdc_trf_state == CDC_TX_READY)
     {
+        #if defined(CDC_TX_RING_SIZE)
+            CDCTxRingService();
+        #endif
         USBUnmaskInterrupts();
         return;
     }
@@ -873,6 +1315,11 @@ void CDCTxService(void)
         CDCDataInHandle = USBTxOnePacket(CDC_DATA_EP,NULL,0);
         //CDC_DATA_BD_IN.CNT = 0;
         cdc_trf_state = CDC_TX_COMPLETING;
+
+        #if defined(CDC_TX_PING_PONG)
+            CDCDataInHandles[cdc_tx_buffer] = CDCDataInHandle;
+            cdc_tx_buffer ^= 1;
+        #endif
     }
     else if(cdc_trf_state == CDC_TX_BUSY)
     {
@@ -882,36 +1329,31 @@ void CDCTxService(void)
     	if(cdc_tx_len > sizeof(cdc_data_tx))
     	    byte_to_send = sizeof(cdc_data_tx);
     	else
-    	    byte_to_send = cdc_tx_len;
+    	    byte_to_send = (uint8_t)cdc_tx_len;
 
         /*
          * Subtract the number of bytes just about to be sent from the total.
          */
     	cdc_tx_len = cdc_tx_len - byte_to_send;
     	  
-        pCDCDst.bRam = (uint8_t*)&cdc_data_tx; // Set destination pointer
-        
-        i = byte_to_send;
+        #if defined(CDC_TX_PING_PONG)
+            tx_buffer = (cdc_tx_buffer != 0) ? (uint8_t*)&cdc_data_tx_odd : (uint8_t*)&cdc_data_tx;
+        #else
+            tx_buffer = (uint8_t*)&cdc_data_tx;
+        #endif
+
+        CYCLE_COUNTER_Enter(CYCLE_COUNTER_CDC_TX_COPY);
         if(cdc_mem_type == USB_EP0_ROM)            // Determine type of memory source
         {
-            while(i)
-            {
-                *pCDCDst.bRam = *pCDCSrc.bRom;
-                pCDCDst.bRam++;
-                pCDCSrc.bRom++;
-                i--;
-            }//end while(byte_to_send)
+            usb_memcpy_rom(tx_buffer, pCDCSrc.bRom, byte_to_send);
+            pCDCSrc.bRom += byte_to_send;
         }
         else
         {
-            while(i)
-            {
-                *pCDCDst.bRam = *pCDCSrc.bRam;
-                pCDCDst.bRam++;
-                pCDCSrc.bRam++;
-                i--;
-            }
+            usb_memcpy(tx_buffer, pCDCSrc.bRam, byte_to_send);
+            pCDCSrc.bRam += byte_to_send;
         }
+        CYCLE_COUNTER_Exit(CYCLE_COUNTER_CDC_TX_COPY);
         
         /*
          * Lastly, determine if a zero length packet state is necessary.
@@ -924,13 +1366,244 @@ void CDCTxService(void)
             else
                 cdc_trf_state = CDC_TX_COMPLETING;
         }//end if(cdc_tx_len...)
-        CDCDataInHandle = USBTxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_tx,byte_to_send);
+
+        CDCDataInHandle = USBTxOnePacket(CDC_DATA_EP,tx_buffer,byte_to_send);
+
+        #if defined(CDC_TX_PING_PONG)
+            CDCDataInHandles[cdc_tx_buffer] = CDCDataInHandle;
+            cdc_tx_buffer ^= 1;
+        #endif
 
     }//end if(cdc_tx_sate == CDC_TX_BUSY)
     
     USBUnmaskInterrupts();
 }//end CDCTxService
 
+/**************************************************************************
+  Function:
+        bool CDCSendDirect(uint8_t *data, uint16_t length)
+    
+  Summary:
+    Sends a buffer of any length through the USB CDC Bulk IN endpoint
+    without copying it.
+
+  Description:
+    The IN buffer descriptors are pointed at 'data' by USBDeviceTransfer(),
+    one CDC_DATA_IN_EP_SIZE slice after the other.  CDCTxService() is
+    called back once the last packet has been sent, and goes back to the
+    CDC_TX_READY state.
+
+  Conditions:
+    'data' must be in RAM the USB module can access and stay untouched
+    until USBUSARTIsTxTrfReady() returns true again.
+  Input:
+    data -    pointer to the data to send
+    length -  number of bytes to send
+  Return:
+    bool - false if the CDC IN endpoint is still busy, nothing is sent.
+  **************************************************************************/
+bool CDCSendDirect(uint8_t *data, uint16_t length)
+{
+    bool started = false;
+
+    USBMaskInterrupts();
+
+    //The transfer loads both IN buffers, none of them may still hold a
+    //packet of putUSBUSART() or of the transmit ring
+    #if defined(CDC_TX_PING_PONG)
+    if( (cdc_trf_state == CDC_TX_READY) &&
+        !USBHandleBusy(CDCDataInHandles[0]) && !USBHandleBusy(CDCDataInHandles[1])
+    #else
+    if( (cdc_trf_state == CDC_TX_READY) && !USBHandleBusy(CDCDataInHandle)
+    #endif
+        #if defined(CDC_TX_RING_SIZE)
+        && (cdc_tx_ring_head == cdc_tx_ring_tail)
+        #endif
+      )
+    {
+        if(USBDeviceTransfer(CDC_DATA_EP, IN_TO_HOST, data, length, CDC_DATA_IN_EP_SIZE, USB_TRANSFER_ZLP))
+        {
+            cdc_trf_state = CDC_TX_DIRECT;
+            started = true;
+
+            #if defined(CDC_TX_RING_SIZE)
+                //the transfer takes care of its own zero length packet
+                cdc_tx_ring_zlp = false;
+            #endif
+        }
+    }
+
+    USBUnmaskInterrupts();
+
+    return started;
+}
+
+#if defined(CDC_TX_RING_SIZE)
+/**************************************************************************
+  Function:
+        uint16_t CDCWrite(uint8_t *data, uint16_t length)
+    
+  Summary:
+    Queues data to be sent through the USB CDC Bulk IN endpoint.
+
+  Description:
+    CDCWrite copies as much of 'data' as fits in the transmit ring and
+    returns right away, whether or not the previous data has been sent.
+    CDCTxService() loads it on the endpoint, a packet on each free IN
+    buffer.
+
+  Conditions:
+    CDC_TX_RING_SIZE is defined.  Data passed to putUSBUSART() and the
+    like is sent after the ring data already loaded on the endpoint, and
+    before the rest of it.
+  Input:
+    data -    pointer to the data to send
+    length -  number of bytes to send
+  Return:
+    uint16_t - the number of bytes queued, less than 'length' when the
+    ring is full.
+  **************************************************************************/
+uint16_t CDCWrite(uint8_t *data, uint16_t length)
+{
+    uint16_t head;
+    uint16_t free;
+    uint16_t index;
+    uint16_t first;
+
+    //Only CDCTxService() moves the tail, from the interrupt as well
+    USBMaskInterrupts();
+    head = cdc_tx_ring_head;
+    free = CDC_TX_RING_SIZE - (head - cdc_tx_ring_tail);
+    USBUnmaskInterrupts();
+
+    if(length > free)
+    {
+        length = free;
+    }
+
+    //The data may wrap around the end of the ring
+    index = head & (CDC_TX_RING_SIZE - 1);
+    first = CDC_TX_RING_SIZE - index;
+    if(first > length)
+    {
+        first = length;
+    }
+    usb_memcpy(&cdc_tx_ring[index], data, first);
+    usb_memcpy(cdc_tx_ring, &data[first], length - first);
+
+    USBMaskInterrupts();
+    cdc_tx_ring_head = head + length;
+    USBUnmaskInterrupts();
+
+    return length;
+}
+
+/**************************************************************************
+  Function:
+        uint16_t CDCWriteFree(void)
+    
+  Summary:
+    Returns the number of bytes CDCWrite() can queue.
+
+  Conditions:
+    CDC_TX_RING_SIZE is defined.
+  Return:
+    uint16_t - free space of the transmit ring, in bytes.
+  **************************************************************************/
+uint16_t CDCWriteFree(void)
+{
+    uint16_t free;
+
+    USBMaskInterrupts();
+    free = CDC_TX_RING_SIZE - (cdc_tx_ring_head - cdc_tx_ring_tail);
+    USBUnmaskInterrupts();
+
+    return free;
+}
+
+/**************************************************************************
+  Function:
+        static void CDCTxRingService(void)
+    
+  Summary:
+    Loads the data of the transmit ring on every free IN buffer.
+  Conditions:
+    Called by CDCTxService(), with the USB interrupt masked, while no
+    putUSBUSART() transfer is in progress.
+  Remarks:
+    A packet is loaded as soon as a buffer is free, with up to
+    CDC_DATA_IN_EP_SIZE bytes.  A transfer ending with a full packet is
+    ended with a zero length packet, only once that packet has been read
+    and no more data has been written meanwhile.
+  **************************************************************************/
+static void CDCTxRingService(void)
+{
+    uint16_t count;
+    uint16_t index;
+    uint8_t byte_to_send;
+    uint8_t first;
+    uint8_t* tx_buffer;
+
+    #if defined(CDC_TX_PING_PONG)
+    while(!USBHandleBusy(CDCDataInHandles[cdc_tx_buffer]))
+    #else
+    while(!USBHandleBusy(CDCDataInHandle))
+    #endif
+    {
+        count = cdc_tx_ring_head - cdc_tx_ring_tail;
+
+        if(count == 0)
+        {
+            #if defined(CDC_TX_PING_PONG)
+            if((cdc_tx_ring_zlp == false) || USBHandleBusy(CDCDataInHandles[cdc_tx_buffer ^ 1]))
+            #else
+            if(cdc_tx_ring_zlp == false)
+            #endif
+            {
+                break;
+            }
+            byte_to_send = 0;
+        }
+        else if(count > CDC_DATA_IN_EP_SIZE)
+        {
+            byte_to_send = CDC_DATA_IN_EP_SIZE;
+        }
+        else
+        {
+            byte_to_send = (uint8_t)count;
+        }
+
+        #if defined(CDC_TX_PING_PONG)
+            tx_buffer = (cdc_tx_buffer != 0) ? (uint8_t*)&cdc_data_tx_odd : (uint8_t*)&cdc_data_tx;
+        #else
+            tx_buffer = (uint8_t*)&cdc_data_tx;
+        #endif
+
+        //The packet may wrap around the end of the ring
+        CYCLE_COUNTER_Enter(CYCLE_COUNTER_CDC_TX_COPY);
+        index = cdc_tx_ring_tail & (CDC_TX_RING_SIZE - 1);
+        first = byte_to_send;
+        if((CDC_TX_RING_SIZE - index) < byte_to_send)
+        {
+            first = (uint8_t)(CDC_TX_RING_SIZE - index);
+        }
+        usb_memcpy(tx_buffer, &cdc_tx_ring[index], first);
+        usb_memcpy(&tx_buffer[first], cdc_tx_ring, byte_to_send - first);
+        CYCLE_COUNTER_Exit(CYCLE_COUNTER_CDC_TX_COPY);
+
+        cdc_tx_ring_tail += byte_to_send;
+        cdc_tx_ring_zlp = (byte_to_send == CDC_DATA_IN_EP_SIZE);
+
+        CDCDataInHandle = USBTxOnePacket(CDC_DATA_EP,tx_buffer,byte_to_send);
+
+        #if defined(CDC_TX_PING_PONG)
+            CDCDataInHandles[cdc_tx_buffer] = CDCDataInHandle;
+            cdc_tx_buffer ^= 1;
+        #endif
+    }
+}
+#endif
+
 #endif //USB_USE_CDC
 
 /** EOF cdc.c ****************************************************************/
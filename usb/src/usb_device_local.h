@@ -201,6 +201,10 @@ typedef union
         #define USB_NEXT_EP0_OUT_PING_PONG 0x0008
         #define USB_NEXT_EP0_IN_PING_PONG 0x0008
         #define USB_NEXT_PING_PONG 0x0008
+    #elif defined(USB_SIMULATION)
+        #define USB_NEXT_EP0_OUT_PING_PONG USB_BDT_ENTRY_SIZE
+        #define USB_NEXT_EP0_IN_PING_PONG USB_BDT_ENTRY_SIZE
+        #define USB_NEXT_PING_PONG USB_BDT_ENTRY_SIZE
     #else
         #error "Not defined for this compiler"
     #endif
@@ -279,6 +283,8 @@ typedef union
         #endif
     #elif defined(__C32__)
         #define BD(ep,dir,pp) (8*(4*ep+2*dir+pp))
+    #elif defined(USB_SIMULATION)
+        #define BD(ep,dir,pp) (USB_BDT_ENTRY_SIZE*(4*ep+2*dir+pp))
     #else
         #error "Not defined for this compiler"
     #endif
@@ -340,8 +340,6 @@ void USBCheckMSDRequest(void)
   *********************************************************************************/	
 uint8_t MSDTasks(void)
 {
-    uint8_t i;
-    
     //Error check to make sure we have are in the CONFIGURED_STATE, prior to
     //performing MSDTasks().  Some of the MSDTasks require that the device be
     //configured first.
@@ -374,10 +372,7 @@ uint8_t MSDTasks(void)
                 //that we keep track of the command, but free up the MSD OUT endpoint
                 //buffer for fulfilling whatever request may have been received.
                 //gblCBW = msd_cbw; //we are doing this, but below method can yeild smaller code size
-                for(i = 0; i < MSD_CBW_SIZE; i++)
-                {
-                    *((uint8_t*)&gblCBW.dCBWSignature + i) = *((uint8_t*)&msd_cbw.dCBWSignature + i);
-                }
+                usb_memcpy(&gblCBW, (uint8_t*)&msd_cbw, MSD_CBW_SIZE);
 
                 //If this CBW is valid?
                 if((USBHandleGetLength(USBMSDOutHandle) == MSD_CBW_SIZE) && (gblCBW.dCBWSignature == MSD_VALID_CBW_SIGNATURE))
@@ -774,7 +769,7 @@ void MSDProcessCommandMediaPresent(void)
 
             //copy the inquiry results from the defined const buffer 
             //  into the USB buffer so that it can be transmitted
-            memcpy((void *)&msd_buffer[0], (const void*)&inq_resp, sizeof(InquiryResponse));   //Inquiry response is 36 bytes total
+            usb_memcpy_rom((uint8_t*)&msd_buffer[0], (const uint8_t*)&inq_resp, sizeof(InquiryResponse));   //Inquiry response is 36 bytes total
             MSDCommandState = MSD_COMMAND_RESPONSE;
             break;
         }
@@ -825,10 +820,7 @@ void MSDProcessCommandMediaPresent(void)
             MSDComputeDeviceInAndResidue(sizeof(RequestSenseResponse));
              
             //Copy the requested response data from flash to the USB ram buffer.
-            for(i=0;i<sizeof(RequestSenseResponse);i++)
-            {
-                msd_buffer[i]=gblSenseData[LUN_INDEX]._byte[i];
-            }
+            usb_memcpy((uint8_t*)msd_buffer, gblSenseData[LUN_INDEX]._byte, sizeof(RequestSenseResponse));
             MSDCommandState = MSD_COMMAND_RESPONSE;
             break;
             
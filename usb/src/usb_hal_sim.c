@@ -0,0 +1,338 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license),
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+//DOM-IGNORE-END
+
+/* In memory model of the PIC18 USB module (SIE) used by the simulation
+ * backend.  Only the behavior the device stack relies on is modeled:
+ * buffer descriptor ownership, ping-pong pointers, data toggle checking of
+ * OUT packets, endpoint stalls, packet processing being disabled by SETUP
+ * packets, and the 4 entry USTAT FIFO behind the transaction complete flag.
+ */
+
+#if defined(USB_SIMULATION)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "usb.h"
+#include "cycle_counter.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+#define USB_SIM_USTAT_FIFO_SIZE     4
+
+#define USB_SIM_DIR_OUT             0
+#define USB_SIM_DIR_IN              1
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Simulated Registers
+// *****************************************************************************
+// *****************************************************************************
+volatile USB_SIM_UIR usbSimUIR;
+volatile USB_SIM_UIR usbSimUIE;
+volatile USB_SIM_UCON usbSimUCON;
+volatile USB_SIM_UEP usbSimUEP[16];
+volatile uint8_t usbSimUEIR;
+volatile uint8_t usbSimUEIE;
+volatile uint8_t usbSimUADDR;
+volatile uint8_t usbSimUCFG;
+volatile uint8_t usbSimUSTAT;
+volatile bool usbSimInterruptEnable;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: SIE State
+// *****************************************************************************
+// *****************************************************************************
+extern volatile BDT_ENTRY BDT[BDT_NUM_ENTRIES];
+
+static uint8_t usbSimPingPong[USB_MAX_EP_NUMBER + 1][2];   //next buffer used by the SIE
+static uint8_t usbSimStatFifo[USB_SIM_USTAT_FIFO_SIZE];
+static uint8_t usbSimStatHead;
+static uint8_t usbSimStatCount;
+static uint8_t usbSimPingPongReset;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Buffer descriptor the SIE uses next for an endpoint and direction */
+static volatile BDT_ENTRY* USBSimGetBD(uint8_t ep, uint8_t dir)
+{
+    #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG)
+        return &BDT[(4 * ep) + (2 * dir) + usbSimPingPong[ep][dir]];
+    #else
+        return &BDT[(2 * ep) + dir];
+    #endif
+}
+
+/* Raises an interrupt flag, bus activity also wakes up a suspended module */
+static void USBSimRaise(uint8_t flag)
+{
+    if(usbSimUCON.SUSPND == 1)
+    {
+        usbSimUIR.ACTVIF = 1;
+    }
+    usbSimUIR.Val |= flag;
+
+    USBSimInterrupt();
+}
+
+/* Checks that a token is for this device and may use the endpoint */
+static bool USBSimAccepts(uint8_t address, uint8_t ep, uint8_t dir)
+{
+    if((usbSimUCON.USBEN == 0) || (address != usbSimUADDR) || (ep > USB_MAX_EP_NUMBER))
+    {
+        return false;
+    }
+
+    if(usbSimUCON.SUSPND == 1)
+    {
+        USBSimRaise(0);
+        return false;
+    }
+
+    if(dir == USB_SIM_DIR_OUT)
+    {
+        return (usbSimUEP[ep].EPOUTEN == 1);
+    }
+    return (usbSimUEP[ep].EPINEN == 1);
+}
+
+/* Hands a buffer descriptor back to the CPU and queues its USTAT entry */
+static void USBSimComplete(uint8_t ep, uint8_t dir, uint8_t pid, uint8_t dataToggle)
+{
+    volatile BDT_ENTRY *bd = USBSimGetBD(ep, dir);
+    uint8_t stat;
+
+    stat = (uint8_t)((ep << 3) | (dir << 2) | (usbSimPingPong[ep][dir] << 1));
+
+    bd->STAT.Val = (uint8_t)((pid << 2) | (dataToggle << 6));
+
+    #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG)
+        usbSimPingPong[ep][dir] ^= 1;
+    #endif
+
+    usbSimStatFifo[(usbSimStatHead + usbSimStatCount) % USB_SIM_USTAT_FIFO_SIZE] = stat;
+    usbSimStatCount++;
+
+    if(usbSimUIR.TRNIF == 0)
+    {
+        usbSimUSTAT = usbSimStatFifo[usbSimStatHead];
+    }
+
+    USBSimRaise(0x08);  //TRNIF
+}
+
+/* Stalls a token and flags it in UEPn, the buffer descriptor is left to
+ * the SIE */
+static USB_SIM_HANDSHAKE USBSimStall(uint8_t ep)
+{
+    usbSimUEP[ep].EPSTALL = 1;
+    USBSimRaise(0x20);  //STALLIF
+
+    return USB_SIM_STALL;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Device Stack Interface
+// *****************************************************************************
+// *****************************************************************************
+void USBSimClearInterruptFlag(volatile uint8_t *reg, uint8_t mask)
+{
+    bool transactionPending = (reg == &usbSimUIR.Val) && (usbSimUIR.TRNIF == 1);
+
+    *reg &= mask;
+
+    //Clearing TRNIF pops the USTAT FIFO, the next entry sets it again
+    if(transactionPending && (usbSimUIR.TRNIF == 0) && (usbSimStatCount != 0))
+    {
+        usbSimStatHead = (usbSimStatHead + 1) % USB_SIM_USTAT_FIFO_SIZE;
+        usbSimStatCount--;
+
+        if(usbSimStatCount != 0)
+        {
+            usbSimUSTAT = usbSimStatFifo[usbSimStatHead];
+            usbSimUIR.TRNIF = 1;
+        }
+    }
+}
+
+volatile uint8_t* USBSimPingPongBufferReset(void)
+{
+    memset(usbSimPingPong, 0, sizeof(usbSimPingPong));
+    return &usbSimPingPongReset;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Simulated Host Interface
+// *****************************************************************************
+// *****************************************************************************
+bool USBSimIsAttached(void)
+{
+    return (usbSimUCON.USBEN == 1) && ((usbSimUCFG & USB_PULLUP_ENABLE) != 0);
+}
+
+void USBSimBusReset(void)
+{
+    usbSimStatHead = 0;
+    usbSimStatCount = 0;
+
+    USBSimRaise(0x01);  //URSTIF
+}
+
+void USBSimBusIdle(void)
+{
+    USBSimRaise(0x10);  //IDLEIF
+}
+
+void USBSimStartOfFrame(void)
+{
+    if(usbSimUCON.USBEN == 1)
+    {
+        USBSimRaise(0x40);  //SOFIF
+    }
+}
+
+USB_SIM_HANDSHAKE USBSimSetup(uint8_t address, uint8_t ep, const uint8_t *packet)
+{
+    volatile BDT_ENTRY *bd;
+
+    if( !USBSimAccepts(address, ep, USB_SIM_DIR_OUT) || (usbSimUEP[ep].EPCONDIS == 1) ||
+        (usbSimUCON.PKTDIS == 1) || (usbSimStatCount == USB_SIM_USTAT_FIFO_SIZE) )
+    {
+        return USB_SIM_TIMEOUT;
+    }
+
+    //A SETUP packet can not be NAKed nor stalled, without a buffer it is lost
+    bd = USBSimGetBD(ep, USB_SIM_DIR_OUT);
+    if((bd->STAT.UOWN == 0) || (bd->CNT < 8))
+    {
+        return USB_SIM_TIMEOUT;
+    }
+
+    memcpy(ConvertToVirtualAddress(bd->ADR), packet, 8);
+    bd->CNT = 8;
+
+    usbSimUCON.PKTDIS = 1;
+    USBSimComplete(ep, USB_SIM_DIR_OUT, PID_SETUP, 0);
+
+    return USB_SIM_ACK;
+}
+
+USB_SIM_HANDSHAKE USBSimOut(uint8_t address, uint8_t ep, uint8_t dataToggle, const uint8_t *data, uint8_t length)
+{
+    volatile BDT_ENTRY *bd;
+
+    if(!USBSimAccepts(address, ep, USB_SIM_DIR_OUT))
+    {
+        return USB_SIM_TIMEOUT;
+    }
+
+    bd = USBSimGetBD(ep, USB_SIM_DIR_OUT);
+    if((usbSimUCON.PKTDIS == 1) || (usbSimStatCount == USB_SIM_USTAT_FIFO_SIZE) || (bd->STAT.UOWN == 0))
+    {
+        return USB_SIM_NAK;
+    }
+
+    if(bd->STAT.BSTALL == 1)
+    {
+        return USBSimStall(ep);
+    }
+
+    //A packet with the wrong data toggle is a retry of a packet already
+    //  received, it is acknowledged and ignored
+    if((bd->STAT.DTSEN == 1) && (bd->STAT.DTS != dataToggle))
+    {
+        return USB_SIM_ACK;
+    }
+
+    if(length > bd->CNT)
+    {
+        length = bd->CNT;
+    }
+
+    memcpy(ConvertToVirtualAddress(bd->ADR), data, length);
+    bd->CNT = length;
+
+    USBSimComplete(ep, USB_SIM_DIR_OUT, PID_OUT, dataToggle);
+
+    return USB_SIM_ACK;
+}
+
+USB_SIM_HANDSHAKE USBSimIn(uint8_t address, uint8_t ep, uint8_t *dataToggle, uint8_t *data, uint8_t *length)
+{
+    volatile BDT_ENTRY *bd;
+
+    if(!USBSimAccepts(address, ep, USB_SIM_DIR_IN))
+    {
+        return USB_SIM_TIMEOUT;
+    }
+
+    bd = USBSimGetBD(ep, USB_SIM_DIR_IN);
+    if((usbSimUCON.PKTDIS == 1) || (usbSimStatCount == USB_SIM_USTAT_FIFO_SIZE) || (bd->STAT.UOWN == 0))
+    {
+        return USB_SIM_NAK;
+    }
+
+    if(bd->STAT.BSTALL == 1)
+    {
+        return USBSimStall(ep);
+    }
+
+    *length = bd->CNT;
+    *dataToggle = bd->STAT.DTS;
+    memcpy(data, ConvertToVirtualAddress(bd->ADR), bd->CNT);
+
+    USBSimComplete(ep, USB_SIM_DIR_IN, PID_IN, *dataToggle);
+
+    return USB_SIM_ACK;
+}
+
+void USBSimInterrupt(void)
+{
+    #if defined(USB_INTERRUPT)
+        uint8_t i;
+
+        //The interrupt is taken again as long as an enabled flag is set
+        for(i = 0; (i < 8) && usbSimInterruptEnable && ((usbSimUIR.Val & usbSimUIE.Val) != 0); i++)
+        {
+            CYCLE_COUNTER_Enter(CYCLE_COUNTER_USB_DEVICE_TASKS);
+            USBDeviceTasks();
+            CYCLE_COUNTER_Exit(CYCLE_COUNTER_USB_DEVICE_TASKS);
+        }
+    #endif
+}
+
+#endif //USB_SIMULATION
@@ -0,0 +1,152 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright 2016 Microchip Technology Inc. (www.microchip.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+To request to license the code under the MLA license (www.microchip.com/mla_license),
+please contact mla_licensing@microchip.com
+*******************************************************************************/
+//DOM-IGNORE-END
+
+/* PIC18 block copies of the device stack.  A byte takes 2 cycles for the
+ * MOVFF (plus 2 for the TBLRD*+ from program memory) and 3 for the loop,
+ * where the compiled pointer loops they replace take 15 to 20 cycles.
+ * Other targets use the memcpy() of the C library instead, see
+ * usb_memcpy.h.
+ */
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include <xc.h>
+#include <stdint.h>
+
+#include "usb_memcpy.h"
+
+#if defined(USB_MEMCPY_PIC18)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Block Copies
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+        void usb_memcpy(void *dst, const void *src, uint16_t length)
+
+  Summary:
+    Copies a block of data memory.
+  Description:
+    The bytes of the last partial 256 byte page are copied first, then the
+    whole pages, with an 8-bit counter that wraps around from 0 to 255 for
+    those.
+  Conditions:
+    None
+  Input:
+    void *dst -         where to copy the data
+    const void *src -   data to copy, in RAM
+    uint16_t length -   number of bytes to copy
+  Return:
+    None
+  Remarks:
+    None
+  *****************************************************************************/
+void usb_memcpy(void *dst, const void *src, uint16_t length)
+{
+    uint16_t fsr0 = FSR0;
+    uint16_t fsr1 = FSR1;
+    uint8_t count = (uint8_t)length;
+    uint8_t pages = (uint8_t)(length >> 8);
+
+    FSR0 = (uint16_t)src;
+    FSR1 = (uint16_t)dst;
+
+    if(count != 0u)
+    {
+        do
+        {
+            POSTINC1 = POSTINC0;
+        } while(--count != 0u);
+    }
+
+    while(pages != 0u)
+    {
+        do
+        {
+            POSTINC1 = POSTINC0;
+        } while(--count != 0u);
+        pages--;
+    }
+
+    FSR0 = fsr0;
+    FSR1 = fsr1;
+}
+
+/*******************************************************************************
+  Function:
+        void usb_memcpy_rom(void *dst, const uint8_t *src, uint16_t length)
+
+  Summary:
+    Copies a block of program memory to data memory.
+  Description:
+    Same loops as usb_memcpy(), each byte is read into TABLAT with TBLRD*+
+    then moved to the destination.
+  Conditions:
+    None
+  Input:
+    void *dst -             where to copy the data
+    const uint8_t *src -    data to copy, in program memory
+    uint16_t length -       number of bytes to copy
+  Return:
+    None
+  Remarks:
+    None
+  *****************************************************************************/
+void usb_memcpy_rom(void *dst, const uint8_t *src, uint16_t length)
+{
+    uint24_t tblptr = TBLPTR;
+    uint16_t fsr1 = FSR1;
+    uint8_t count = (uint8_t)length;
+    uint8_t pages = (uint8_t)(length >> 8);
+
+    TBLPTR = (uint24_t)src;
+    FSR1 = (uint16_t)dst;
+
+    if(count != 0u)
+    {
+        do
+        {
+            asm("TBLRD*+");
+            POSTINC1 = TABLAT;
+        } while(--count != 0u);
+    }
+
+    while(pages != 0u)
+    {
+        do
+        {
+            asm("TBLRD*+");
+            POSTINC1 = TABLAT;
+        } while(--count != 0u);
+        pages--;
+    }
+
+    TBLPTR = tblptr;
+    FSR1 = fsr1;
+}
+
+#endif //USB_MEMCPY_PIC18
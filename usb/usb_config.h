@@ -33,7 +33,13 @@ please contact mla_licensing@microchip.com
 								// application related data.
 									
 #define USB_MAX_NUM_INT     	4   // For tracking Alternate Setting
-#define USB_MAX_EP_NUMBER	    3
+#if defined(USB_SIMULATION)
+    //EP4 is not in the descriptors, the simulated host checks
+    //  USBDeviceTransfer() on it
+    #define USB_MAX_EP_NUMBER	    4
+#else
+    #define USB_MAX_EP_NUMBER	    3
+#endif
 
 //Device descriptor - if these two definitions are not defined then
 //  a ROM USB_DEVICE_DESCRIPTOR variable by the exact name of device_dsc
@@ -164,6 +170,13 @@ please contact mla_licensing@microchip.com
 
 //#define USB_CDC_SUPPORT_HARDWARE_FLOW_CONTROL
 
+//Uncomment to give the CDC driver a transmit ring of this many bytes (a power
+//of two, up to 512).  CDCWrite() then queues data at any time, and
+//CDCTxService() keeps both ping-pong IN buffers loaded from the ring.  The
+//bridge sends the events bound for the CDC port through it instead of
+//putUSBUSART().
+//#define CDC_TX_RING_SIZE                256
+
 //Define the logic level for the "active" state.  Setting is only relevant if
 //the respective function is enabled.  Allowed options are:
 //1 = active state logic level is Vdd
@@ -176,6 +189,87 @@ please contact mla_licensing@microchip.com
 
 //#define USB_CDC_SUPPORT_ABSTRACT_CONTROL_MANAGEMENT_CAPABILITIES_D2 //Send_Break command
 #define USB_CDC_SUPPORT_ABSTRACT_CONTROL_MANAGEMENT_CAPABILITIES_D1 //Set_Line_Coding, Set_Control_Line_State, Get_Line_Coding, and Serial_State commands
+
+/** MIDI BRIDGE ****************************************************/
+
+//Number of virtual cables (1 to 16, as a plain decimal number) of the MIDI
+//streaming interface.  Each cable gets its own pair of jacks in the
+//descriptors and its own queue in each direction of the bridge.
+#define BRIDGE_NUM_CABLES               1
+
+//Number of 4-byte USB-MIDI events buffered per cable in each direction of the
+//bridge.  Must be a power of two.  Each queue uses (4 * MIDI_QUEUE_SIZE) + 4
+//bytes of RAM, and there are 2 * (BRIDGE_NUM_CABLES + 1) queues (one per
+//cable and one for the realtime messages in each direction), so lower it when
+//using several cables.
+#define MIDI_QUEUE_SIZE                 32
+
+//Number of SOF frames (1 ms each) the first event waiting for the MIDI IN
+//endpoint may be held back, so that the events arriving meanwhile share the
+//same bulk packet.  The packet is sent earlier as soon as it is full.  1 sends
+//at the next frame, 0 disables coalescing.
+#define BRIDGE_MIDI_IN_FLUSH_FRAMES     1
+
+//Uncomment to send realtime messages (timing clock, start, stop...) to the
+//host right away instead of waiting for the BRIDGE_MIDI_IN_FLUSH_FRAMES deadline.
+#define BRIDGE_MIDI_IN_REALTIME_BYPASS
+
+//Uncomment to hand the CDC OUT packets made of whole event packets over to the
+//MIDI IN endpoint without copying them: the MIDI IN BDT is pointed at the CDC
+//OUT buffer, which is given back to the CDC endpoint once the host has read
+//it.  Packets are still copied while other events wait for the MIDI IN
+//endpoint.  Not available with BRIDGE_CDC_RAW_MIDI.
+//#define BRIDGE_ZERO_COPY
+
+//Uncomment to forward the traffic from the transfer complete callbacks the
+//applications register with USBDeviceSetTransferCallback(), called by
+//USBDeviceTasks(), rather than from the application tasks of the main
+//loop: a packet received on one side is queued, and the other side loaded,
+//as soon as the transaction completes, and an IN endpoint is loaded again
+//as soon as it gets free.  With USB_INTERRUPT the bridge then runs in the
+//interrupt, and the main loop does not poll the endpoints anymore.
+//#define BRIDGE_TRANSFER_EVENTS
+
+//Uncomment to run the application tasks from a scheduler (see scheduler.h)
+//rather than on every pass of the main loop: a task only runs once a USB
+//transfer, a SOF deadline or a button edge gave it work, and the CPU idles
+//until the next interrupt otherwise.  The run count and longest run of each
+//task are read with the VENDOR_REQUEST_SCHEDULER_READ request.  Needs
+//USB_INTERRUPT.
+//#define BRIDGE_SCHEDULER
+
+//Uncomment to measure the instruction cycles spent on each packet crossing
+//the bridge, in USBDeviceTasks() and in the application tasks with Timer1
+//(see cycle_counter.h).  The results are kept in cycleCounterStats[] and
+//read with the VENDOR_REQUEST_CYCLE_COUNTER_READ request.
+//#define BRIDGE_CYCLE_COUNT
+
+//Uncomment to time every event from the moment it is queued on one side of
+//the bridge until it is taken out on the other side, using the SOF frame
+//number and Timer1 (see residency.h).  The statistics of each direction are
+//read with the VENDOR_REQUEST_RESIDENCY_READ request.  Each queued event takes
+//3 more bytes of RAM.
+//#define BRIDGE_RESIDENCY
+
+//Bridge mode of the CDC port.  Uncomment to exchange a plain MIDI byte stream
+//in both directions, as a serial MIDI interface would: received bytes are
+//parsed (running status, interleaved realtime bytes and SysEx are supported)
+//and sent events are encoded with running status and without padding bytes.
+//Otherwise the CDC port passes the 4-byte USB-MIDI event packets through.
+//#define BRIDGE_CDC_RAW_MIDI
+
+//Uncomment to parse the data received on the CDC port straight from the CDC
+//OUT endpoint buffers with CDCPeek() and CDCConsume(), instead of copying
+//each packet with getsUSBUSART() first.  A buffer goes back to the endpoint
+//as soon as its last byte has been queued.
+//#define BRIDGE_CDC_OUT_PEEK
+
+//Uncomment to send the events bound for the CDC port with CDCSendDirect(),
+//straight from a two packet buffer in USB RAM the events are encoded into,
+//instead of copying them into the CDC IN buffers with putUSBUSART().  Not
+//available with CDC_TX_RING_SIZE.
+//#define BRIDGE_CDC_IN_DIRECT
+
 /** DEFINITIONS ****************************************************/
 
 /** DEFINITIONS ****************************************************/
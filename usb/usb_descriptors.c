@@ -144,6 +144,83 @@ state according to the definition in the USB specification.
 #include "usb_device_audio.h"
 #include "usb_device_cdc.h"
 
+/** MIDI JACKS *****************************************************/
+/* Each virtual cable of the MIDI streaming interface has an embedded and an
+ * external MIDI IN jack, and an embedded and an external MIDI OUT jack.  The
+ * jacks of cable n (counting from 0) use the IDs 4n+1 to 4n+4. */
+#define MIDI_JACK_EMBEDDED_IN       1
+#define MIDI_JACK_EXTERNAL_IN       2
+#define MIDI_JACK_EMBEDDED_OUT      3
+#define MIDI_JACK_EXTERNAL_OUT      4
+
+#define MIDI_JACK_ID(cable, jack)   (((cable) * 4) + (jack))
+
+#define MIDI_CABLE_JACKS(cable, arg)                                        \
+    /* MIDI Adapter MIDI IN Jack Descriptor (Embedded) */                   \
+    0x06,                          /*bLength*/                              \
+    CS_INTERFACE,                  /*bDescriptorType - CS_INTERFACE*/       \
+    INPUT_TERMINAL,                /*bDescriptorSubtype - MIDI_IN_JACK*/    \
+    0x01,                          /*bJackType - EMBEDDED*/                 \
+    MIDI_JACK_ID(cable, MIDI_JACK_EMBEDDED_IN), /*bJackID*/                 \
+    0x00,                          /*iJack*/                                \
+                                                                            \
+    /* MIDI Adapter MIDI IN Jack Descriptor (External) */                   \
+    0x06,                          /*bLength*/                              \
+    CS_INTERFACE,                  /*bDescriptorType - CS_INTERFACE*/       \
+    INPUT_TERMINAL,                /*bDescriptorSubtype - MIDI_IN_JACK*/    \
+    0x02,                          /*bJackType - EXTERNAL*/                 \
+    MIDI_JACK_ID(cable, MIDI_JACK_EXTERNAL_IN), /*bJackID*/                 \
+    0x00,                          /*iJack*/                                \
+                                                                            \
+    /* MIDI Adapter MIDI OUT Jack Descriptor (Embedded) */                  \
+    0x09,                          /*bLength*/                              \
+    CS_INTERFACE,                  /*bDescriptorType - CS_INTERFACE*/       \
+    OUTPUT_TERMINAL,               /*bDescriptorSubtype - MIDI_OUT_JACK*/   \
+    0x01,                          /*bJackType - EMBEDDED*/                 \
+    MIDI_JACK_ID(cable, MIDI_JACK_EMBEDDED_OUT), /*bJackID*/                \
+    0x01,                          /*bNrInputPins*/                         \
+    MIDI_JACK_ID(cable, MIDI_JACK_EXTERNAL_IN), /*BaSourceID(1)*/           \
+    0x01,                          /*BaSourcePin(1)*/                       \
+    0x00,                          /*iJack*/                                \
+                                                                            \
+    /* MIDI Adapter MIDI OUT Jack Descriptor (External) */                  \
+    0x09,                          /*bLength*/                              \
+    CS_INTERFACE,                  /*bDescriptorType - CS_INTERFACE*/       \
+    OUTPUT_TERMINAL,               /*bDescriptorSubtype - MIDI_OUT_JACK*/   \
+    0x02,                          /*bJackType - EXTERNAL*/                 \
+    MIDI_JACK_ID(cable, MIDI_JACK_EXTERNAL_OUT), /*bJackID*/                \
+    0x01,                          /*bNrInputPins*/                         \
+    MIDI_JACK_ID(cable, MIDI_JACK_EMBEDDED_IN), /*BaSourceID(1)*/           \
+    0x01,                          /*BaSourcePin(1)*/                       \
+    0x00                           /*iJack*/
+
+/* MIDI_FOR_EACH_CABLE(m, arg) expands to m(0, arg), m(1, arg), ... up to
+ * m(BRIDGE_NUM_CABLES - 1, arg) */
+#define MIDI_CABLES_1(m, arg)   m(0, arg)
+#define MIDI_CABLES_2(m, arg)   MIDI_CABLES_1(m, arg), m(1, arg)
+#define MIDI_CABLES_3(m, arg)   MIDI_CABLES_2(m, arg), m(2, arg)
+#define MIDI_CABLES_4(m, arg)   MIDI_CABLES_3(m, arg), m(3, arg)
+#define MIDI_CABLES_5(m, arg)   MIDI_CABLES_4(m, arg), m(4, arg)
+#define MIDI_CABLES_6(m, arg)   MIDI_CABLES_5(m, arg), m(5, arg)
+#define MIDI_CABLES_7(m, arg)   MIDI_CABLES_6(m, arg), m(6, arg)
+#define MIDI_CABLES_8(m, arg)   MIDI_CABLES_7(m, arg), m(7, arg)
+#define MIDI_CABLES_9(m, arg)   MIDI_CABLES_8(m, arg), m(8, arg)
+#define MIDI_CABLES_10(m, arg)  MIDI_CABLES_9(m, arg), m(9, arg)
+#define MIDI_CABLES_11(m, arg)  MIDI_CABLES_10(m, arg), m(10, arg)
+#define MIDI_CABLES_12(m, arg)  MIDI_CABLES_11(m, arg), m(11, arg)
+#define MIDI_CABLES_13(m, arg)  MIDI_CABLES_12(m, arg), m(12, arg)
+#define MIDI_CABLES_14(m, arg)  MIDI_CABLES_13(m, arg), m(13, arg)
+#define MIDI_CABLES_15(m, arg)  MIDI_CABLES_14(m, arg), m(14, arg)
+#define MIDI_CABLES_16(m, arg)  MIDI_CABLES_15(m, arg), m(15, arg)
+
+#define MIDI_CABLES_CAT(a, b)               a##b
+#define MIDI_CABLES_N(n)                    MIDI_CABLES_CAT(MIDI_CABLES_, n)
+#define MIDI_FOR_EACH_CABLE(m, arg)         MIDI_CABLES_N(BRIDGE_NUM_CABLES)(m, arg)
+
+/* Jacks (30 bytes) and endpoint jack associations (2 bytes) of each cable */
+#define MIDI_MS_TOTAL_LENGTH                (33 + (32 * BRIDGE_NUM_CABLES))
+#define CONFIG_DESC_TOTAL_LENGTH            (135 + (32 * BRIDGE_NUM_CABLES))
+
 /** CONSTANTS ******************************************************/
 #if defined(COMPILER_MPLAB_C18)
 #pragma romdata
@@ -174,7 +251,7 @@ const uint8_t configDescriptor1[]={
     /* Configuration Descriptor */
     0x09,//sizeof(USB_CFG_DSC),    // Size of this descriptor in bytes
     USB_DESCRIPTOR_CONFIGURATION,  // CONFIGURATION descriptor type
-    0xA7,0x00,                     // Total length of data for this cfg
+    CONFIG_DESC_TOTAL_LENGTH & 0xFF,CONFIG_DESC_TOTAL_LENGTH >> 8, // Total length of data for this cfg
     0x04,                          // Number of interfaces in this cfg
     0x01,                          // Index value of this configuration
     0x00,                          // Configuration string index
@@ -217,45 +294,10 @@ const uint8_t configDescriptor1[]={
     CS_INTERFACE,                  //bDescriptorType - CS_INTERFACE
     HEADER,                        //bDescriptorSubtype - MS_HEADER
     0x00,0x01,                     //BcdADC
-    0x41,0x00,                     //wTotalLength
-
-    /* MIDI Adapter MIDI IN Jack Descriptor (Embedded) */
-    0x06,                          //bLength
-    CS_INTERFACE,                  //bDescriptorType - CS_INTERFACE
-    INPUT_TERMINAL,                //bDescriptorSubtype - MIDI_IN_JACK
-    0x01,                          //bJackType - EMBEDDED
-    0x01,                          //bJackID
-    0x00,                          //iJack
-
-    /* MIDI Adapter MIDI IN Jack Descriptor (External) */
-    0x06,                          //bLength
-    CS_INTERFACE,                  //bDescriptorType - CS_INTERFACE
-    INPUT_TERMINAL,                //bDescriptorSubtype - MIDI_IN_JACK
-    0x02,                          //bJackType - EXTERNAL
-    0x02,                          //bJackID
-    0x00,                          //iJack
+    MIDI_MS_TOTAL_LENGTH & 0xFF,MIDI_MS_TOTAL_LENGTH >> 8, //wTotalLength
 
-    /* MIDI Adapter MIDI OUT Jack Descriptor (Embedded) */
-    0x09,                          //bLength
-    CS_INTERFACE,                  //bDescriptorType - CS_INTERFACE
-    OUTPUT_TERMINAL,               //bDescriptorSubtype - MIDI_OUT_JACK
-    0x01,                          //bJackType - EMBEDDED
-    0x03,                          //bJackID
-    0x01,                          //bNrInputPins
-    0x02,                          //BaSourceID(1)
-    0x01,                          //BaSourcePin(1)
-    0x00,                          //iJack
-
-    /* MIDI Adapter MIDI OUT Jack Descriptor (External) */
-    0x09,                          //bLength
-    CS_INTERFACE,                  //bDescriptorType - CS_INTERFACE
-    OUTPUT_TERMINAL,               //bDescriptorSubtype - MIDI_OUT_JACK
-    0x02,                          //bJackType - EXTERNAL
-    0x04,                          //bJackID
-    0x01,                          //bNrInputPins
-    0x01,                          //BaSourceID(1)
-    0x01,                          //BaSourcePin(1)
-    0x00,                          //iJack
+    /* MIDI Adapter MIDI IN/OUT Jack Descriptors of every cable */
+    MIDI_FOR_EACH_CABLE(MIDI_CABLE_JACKS, 0),
 
     /* MIDI Adapter Standard Bulk OUT Endpoint Descriptor */
     0x09,                          //bLength
@@ -268,11 +310,11 @@ const uint8_t configDescriptor1[]={
     0x00,                          //bSynchAddress
 
     /* MIDI Adapter Class-specific Bulk OUT Endpoint Descriptor */
-    0x05,                          //bLength
+    4 + BRIDGE_NUM_CABLES,         //bLength
     CS_ENDPOINT,                   //bDescriptorType - CS_ENDPOINT
     EP_GENERAL,                    //bDescriptorSubtype - MS_GENERAL
-    0x01,                          //bNumEmbMIDIJack
-    0x01,                          //BaAssocJackID(1)
+    BRIDGE_NUM_CABLES,             //bNumEmbMIDIJack
+    MIDI_FOR_EACH_CABLE(MIDI_JACK_ID, MIDI_JACK_EMBEDDED_IN), //BaAssocJackID(1..n)
 
     /* MIDI Adapter Standard Bulk IN Endpoint Descriptor */
     0x09,                          //bLength
@@ -285,11 +327,11 @@ const uint8_t configDescriptor1[]={
     0x00,                          //bSynchAddress
 
     /* MIDI Adapter Class-specific Bulk IN Endpoint Descriptor */
-    0x05,                          //bLength
+    4 + BRIDGE_NUM_CABLES,         //bLength
     CS_ENDPOINT,                   //bDescriptorType - CS_ENDPOINT
     EP_GENERAL,                    //bDescriptorSubtype - MS_GENERAL
-    0x01,                          //bNumEmbMIDIJack
-    0x03,                          //BaAssocJackID(1)
+    BRIDGE_NUM_CABLES,             //bNumEmbMIDIJack
+    MIDI_FOR_EACH_CABLE(MIDI_JACK_ID, MIDI_JACK_EMBEDDED_OUT), //BaAssocJackID(1..n)
             
     /* Interface Association Descriptor - IAD */
     0x08,                          // bLength
@@ -22,7 +22,11 @@ please contact mla_licensing@microchip.com
 
 #include "app_device_audio_midi.h"
 #include "app_device_cdc_basic.h"
+#include "app_device_vendor.h"
 #include "app_led_usb_status.h"
+#include "residency.h"
+#include "bridge_stats.h"
+#include "scheduler.h"
 
 #include "usb_device.h"
 #include "usb_device_cdc.h"
@@ -34,6 +38,9 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
     switch( (int) event )
     {
         case EVENT_TRANSFER:
+            /* Data moved on an endpoint without a transfer complete
+             * callback, either side of the bridge may have work. */
+            SCHEDULER_SetAllReady();
             break;
 
         case EVENT_SOF:
@@ -41,16 +48,31 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
              * the LED update function here. */
             APP_LEDUpdateUSBStatus();
             APP_DeviceAudioMIDISOFHandler();
+            RESIDENCY_StartOfFrame();
+
+            #if defined(BRIDGE_TRANSFER_EVENTS)
+                /* The MIDI IN deadlines expire on frame boundaries, and the
+                 * CDC notifications are sent from CDCTxService() */
+                if( (USBGetDeviceState() == CONFIGURED_STATE) &&
+                    (USBIsDeviceSuspended() == false) )
+                {
+                    APP_DeviceAudioMIDISend();
+                    CDCTxService();
+                }
+            #endif
             break;
 
         case EVENT_SUSPEND:
             /* Update the LED status for the suspend event. */
             APP_LEDUpdateUSBStatus();
+            bridgeStats.suspends++;
             break;
 
         case EVENT_RESUME:
             /* Update the LED status for the resume event. */
             APP_LEDUpdateUSBStatus();
+            bridgeStats.resumes++;
+            SCHEDULER_SetAllReady();
             break;
 
         case EVENT_CONFIGURED:
@@ -60,6 +82,7 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
             
             CDCInitEP();
             APP_DeviceCDCBasicDemoInitialize();
+            SCHEDULER_SetAllReady();
             break;
 
         case EVENT_SET_DESCRIPTOR:
@@ -69,9 +92,14 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
             /* We have received a non-standard USB request.  The HID driver
              * needs to check to see if the request was for it. */
             USBCheckCDCRequest();
+            APP_DeviceVendorCheckRequest();
             break;
 
         case EVENT_BUS_ERROR:
+            /* The error flags are still set, they are cleared by the stack
+             * once this event has been handled. */
+            bridgeStats.busErrors++;
+            bridgeStats.busErrorFlags |= U1EIR;
             break;
 
         case EVENT_TRANSFER_TERMINATED: